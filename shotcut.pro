@@ -2,3 +2,8 @@ TEMPLATE = subdirs
 SUBDIRS = CuteLogger mvcp src
 cache()
 src.depends = CuteLogger mvcp
+# The tests are only built when asked for: qmake CONFIG+=tests
+CONFIG(tests) {
+    SUBDIRS += tests
+    tests.depends = CuteLogger mvcp
+}
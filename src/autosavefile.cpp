@@ -23,18 +23,41 @@
 
 #include <QtCore/QDir>
 #include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <Mlt.h>
+#include <Logger.h>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <stdio.h>
+#endif
 
 static const QLatin1String subdir("/autosave");
 static const QLatin1String extension(".mlt");
+static const quint32 kJournalMagic = 0x534a4e4c; // "SJNL"
+static const quint32 kJournalVersion = 1;
+static const quint32 kJournalTrackEntry = 1;
 
 static QString hashName(const QString &name)
 {
     return QString::fromLatin1(QCryptographicHash::hash(name.toUtf8(), QCryptographicHash::Md5).toHex());
 }
 
+static bool replaceFile(const QString& from, const QString& to)
+{
+#ifdef Q_OS_WIN
+    return MoveFileExW((LPCWSTR) QDir::toNativeSeparators(from).utf16(),
+                       (LPCWSTR) QDir::toNativeSeparators(to).utf16(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    return ::rename(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0;
+#endif
+}
+
 AutoSaveFile::AutoSaveFile(const QString &filename, QObject *parent)
     : QFile(parent)
     , m_managedFileNameChanged(false)
+    , m_hasSnapshot(false)
 {
     changeManagedFile(filename);
 }
@@ -42,15 +65,23 @@ AutoSaveFile::AutoSaveFile(const QString &filename, QObject *parent)
 AutoSaveFile::~AutoSaveFile()
 {
     if (!fileName().isEmpty())
-        remove();
+        removeFiles();
 }
 
 void AutoSaveFile::changeManagedFile(const QString &filename)
 {
     if (!fileName().isEmpty())
-        remove();
+        removeFiles();
     m_managedFile = filename;
     m_managedFileNameChanged = true;
+    m_hasSnapshot = false;
+}
+
+void AutoSaveFile::removeFiles()
+{
+    remove();
+    QFile::remove(journalFileName());
+    QFile::remove(snapshotFileName());
 }
 
 bool AutoSaveFile::open(OpenMode openmode)
@@ -82,6 +113,7 @@ AutoSaveFile* AutoSaveFile::getFile(const QString &filename)
         result = new AutoSaveFile(filename);
         result->setFileName(info.filePath());
         result->m_managedFileNameChanged = false;
+        result->m_hasSnapshot = true;
     }
 
     return result;
@@ -91,3 +123,102 @@ QString AutoSaveFile::path()
 {
     return Settings.appDataLocation() + subdir;
 }
+
+bool AutoSaveFile::commitSnapshot()
+{
+    // The file may not be replaced while it is open on Windows.
+    close();
+    if (!replaceFile(snapshotFileName(), fileName())) {
+        LOG_ERROR() << "failed to replace" << fileName() << "with" << snapshotFileName();
+        QFile::remove(snapshotFileName());
+        return false;
+    }
+    QFile::remove(journalFileName());
+    m_hasSnapshot = true;
+    return true;
+}
+
+bool AutoSaveFile::appendTrack(int mltIndex, const QByteArray& xml)
+{
+    if (!m_hasSnapshot)
+        return false;
+    QFile journal(journalFileName());
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Append))
+        return false;
+    QDataStream stream(&journal);
+    stream.setVersion(QDataStream::Qt_5_0);
+    if (journal.size() == 0)
+        stream << kJournalMagic << kJournalVersion;
+    stream << kJournalTrackEntry << qint32(mltIndex) << xml
+           << quint16(qChecksum(xml.constData(), xml.size()));
+    return stream.status() == QDataStream::Ok && journal.flush();
+}
+
+QMap<int, QByteArray> AutoSaveFile::readJournal() const
+{
+    QMap<int, QByteArray> result;
+    QFile journal(journalFileName());
+    if (!journal.open(QIODevice::ReadOnly))
+        return result;
+    QDataStream stream(&journal);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0, version = 0;
+    stream >> magic >> version;
+    if (magic != kJournalMagic || version != kJournalVersion) {
+        LOG_WARNING() << "invalid auto-save journal" << journalFileName();
+        return result;
+    }
+    while (!stream.atEnd()) {
+        quint32 type = 0;
+        qint32 mltIndex = -1;
+        QByteArray xml;
+        quint16 checksum = 0;
+        stream >> type >> mltIndex >> xml >> checksum;
+        // The last entry is incomplete if the application crashed writing it.
+        if (stream.status() != QDataStream::Ok || type != kJournalTrackEntry
+                || checksum != qChecksum(xml.constData(), xml.size()))
+            break;
+        result[mltIndex] = xml;
+    }
+    return result;
+}
+
+bool AutoSaveFile::replayJournal()
+{
+    QMap<int, QByteArray> tracks = readJournal();
+    if (tracks.isEmpty())
+        return true;
+    LOG_INFO() << "replaying" << tracks.size() << "journaled tracks onto" << fileName();
+
+    Mlt::Profile profile;
+    Mlt::Producer producer(profile, "xml", fileName().toUtf8().constData());
+    if (!producer.is_valid())
+        return false;
+    // See MultitrackModel::load().
+    producer.set("mlt_type", "mlt_producer");
+    producer.set("resource", "<tractor>");
+    Mlt::Tractor tractor(producer);
+    if (!tractor.is_valid())
+        return false;
+
+    QMapIterator<int, QByteArray> i(tracks);
+    while (i.hasNext()) {
+        i.next();
+        Mlt::Producer track(profile, "xml-string", i.value().constData());
+        if (i.key() < 0 || i.key() >= tractor.count() || !track.is_valid()) {
+            LOG_WARNING() << "skipping journaled track" << i.key();
+            continue;
+        }
+        tractor.set_track(track, i.key());
+    }
+
+    {
+        Mlt::Consumer consumer(profile, "xml", snapshotFileName().toUtf8().constData());
+        consumer.set("time_format", "clock");
+        consumer.set("no_meta", 1);
+        consumer.set("store", "shotcut");
+        consumer.connect(tractor);
+        consumer.start();
+    }
+    return commitSnapshot();
+}
@@ -23,6 +23,20 @@
 
 #include <QtCore/QFile>
 #include <QtCore/QString>
+#include <QtCore/QMap>
+#include <QtCore/QByteArray>
+
+/*!
+  \class AutoSaveFile
+  \brief The AutoSaveFile holds the crash recovery state of a project.
+
+  The state is a full snapshot of the project in the auto-save file plus a
+  journal next to it. Each journal entry is the XML of one timeline track as
+  it was after an edit; entries for the same track supersede each other and
+  replace that track of the snapshot when it is recovered. Snapshots are
+  first written to snapshotFileName() and then moved over the auto-save file
+  atomically by commitSnapshot(), which also empties the journal.
+*/
 
 class AutoSaveFile : public QFile
 {
@@ -38,10 +52,35 @@ public:
     static AutoSaveFile* getFile(const QString &filename);
     static QString path();
 
+    //! Returns the temporary file to which a new snapshot is written.
+    QString snapshotFileName() const { return fileName() + ".tmp"; }
+    QString journalFileName() const { return fileName() + ".journal"; }
+
+    //! Returns whether the auto-save file holds a snapshot to journal against.
+    bool hasSnapshot() const { return m_hasSnapshot; }
+
+    //! Replaces the auto-save file with snapshotFileName() and clears the journal.
+    bool commitSnapshot();
+
+    //! Appends the XML of the track at tractor index \a mltIndex to the journal.
+    bool appendTrack(int mltIndex, const QByteArray& xml);
+
+    //! Returns the latest journaled XML of every track keyed by tractor index.
+    QMap<int, QByteArray> readJournal() const;
+
+    /*!
+      Applies the journal to the snapshot and commits the result as a new
+      snapshot. Returns false if the snapshot could not be updated.
+    */
+    bool replayJournal();
+
 private:
     Q_DISABLE_COPY(AutoSaveFile)
+    void removeFiles();
+
     QString m_managedFile;
     bool m_managedFileNameChanged;
+    bool m_hasSnapshot;
 };
 
 #endif // AUTOSAVEFILE_H
@@ -28,6 +28,18 @@ AppendCommand::AppendCommand(PlaylistModel& model, const QString& xml, QUndoComm
     : QUndoCommand(parent)
     , m_model(model)
     , m_xml(xml)
+    , m_in(-1)
+    , m_out(-1)
+{
+    setText(QObject::tr("Append playlist item %1").arg(m_model.rowCount() + 1));
+}
+
+AppendCommand::AppendCommand(PlaylistModel& model, Mlt::Producer& producer, QUndoCommand *parent)
+    : QUndoCommand(parent)
+    , m_model(model)
+    , m_producer(producer)
+    , m_in(producer.get_in())
+    , m_out(producer.get_out())
 {
     setText(QObject::tr("Append playlist item %1").arg(m_model.rowCount() + 1));
 }
@@ -35,8 +47,15 @@ AppendCommand::AppendCommand(PlaylistModel& model, const QString& xml, QUndoComm
 void AppendCommand::redo()
 {
     LOG_DEBUG() << "";
-    Mlt::Producer producer(MLT.profile(), "xml-string", m_xml.toUtf8().constData());
-    m_model.append(producer);
+    if (m_producer.is_valid()) {
+        // PlaylistModel::append() opens the producer to its full length, so
+        // restore the in and out points it had when the command was made.
+        m_producer.set_in_and_out(m_in, m_out);
+        m_model.append(m_producer);
+    } else {
+        Mlt::Producer producer(MLT.profile(), "xml-string", m_xml.toUtf8().constData());
+        m_model.append(producer);
+    }
 }
 
 void AppendCommand::undo()
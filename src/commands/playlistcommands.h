@@ -30,11 +30,15 @@ class AppendCommand : public QUndoCommand
 {
 public:
     AppendCommand(PlaylistModel& model, const QString& xml, QUndoCommand * parent = 0);
+    AppendCommand(PlaylistModel& model, Mlt::Producer& producer, QUndoCommand * parent = 0);
     void redo();
     void undo();
 private:
     PlaylistModel& m_model;
     QString m_xml;
+    Mlt::Producer m_producer;
+    int m_in;
+    int m_out;
 };
 
 class InsertCommand : public QUndoCommand
@@ -19,6 +19,7 @@
 #include "timelinecommands.h"
 #include "mltcontroller.h"
 #include "shotcut_mlt_properties.h"
+#include "settings.h"
 #include <Logger.h>
 #include <QMetaObject>
 
@@ -32,6 +33,7 @@ AppendCommand::AppendCommand(MultitrackModel &model, int trackIndex, const QStri
     , m_undoHelper(m_model)
 {
     setText(QObject::tr("Append to track"));
+    m_undoHelper.setTracks(QList<int>() << m_trackIndex);
 }
 
 
@@ -65,6 +67,11 @@ InsertCommand::InsertCommand(MultitrackModel &model, int trackIndex,
 void InsertCommand::redo()
 {
     LOG_DEBUG() << "trackIndex" << m_trackIndex << "position" << m_position;
+    // Rippling all tracks may also change the other tracks.
+    if (Settings.timelineRippleAllTracks())
+        m_undoHelper.setTracks(QList<int>());
+    else
+        m_undoHelper.setTracks(QList<int>() << m_trackIndex);
     m_undoHelper.recordBeforeState();
     Mlt::Producer clip(MLT.profile(), "xml-string", m_xml.toUtf8().constData());
     m_model.insertClip(m_trackIndex, clip, m_position);
@@ -87,6 +94,7 @@ OverwriteCommand::OverwriteCommand(MultitrackModel &model, int trackIndex,
     , m_undoHelper(m_model)
 {
     setText(QObject::tr("Overwrite onto track"));
+    m_undoHelper.setTracks(QList<int>() << m_trackIndex);
 }
 
 void OverwriteCommand::redo()
@@ -114,6 +122,7 @@ LiftCommand::LiftCommand(MultitrackModel &model, int trackIndex,
     , m_undoHelper(m_model)
 {
     setText(QObject::tr("Lift from track"));
+    m_undoHelper.setTracks(QList<int>() << m_trackIndex);
 }
 
 void LiftCommand::redo()
@@ -145,6 +154,11 @@ RemoveCommand::RemoveCommand(MultitrackModel &model, int trackIndex,
 void RemoveCommand::redo()
 {
     LOG_DEBUG() << "trackIndex" << m_trackIndex << "clipIndex" << m_clipIndex;
+    // Rippling all tracks may also change the other tracks.
+    if (Settings.timelineRippleAllTracks())
+        m_undoHelper.setTracks(QList<int>());
+    else
+        m_undoHelper.setTracks(QList<int>() << m_trackIndex);
     m_undoHelper.recordBeforeState();
     m_model.removeClip(m_trackIndex, m_clipIndex);
     m_undoHelper.recordAfterState();
@@ -304,6 +318,7 @@ MoveClipCommand::MoveClipCommand(MultitrackModel &model, int fromTrackIndex, int
     , m_undoHelper(m_model)
 {
     setText(QObject::tr("Move clip"));
+    m_undoHelper.setTracks(QList<int>() << m_fromTrackIndex << m_toTrackIndex);
 }
 
 void MoveClipCommand::redo()
@@ -338,6 +353,8 @@ void TrimClipInCommand::redo()
         LOG_DEBUG() << "trackIndex" << m_trackIndex << "clipIndex" << m_clipIndex << "delta" << m_delta;
         m_undoHelper.reset(new UndoHelper(m_model));
         if (!m_ripple) m_undoHelper->setHints(UndoHelper::SkipXML);
+        if (!m_ripple || !Settings.timelineRippleAllTracks())
+            m_undoHelper->setTracks(QList<int>() << m_trackIndex);
         m_undoHelper->recordBeforeState();
         m_model.trimClipIn(m_trackIndex, m_clipIndex, m_delta, m_ripple);
         m_undoHelper->recordAfterState();
@@ -385,6 +402,8 @@ void TrimClipOutCommand::redo()
         m_undoHelper.reset(new UndoHelper(m_model));
         if (!m_ripple)
             m_undoHelper->setHints(UndoHelper::SkipXML);
+        if (!m_ripple || !Settings.timelineRippleAllTracks())
+            m_undoHelper->setTracks(QList<int>() << m_trackIndex);
         m_undoHelper->recordBeforeState();
         m_clipIndex = m_model.trimClipOut(m_trackIndex, m_clipIndex, m_delta, m_ripple);
         m_undoHelper->recordAfterState();
@@ -510,6 +529,7 @@ AddTransitionCommand::AddTransitionCommand(MultitrackModel &model, int trackInde
     , m_undoHelper(model)
 {
     setText(QObject::tr("Add transition"));
+    m_undoHelper.setTracks(QList<int>() << m_trackIndex);
 }
 
 void AddTransitionCommand::redo()
@@ -910,6 +930,7 @@ UpdateCommand::UpdateCommand(TimelineDock& timeline, int trackIndex, int clipInd
     , m_undoHelper(*timeline.model())
 {
     setText(QObject::tr("Change clip properties"));
+    m_undoHelper.setTracks(QList<int>() << m_trackIndex);
     m_undoHelper.recordBeforeState();
 }
 
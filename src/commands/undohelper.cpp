@@ -21,8 +21,13 @@
 #include "models/audiolevelstask.h"
 #include "shotcut_mlt_properties.h"
 #include <Logger.h>
+#include <MltFilter.h>
+#include <MltPlaylist.h>
+#include <MltTractor.h>
 #include <QScopedPointer>
 #include <QUuid>
+#include <QCache>
+#include <QCryptographicHash>
 
 #ifdef UNDOHELPER_DEBUG
 #define UNDOLOG LOG_DEBUG()
@@ -30,6 +35,118 @@
 #define UNDOLOG if (false) LOG_DEBUG()
 #endif
 
+/* Serializing a clip to XML is by far the most expensive part of recording
+ * the timeline state. The XML of each clip is therefore kept along with a
+ * hash of the properties of the clip and of every service nested in it, and
+ * it is only serialized again when that hash changes. */
+struct XmlSnapshot
+{
+    QByteArray hash;
+    QString xml;
+    XmlSnapshot(const QByteArray& hash, const QString& xml)
+        : hash(hash)
+        , xml(xml)
+    {}
+};
+
+static const int kXmlCacheBytes = 32 * 1024 * 1024;
+static QCache<QUuid, XmlSnapshot> s_xmlCache(kXmlCacheBytes);
+
+static void appendProperties(QByteArray& snapshot, Mlt::Properties& properties)
+{
+    int n = properties.count();
+    for (int i = 0; i < n; ++i) {
+        const char* name = properties.get_name(i);
+        // Properties with a leading underscore are private and not serialized.
+        if (!name || name[0] == '_')
+            continue;
+        const char* value = properties.get(i);
+        if (!value)
+            continue;
+        snapshot.append(name).append('\0').append(value).append('\0');
+    }
+}
+
+static const int kMaxServiceDepth = 32;
+
+static void appendFilters(QByteArray& snapshot, Mlt::Service& service)
+{
+    int n = service.filter_count();
+    for (int i = 0; i < n; ++i) {
+        QScopedPointer<Mlt::Filter> filter(service.filter(i));
+        if (filter && filter->is_valid()) {
+            snapshot.append('\1');
+            appendProperties(snapshot, *filter);
+        }
+    }
+}
+
+/* Appends the producer and everything nested in it: the tracks and
+ * transitions of a tractor (e.g. a transition or an xml producer), the
+ * entries of a playlist and the parent of a cut. */
+static void appendProducer(QByteArray& snapshot, Mlt::Producer& producer, int depth)
+{
+    appendProperties(snapshot, producer);
+    appendFilters(snapshot, producer);
+    if (depth >= kMaxServiceDepth)
+        return;
+
+    if (producer.type() == tractor_type) {
+        Mlt::Tractor tractor(producer);
+        int n = tractor.count();
+        for (int i = 0; i < n; ++i) {
+            QScopedPointer<Mlt::Producer> track(tractor.track(i));
+            if (track && track->is_valid()) {
+                snapshot.append('\2');
+                appendProducer(snapshot, *track, depth + 1);
+            }
+        }
+        QScopedPointer<Mlt::Service> service(tractor.producer());
+        while (service && service->is_valid()) {
+            if (service->type() == transition_type) {
+                snapshot.append('\3');
+                appendProperties(snapshot, *service);
+            }
+            service.reset(service->producer());
+        }
+    } else if (producer.type() == playlist_type) {
+        Mlt::Playlist playlist(producer);
+        int n = playlist.count();
+        for (int i = 0; i < n; ++i) {
+            QScopedPointer<Mlt::Producer> clip(playlist.get_clip(i));
+            if (clip && clip->is_valid()) {
+                snapshot.append('\2');
+                appendProducer(snapshot, *clip, depth + 1);
+            }
+        }
+    }
+
+    if (producer.is_cut()) {
+        Mlt::Producer parent(producer.parent());
+        if (parent.is_valid() && parent.get_producer() != producer.get_producer()) {
+            snapshot.append('\4');
+            appendProducer(snapshot, parent, depth + 1);
+        }
+    }
+}
+
+static QByteArray contentHash(Mlt::Producer& producer)
+{
+    QByteArray snapshot;
+    appendProducer(snapshot, producer, 0);
+    return QCryptographicHash::hash(snapshot, QCryptographicHash::Md5);
+}
+
+static QString snapshotXml(const QUuid& uid, Mlt::Producer& producer, const QByteArray& hash)
+{
+    XmlSnapshot* cached = s_xmlCache.object(uid);
+    if (cached && cached->hash == hash)
+        return cached->xml;
+    QString xml = MLT.XML(&producer);
+    s_xmlCache.insert(uid, new XmlSnapshot(hash, xml), xml.size() * sizeof(QChar));
+    return xml;
+}
+
 UndoHelper::UndoHelper(MultitrackModel& model)
     : m_model(model)
     , m_hints(NoHints)
@@ -44,7 +161,7 @@ void UndoHelper::recordBeforeState()
     m_state.clear();
     m_clipsAdded.clear();
     m_insertedOrder.clear();
-    for (int i = 0; i < m_model.trackList().count(); ++i)
+    foreach (int i, recordedTracks())
     {
         int mltIndex = m_model.trackList()[i].mlt_index;
         QScopedPointer<Mlt::Producer> trackProducer(m_model.tractor()->track(mltIndex));
@@ -55,15 +172,18 @@ void UndoHelper::recordBeforeState()
             QUuid uid = MLT.ensureHasUuid(*clip);
             m_insertedOrder << uid;
             Info& info = m_state[uid];
-            if (!(m_hints & SkipXML))
-                info.xml = MLT.XML(&clip->parent());
+            info.isBlank = playlist.is_blank(j);
+            /* Blanks are restored from their length alone. */
+            if (!(m_hints & SkipXML) && !info.isBlank) {
+                info.hash = contentHash(clip->parent());
+                info.xml = snapshotXml(uid, clip->parent(), info.hash);
+            }
             Mlt::ClipInfo clipInfo;
             playlist.clip_info(j, &clipInfo);
             info.frame_in = clipInfo.frame_in;
             info.frame_out = clipInfo.frame_out;
             info.oldTrackIndex = i;
             info.oldClipIndex = j;
-            info.isBlank = playlist.is_blank(j);
         }
     }
 }
@@ -75,7 +195,7 @@ void UndoHelper::recordAfterState()
 #endif
     QList<QUuid> clipsRemoved = m_state.keys();
     m_clipsAdded.clear();
-    for (int i = 0; i < m_model.trackList().count(); ++i)
+    foreach (int i, recordedTracks())
     {
         int mltIndex = m_model.trackList()[i].mlt_index;
         QScopedPointer<Mlt::Producer> trackProducer(m_model.tractor()->track(mltIndex));
@@ -105,9 +225,9 @@ void UndoHelper::recordAfterState()
                     info.changes |= Moved;
                 }
 
-                if (!(m_hints & SkipXML)) {
-                    QString newXml = MLT.XML(&clip->parent());
-                    if (info.xml != newXml) {
+                /* Comparing the content hashes avoids serializing the clip. */
+                if (!(m_hints & SkipXML) && !info.isBlank) {
+                    if (info.hash != contentHash(clip->parent())) {
                         UNDOLOG << "Modified xml:" << uid;
                         info.changes |= XMLModified;
                     }
@@ -217,8 +337,8 @@ void UndoHelper::undoChanges()
 
     /* Finally we walk through the tracks once more, removing clips that
      * were added, and clearing the temporarily used uid property */
-    int trackIndex = 0;
-    foreach (const Track & track, m_model.trackList()) {
+    foreach (int trackIndex, recordedTracks()) {
+        const Track& track = m_model.trackList()[trackIndex];
         QScopedPointer<Mlt::Producer> trackProducer(m_model.tractor()->track(track.mlt_index));
         Mlt::Playlist playlist(*trackProducer);
         for (int i = playlist.count() - 1; i >= 0; --i) {
@@ -238,7 +358,6 @@ void UndoHelper::undoChanges()
                 m_model.endRemoveRows();
             }
         }
-        trackIndex++;
     }
     emit m_model.modified();
 #ifdef UNDOHELPER_DEBUG
@@ -251,6 +370,28 @@ void UndoHelper::setHints(OptimizationHints hints)
     m_hints = hints;
 }
 
+void UndoHelper::setTracks(const QList<int>& trackIndexes)
+{
+    m_tracks = trackIndexes;
+}
+
+QList<int> UndoHelper::recordedTracks() const
+{
+    QList<int> result;
+    int count = m_model.trackList().count();
+    if (m_tracks.isEmpty()) {
+        for (int i = 0; i < count; ++i)
+            result << i;
+    } else {
+        foreach (int i, m_tracks) {
+            if (i >= 0 && i < count && !result.contains(i))
+                result << i;
+        }
+        qSort(result);
+    }
+    return result;
+}
+
 void UndoHelper::debugPrintState()
 {
     qDebug("timeline state: {");
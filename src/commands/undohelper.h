@@ -24,6 +24,7 @@
 #include <QString>
 #include <QMap>
 #include <QList>
+#include <QByteArray>
 
 class UndoHelper
 {
@@ -40,8 +41,16 @@ public:
     void undoChanges();
     void setHints(OptimizationHints hints);
 
+    /*!
+      Restricts the recorded state to the tracks in \a trackIndexes. Only
+      use this when the operation cannot change any other track; an empty
+      list (the default) records all tracks.
+    */
+    void setTracks(const QList<int>& trackIndexes);
+
 private:
     void debugPrintState();
+    QList<int> recordedTracks() const;
 
     enum ChangeFlags {
         NoChange = 0x0,
@@ -58,6 +67,7 @@ private:
         int newClipIndex;
         bool isBlank;
         QString xml;
+        QByteArray hash;
         int frame_in;
         int frame_out;
 
@@ -78,6 +88,7 @@ private:
     QList<QUuid> m_insertedOrder;
     MultitrackModel & m_model;
     OptimizationHints m_hints;
+    QList<int> m_tracks;
 };
 
 #endif // UNDOHELPER_H
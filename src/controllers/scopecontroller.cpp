@@ -20,6 +20,8 @@
 #include "widgets/scopes/audiopeakmeterscopewidget.h"
 #include "widgets/scopes/audiospectrumscopewidget.h"
 #include "widgets/scopes/audiowaveformscopewidget.h"
+#include "widgets/scopes/videohistogramscopewidget.h"
+#include "widgets/scopes/videorgbparadescopewidget.h"
 #include "widgets/scopes/videowaveformscopewidget.h"
 #include "docks/scopedock.h"
 #include "settings.h"
@@ -36,9 +38,11 @@ ScopeController::ScopeController(QMainWindow* mainWindow, QMenu* menu)
     createScopeDock<AudioPeakMeterScopeWidget>(mainWindow, scopeMenu);
     createScopeDock<AudioSpectrumScopeWidget>(mainWindow, scopeMenu);
     createScopeDock<AudioWaveformScopeWidget>(mainWindow, scopeMenu);
-//    if (!Settings.playerGPU()) {
-//        createScopeDock<VideoWaveformScopeWidget>(mainWindow, scopeMenu);
-//    }
+    if (!Settings.playerGPU()) {
+        createScopeDock<VideoHistogramScopeWidget>(mainWindow, scopeMenu);
+        createScopeDock<VideoRgbParadeScopeWidget>(mainWindow, scopeMenu);
+        createScopeDock<VideoWaveformScopeWidget>(mainWindow, scopeMenu);
+    }
     LOG_DEBUG() << "end";
 }
 
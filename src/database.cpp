@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2016 Meltytech, LLC
+ * Copyright (c) 2013-2017 Meltytech, LLC
  * Author: Dan Dennedy <dan@dennedy.org>
  *
  * This program is free software: you can redistribute it and/or modify
@@ -17,6 +17,8 @@
  */
 
 #include "database.h"
+#include "thumbnailcache.h"
+#include "models/audiopeaks.h"
 #include "models/playlistmodel.h"
 #include "mainwindow.h"
 #include "settings.h"
@@ -26,21 +28,37 @@
 
 struct DatabaseJob {
     enum Type {
-        PutThumbnail,
-        GetThumbnail
+        GetThumbnail,
+        GetFileHash,
+        PutFileHash,
+        GetProjectCheck,
+        PutProjectCheck,
+        GetProxy,
+        PutProxy,
+        RemoveProxy
     } type;
 
     QImage image;
     QString hash;
-    bool result;
+    QString path;
+    qint64 size;
+    qint64 modified;
+    ProjectCheck check;
+    bool found;
     bool completed;
     DatabaseJob()
-        : result(false)
+        : size(0)
+        , modified(0)
+        , found(false)
         , completed(false)
     {}
 };
 
 static Database* instance = 0;
+// The number of thumbnails to cache.
+static const int kMaxThumbnails = 10000;
+// Access times are written and old thumbnails deleted at this interval (ms).
+static const int kMaintenanceInterval = 60 * 1000;
 
 Database::Database(QObject *parent) :
     QThread(parent)
@@ -71,60 +89,230 @@ bool Database::upgradeVersion1()
     return success;
 }
 
-void Database::doJob(DatabaseJob * job)
+bool Database::upgradeVersion2()
 {
-    if (!m_commitTimer->isActive())
-        QSqlDatabase::database().transaction();
-    m_commitTimer->start();
+    bool success = false;
+    QSqlQuery query;
+    // Speeds up finding the least recently used thumbnails.
+    if (query.exec("CREATE INDEX IF NOT EXISTS thumbnails_accessed ON thumbnails (accessed);")) {
+        success = query.exec("UPDATE version SET version = 2;");
+        if (!success)
+            LOG_ERROR() << query.lastError();
+    } else {
+        LOG_ERROR() << "Failed to create thumbnails index.";
+    }
+    return success;
+}
 
-    if (job->type == DatabaseJob::PutThumbnail) {
-        QByteArray ba;
-        QBuffer buffer(&ba);
-        buffer.open(QIODevice::WriteOnly);
-        job->image.save(&buffer, "PNG");
+bool Database::upgradeVersion3()
+{
+    bool success = false;
+    QSqlQuery query;
+    if (query.exec("CREATE TABLE file_hashes (path TEXT PRIMARY KEY NOT NULL, size INTEGER NOT NULL, modified INTEGER NOT NULL, hash TEXT NOT NULL);")) {
+        success = query.exec("UPDATE version SET version = 3;");
+        if (!success)
+            LOG_ERROR() << query.lastError();
+    } else {
+        LOG_ERROR() << "Failed to create file_hashes table.";
+    }
+    return success;
+}
 
-        QSqlQuery query;
-        query.prepare("DELETE FROM thumbnails WHERE hash = :hash;");
-        query.bindValue(":hash", job->hash);
-        query.exec();
-        query.prepare("INSERT INTO thumbnails VALUES (:hash, datetime('now'), :image);");
-        query.bindValue(":hash", job->hash);
-        query.bindValue(":image", ba);
-        job->result = query.exec();
-        if (!job->result)
+bool Database::upgradeVersion4()
+{
+    bool success = false;
+    QSqlQuery query;
+    if (query.exec("CREATE TABLE project_checks (path TEXT PRIMARY KEY NOT NULL, size INTEGER NOT NULL, modified INTEGER NOT NULL, context TEXT NOT NULL, hash TEXT NOT NULL, flags INTEGER NOT NULL, resources TEXT);")) {
+        success = query.exec("UPDATE version SET version = 4;");
+        if (!success)
+            LOG_ERROR() << query.lastError();
+    } else {
+        LOG_ERROR() << "Failed to create project_checks table.";
+    }
+    return success;
+}
+
+bool Database::upgradeVersion5()
+{
+    bool success = false;
+    QSqlQuery query;
+    if (query.exec("CREATE TABLE proxies (hash TEXT PRIMARY KEY NOT NULL, path TEXT NOT NULL, created DATETIME NOT NULL);")) {
+        success = query.exec("UPDATE version SET version = 5;");
+        if (!success)
             LOG_ERROR() << query.lastError();
-    } else if (job->type == DatabaseJob::GetThumbnail) {
+    } else {
+        LOG_ERROR() << "Failed to create proxies table.";
+    }
+    return success;
+}
+
+void Database::doJob(DatabaseJob * job)
+{
+    if (job->type == DatabaseJob::GetThumbnail) {
         QImage result;
         QSqlQuery query;
         query.prepare("SELECT image FROM thumbnails WHERE hash = :hash;");
         query.bindValue(":hash", job->hash);
         if (query.exec() && query.first()) {
-            result.loadFromData(query.value(0).toByteArray(), "PNG");
-            QSqlQuery update;
-            update.prepare("UPDATE thumbnails SET accessed = datetime('now') WHERE hash = :hash ;");
-            update.bindValue(":hash", job->hash);
-            if (!update.exec())
-                LOG_ERROR() << update.lastError();
+            // The format is detected because older thumbnails are PNG.
+            result.loadFromData(query.value(0).toByteArray());
+            m_accessed << job->hash;
         }
         job->image = result;
+    } else if (job->type == DatabaseJob::GetFileHash) {
+        QSqlQuery query;
+        query.prepare("SELECT hash FROM file_hashes WHERE path = :path AND size = :size AND modified = :modified;");
+        query.bindValue(":path", job->path);
+        query.bindValue(":size", job->size);
+        query.bindValue(":modified", job->modified);
+        if (query.exec() && query.first())
+            job->hash = query.value(0).toString();
+    } else if (job->type == DatabaseJob::PutFileHash) {
+        if (!m_commitTimer->isActive())
+            QSqlDatabase::database().transaction();
+        m_commitTimer->start();
+
+        QSqlQuery query;
+        query.prepare("INSERT OR REPLACE INTO file_hashes VALUES (:path, :size, :modified, :hash);");
+        query.bindValue(":path", job->path);
+        query.bindValue(":size", job->size);
+        query.bindValue(":modified", job->modified);
+        query.bindValue(":hash", job->hash);
+        if (!query.exec())
+            LOG_ERROR() << query.lastError();
+    } else if (job->type == DatabaseJob::GetProjectCheck) {
+        QSqlQuery query;
+        query.prepare("SELECT size, modified, context, hash, flags, resources FROM project_checks WHERE path = :path;");
+        query.bindValue(":path", job->path);
+        if (query.exec() && query.first()) {
+            job->check.size = query.value(0).toLongLong();
+            job->check.modified = query.value(1).toLongLong();
+            job->check.context = query.value(2).toString();
+            job->check.hash = query.value(3).toString();
+            job->check.flags = query.value(4).toInt();
+            job->check.resources = query.value(5).toString().split('\n', QString::SkipEmptyParts);
+            job->found = true;
+        }
+    } else if (job->type == DatabaseJob::PutProjectCheck) {
+        if (!m_commitTimer->isActive())
+            QSqlDatabase::database().transaction();
+        m_commitTimer->start();
+
+        QSqlQuery query;
+        query.prepare("INSERT OR REPLACE INTO project_checks VALUES (:path, :size, :modified, :context, :hash, :flags, :resources);");
+        query.bindValue(":path", job->path);
+        query.bindValue(":size", job->check.size);
+        query.bindValue(":modified", job->check.modified);
+        query.bindValue(":context", job->check.context);
+        query.bindValue(":hash", job->check.hash);
+        query.bindValue(":flags", job->check.flags);
+        query.bindValue(":resources", job->check.resources.join('\n'));
+        if (!query.exec())
+            LOG_ERROR() << query.lastError();
+    } else if (job->type == DatabaseJob::GetProxy) {
+        QSqlQuery query;
+        query.prepare("SELECT path FROM proxies WHERE hash = :hash;");
+        query.bindValue(":hash", job->hash);
+        if (query.exec() && query.first())
+            job->path = query.value(0).toString();
+    } else if (job->type == DatabaseJob::PutProxy) {
+        QSqlQuery query;
+        query.prepare("INSERT OR REPLACE INTO proxies VALUES (:hash, :path, datetime('now'));");
+        query.bindValue(":hash", job->hash);
+        query.bindValue(":path", job->path);
+        if (!query.exec())
+            LOG_ERROR() << query.lastError();
+    } else if (job->type == DatabaseJob::RemoveProxy) {
+        QSqlQuery query;
+        query.prepare("DELETE FROM proxies WHERE hash = :hash;");
+        query.bindValue(":hash", job->hash);
+        if (!query.exec())
+            LOG_ERROR() << query.lastError();
     }
-    deleteOldThumbnails();
     job->completed = true;
 }
 
+void Database::writeThumbnails(const QHash<QString, PendingThumbnail>& thumbnails)
+{
+    if (thumbnails.isEmpty())
+        return;
+    if (!m_commitTimer->isActive())
+        QSqlDatabase::database().transaction();
+    m_commitTimer->start();
+
+    QSqlQuery query;
+    query.prepare("INSERT OR REPLACE INTO thumbnails VALUES (:hash, datetime('now'), :image);");
+    QHash<QString, PendingThumbnail>::const_iterator i = thumbnails.constBegin();
+    for (; i != thumbnails.constEnd(); ++i) {
+        query.bindValue(":hash", i.key());
+        query.bindValue(":image", i.value().data);
+        if (!query.exec())
+            LOG_ERROR() << query.lastError();
+        m_accessed.remove(i.key());
+    }
+}
+
+void Database::updateAccessTimes()
+{
+    if (m_accessed.isEmpty())
+        return;
+    if (!m_commitTimer->isActive())
+        QSqlDatabase::database().transaction();
+    m_commitTimer->start();
+
+    QSqlQuery query;
+    query.prepare("UPDATE thumbnails SET accessed = datetime('now') WHERE hash = :hash;");
+    foreach (QString hash, m_accessed) {
+        query.bindValue(":hash", hash);
+        if (!query.exec())
+            LOG_ERROR() << query.lastError();
+    }
+    m_accessed.clear();
+}
+
 void Database::commitTransaction()
 {
     QSqlDatabase::database().commit();
 }
 
-bool Database::putThumbnail(const QString& hash, const QImage& image)
+// Returns true if any pixel of image is not fully opaque.
+static bool isTranslucent(const QImage& image)
 {
-    DatabaseJob job;
-    job.type = DatabaseJob::PutThumbnail;
-    job.hash = hash;
-    job.image = image;
-    submitAndWaitForJob(&job);
-    return job.result;
+    if (!image.hasAlphaChannel())
+        return false;
+    if (image.format() != QImage::Format_ARGB32 && image.format() != QImage::Format_ARGB32_Premultiplied)
+        return isTranslucent(image.convertToFormat(QImage::Format_ARGB32));
+    for (int y = 0; y < image.height(); y++) {
+        const QRgb* line = (const QRgb*) image.constScanLine(y);
+        for (int x = 0; x < image.width(); x++) {
+            if (qAlpha(line[x]) != 255)
+                return true;
+        }
+    }
+    return false;
+}
+
+void Database::putThumbnail(const QString& hash, const QImage& image)
+{
+    ThumbnailCache::singleton().insert(hash, image);
+
+    // JPEG is much faster to encode and smaller than PNG; keep PNG only for
+    // images that need the alpha channel. Controller::image() always
+    // returns ARGB32, so look at the pixels rather than the format.
+    PendingThumbnail thumbnail;
+    thumbnail.image = image;
+    QBuffer buffer(&thumbnail.data);
+    buffer.open(QIODevice::WriteOnly);
+    if (isTranslucent(image))
+        image.save(&buffer, "PNG");
+    else
+        image.save(&buffer, "JPEG", 90);
+
+    m_mutex.lock();
+    m_pendingThumbnails.insert(hash, thumbnail);
+    if (m_jobs.isEmpty())
+        m_waitForNewJob.wakeAll();
+    m_mutex.unlock();
 }
 
 void Database::submitAndWaitForJob(DatabaseJob * job)
@@ -144,15 +332,99 @@ void Database::submitAndWaitForJob(DatabaseJob * job)
 
 QImage Database::getThumbnail(const QString &hash)
 {
+    QImage image = ThumbnailCache::singleton().image(hash);
+    if (!image.isNull())
+        return image;
+
+    // A thumbnail that is not written yet does not need the database.
+    m_mutex.lock();
+    if (m_pendingThumbnails.contains(hash)) {
+        image = m_pendingThumbnails.value(hash).image;
+        m_mutex.unlock();
+        return image;
+    }
+    m_mutex.unlock();
+
     DatabaseJob job;
     job.type = DatabaseJob::GetThumbnail;
     job.hash = hash;
     submitAndWaitForJob(&job);
+    ThumbnailCache::singleton().insert(hash, job.image);
     return job.image;
 }
 
+QString Database::getFileHash(const QString& path, qint64 size, qint64 modified)
+{
+    DatabaseJob job;
+    job.type = DatabaseJob::GetFileHash;
+    job.path = path;
+    job.size = size;
+    job.modified = modified;
+    submitAndWaitForJob(&job);
+    return job.hash;
+}
+
+void Database::putFileHash(const QString& path, qint64 size, qint64 modified, const QString& hash)
+{
+    DatabaseJob job;
+    job.type = DatabaseJob::PutFileHash;
+    job.path = path;
+    job.size = size;
+    job.modified = modified;
+    job.hash = hash;
+    submitAndWaitForJob(&job);
+}
+
+bool Database::getProjectCheck(const QString& path, ProjectCheck& check)
+{
+    DatabaseJob job;
+    job.type = DatabaseJob::GetProjectCheck;
+    job.path = path;
+    submitAndWaitForJob(&job);
+    if (job.found)
+        check = job.check;
+    return job.found;
+}
+
+void Database::putProjectCheck(const QString& path, const ProjectCheck& check)
+{
+    DatabaseJob job;
+    job.type = DatabaseJob::PutProjectCheck;
+    job.path = path;
+    job.check = check;
+    submitAndWaitForJob(&job);
+}
+
+QString Database::getProxy(const QString& hash)
+{
+    DatabaseJob job;
+    job.type = DatabaseJob::GetProxy;
+    job.hash = hash;
+    submitAndWaitForJob(&job);
+    return job.path;
+}
+
+void Database::putProxy(const QString& hash, const QString& path)
+{
+    DatabaseJob job;
+    job.type = DatabaseJob::PutProxy;
+    job.hash = hash;
+    job.path = path;
+    submitAndWaitForJob(&job);
+}
+
+void Database::removeProxy(const QString& hash)
+{
+    DatabaseJob job;
+    job.type = DatabaseJob::RemoveProxy;
+    job.hash = hash;
+    submitAndWaitForJob(&job);
+}
+
 void Database::shutdown()
 {
+    LOG_DEBUG() << "thumbnail cache hits" << ThumbnailCache::singleton().hits()
+                << "misses" << ThumbnailCache::singleton().misses();
     requestInterruption();
     wait();
     QString connection = QSqlDatabase::database().connectionName();
@@ -164,8 +436,11 @@ void Database::shutdown()
 void Database::deleteOldThumbnails()
 {
     QSqlQuery query;
-    // OFFSET is the number of thumbnails to cache.
-    if (!query.exec("DELETE FROM thumbnails WHERE hash IN (SELECT hash FROM thumbnails ORDER BY accessed DESC LIMIT -1 OFFSET 10000);"))
+    // Both the subquery and the delete use the index on accessed.
+    query.prepare("DELETE FROM thumbnails WHERE accessed < "
+                  "(SELECT accessed FROM thumbnails ORDER BY accessed DESC LIMIT 1 OFFSET :count);");
+    query.bindValue(":count", kMaxThumbnails);
+    if (!query.exec())
         LOG_ERROR() << query.lastError();
 }
 
@@ -202,24 +477,51 @@ void Database::run()
     }
     if (version < 1 && upgradeVersion1())
         version = 1;
+    if (version < 2 && upgradeVersion2())
+        version = 2;
+    if (version < 3 && upgradeVersion3())
+        version = 3;
+    if (version < 4 && upgradeVersion4())
+        version = 4;
+    if (version < 5 && upgradeVersion5())
+        version = 5;
     LOG_DEBUG() << "Database version is" << version;
+    m_maintenanceTime.start();
 
     while (true) {
         DatabaseJob * newJob = 0;
+        QHash<QString, PendingThumbnail> thumbnails;
         m_mutex.lock();
-        if (m_jobs.isEmpty())
+        if (m_jobs.isEmpty() && m_pendingThumbnails.isEmpty())
             m_waitForNewJob.wait(&m_mutex, 1000);
-        else
+        // Reads are waited on, so they go before the queued writes.
+        if (!m_jobs.isEmpty())
             newJob = m_jobs.takeFirst();
+        else
+            thumbnails.swap(m_pendingThumbnails);
         m_mutex.unlock();
         QCoreApplication::processEvents();
         if (newJob) {
             doJob(newJob);
             m_waitForFinished.wakeAll();
+        } else if (!thumbnails.isEmpty()) {
+            writeThumbnails(thumbnails);
+        }
+        if (m_maintenanceTime.elapsed() > kMaintenanceInterval) {
+            updateAccessTimes();
+            deleteOldThumbnails();
+            // Audio levels moved from the thumbnails table into peak files.
+            AudioPeaks::deleteOldFiles();
+            m_maintenanceTime.restart();
         }
         if (isInterruptionRequested())
             break;
     }
+    m_mutex.lock();
+    writeThumbnails(m_pendingThumbnails);
+    m_pendingThumbnails.clear();
+    m_mutex.unlock();
+    updateAccessTimes();
     if (m_commitTimer->isActive())
         commitTransaction();
     delete m_commitTimer;
@@ -23,6 +23,28 @@
 #include <QImage>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QHash>
+#include <QSet>
+#include <QTime>
+#include <QStringList>
+
+/*!
+  \brief The ProjectCheck records a project file that MltXmlChecker found
+  clean, i.e. without anything to correct and without unlinked files.
+*/
+struct ProjectCheck {
+    qint64 size;
+    qint64 modified;
+    QString context;
+    QString hash;
+    int flags;
+    QStringList resources;
+    ProjectCheck()
+        : size(0)
+        , modified(0)
+        , flags(0)
+    {}
+};
 
 struct DatabaseJob;
 class QTimer;
@@ -35,8 +57,27 @@ public:
     static Database& singleton(QWidget* parent = 0);
 
     bool upgradeVersion1();
-    bool putThumbnail(const QString& hash, const QImage& image);
+    bool upgradeVersion2();
+    bool upgradeVersion3();
+    bool upgradeVersion4();
+    bool upgradeVersion5();
+    /*!
+      Queues the thumbnail to be stored and returns without waiting. The
+      image is encoded in the calling thread, and queued thumbnails are
+      written together in one transaction.
+    */
+    void putThumbnail(const QString& hash, const QImage& image);
     QImage getThumbnail(const QString& hash);
+    //! Returns the hash stored for the file if its size and time still match.
+    QString getFileHash(const QString& path, qint64 size, qint64 modified);
+    void putFileHash(const QString& path, qint64 size, qint64 modified, const QString& hash);
+    //! Returns false if no clean check is recorded for the project at \a path.
+    bool getProjectCheck(const QString& path, ProjectCheck& check);
+    void putProjectCheck(const QString& path, const ProjectCheck& check);
+    //! Returns the path of the proxy for the media with \a hash, if any.
+    QString getProxy(const QString& hash);
+    void putProxy(const QString& hash, const QString& path);
+    void removeProxy(const QString& hash);
 
 private slots:
     void commitTransaction();
@@ -45,12 +86,22 @@ private slots:
     void shutdown();
 
 private:
+    struct PendingThumbnail {
+        QImage image;
+        QByteArray data;
+    };
+
     void doJob(DatabaseJob * job);
     void submitAndWaitForJob(DatabaseJob * job);
+    void writeThumbnails(const QHash<QString, PendingThumbnail>& thumbnails);
+    void updateAccessTimes();
     void deleteOldThumbnails();
     void run();
 
     QList<DatabaseJob*> m_jobs;
+    QHash<QString, PendingThumbnail> m_pendingThumbnails;
+    QSet<QString> m_accessed;
+    QTime m_maintenanceTime;
     QMutex m_mutex;
     QWaitCondition m_waitForFinished;
     QWaitCondition m_waitForNewJob;
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATARINGBUFFER_H
+#define DATARINGBUFFER_H
+
+#include <QAtomicInt>
+#include <QThread>
+
+/*!
+  \class DataRingBuffer
+  \brief The DataRingBuffer provides a lock-free container for passing data
+  from one producer to one consumer.
+
+  \threadsafe
+
+  DataRingBuffer is a bounded, pre-allocated alternative to DataQueue for the
+  case where exactly one object calls push() and exactly one object calls
+  tryPop() or drainLatest(). No mutex is taken and no memory is allocated
+  after construction, which makes it suitable for hot paths such as handing
+  every displayed frame to the scopes.
+
+  The overflow modes match those of DataQueue. In OverflowModeDiscardOldest
+  the producer claims the oldest slot the same way the consumer does, so the
+  item is released without racing a concurrent tryPop(). In OverflowModeWait
+  push() yields the producer thread until the consumer frees a slot.
+
+  Popped slots are reset to a default constructed T so that reference counted
+  items (e.g. SharedFrame) are released as soon as they are consumed.
+*/
+
+template <class T>
+class DataRingBuffer
+{
+public:
+    //! Overflow behavior modes.
+    typedef enum {
+        OverflowModeDiscardOldest = 0, //!< Discard oldest items
+        OverflowModeDiscardNewest,     //!< Discard newest items
+        OverflowModeWait               //!< Wait for space to be free
+    } OverflowMode;
+
+    /*!
+      Constructs a DataRingBuffer.
+
+      The \a maxSize will be the maximum number of items held and the \a mode
+      will dictate overflow behavior.
+    */
+    explicit DataRingBuffer(int maxSize, OverflowMode mode);
+
+    //! Destructs a DataRingBuffer.
+    virtual ~DataRingBuffer();
+
+    /*!
+      Pushes an item into the buffer. Must only be called by the producer.
+
+      Returns false if the item was discarded because the buffer was full and
+      the overflow mode is OverflowModeDiscardNewest.
+    */
+    bool push(const T& item);
+
+    /*!
+      Pops the oldest item into \a item. Must only be called by the consumer.
+
+      Returns false without blocking if the buffer is empty.
+    */
+    bool tryPop(T& item);
+
+    /*!
+      Discards all queued items except the newest, which is stored in \a item.
+      Must only be called by the consumer.
+
+      Returns false without blocking (and leaves \a item untouched) if the
+      buffer is empty.
+    */
+    bool drainLatest(T& item);
+
+    //! Returns the approximate number of items in the buffer.
+    int count() const;
+
+private:
+    Q_DISABLE_COPY(DataRingBuffer)
+
+    struct Cell {
+        QAtomicInt sequence;
+        T data;
+    };
+
+    bool claim(T* item);
+
+    Cell* m_cells;
+    int m_capacity;
+    int m_mask;
+    int m_maxSize;
+    OverflowMode m_mode;
+    QAtomicInt m_writePos;
+    QAtomicInt m_readPos;
+};
+
+template <class T>
+DataRingBuffer<T>::DataRingBuffer(int maxSize, OverflowMode mode)
+  : m_cells(0)
+  , m_capacity(1)
+  , m_mask(0)
+  , m_maxSize(qMax(1, maxSize))
+  , m_mode(mode)
+  , m_writePos(0)
+  , m_readPos(0)
+{
+    // Round up to a power of two so positions can wrap with a mask.
+    while (m_capacity < m_maxSize)
+        m_capacity <<= 1;
+    m_mask = m_capacity - 1;
+    m_cells = new Cell[m_capacity];
+    for (int i = 0; i < m_capacity; i++)
+        m_cells[i].sequence.store(i);
+}
+
+template <class T>
+DataRingBuffer<T>::~DataRingBuffer()
+{
+    delete [] m_cells;
+}
+
+template <class T>
+bool DataRingBuffer<T>::push(const T& item)
+{
+    int pos = m_writePos.load();
+    while (pos - m_readPos.loadAcquire() >= m_maxSize) {
+        switch (m_mode) {
+            case OverflowModeDiscardOldest:
+                claim(0);
+                break;
+            case OverflowModeDiscardNewest:
+                // This item is the newest so discard it and exit
+                return false;
+            case OverflowModeWait:
+                QThread::yieldCurrentThread();
+                break;
+        }
+    }
+
+    Cell& cell = m_cells[pos & m_mask];
+    // A consumer may still be copying out of this slot; it hands the slot
+    // back by advancing the sequence.
+    while (cell.sequence.loadAcquire() != pos)
+        QThread::yieldCurrentThread();
+    cell.data = item;
+    cell.sequence.storeRelease(pos + 1);
+    m_writePos.storeRelease(pos + 1);
+    return true;
+}
+
+template <class T>
+bool DataRingBuffer<T>::tryPop(T& item)
+{
+    return claim(&item);
+}
+
+template <class T>
+bool DataRingBuffer<T>::drainLatest(T& item)
+{
+    if (!claim(&item))
+        return false;
+    while (claim(&item)) {}
+    return true;
+}
+
+template <class T>
+int DataRingBuffer<T>::count() const
+{
+    return qMax(0, m_writePos.loadAcquire() - m_readPos.loadAcquire());
+}
+
+// Takes ownership of the oldest slot. Both the consumer and, when discarding
+// the oldest item, the producer may call this; the compare-and-swap on the
+// read position decides who gets the slot.
+template <class T>
+bool DataRingBuffer<T>::claim(T* item)
+{
+    int pos = m_readPos.loadAcquire();
+    forever {
+        Cell& cell = m_cells[pos & m_mask];
+        int diff = cell.sequence.loadAcquire() - (pos + 1);
+        if (diff < 0) {
+            // Nothing has been published in this slot yet.
+            return false;
+        } else if (diff == 0) {
+            if (m_readPos.testAndSetOrdered(pos, pos + 1, pos)) {
+                if (item)
+                    *item = cell.data;
+                cell.data = T();
+                cell.sequence.storeRelease(pos + m_capacity);
+                return true;
+            }
+        } else {
+            pos = m_readPos.loadAcquire();
+        }
+    }
+}
+
+#endif // DATARINGBUFFER_H
@@ -25,6 +25,7 @@
 #include "settings.h"
 #include "qmltypes/qmlapplication.h"
 #include "jobs/encodejob.h"
+#include "jobs/concatjob.h"
 #include "shotcut_mlt_properties.h"
 #include "util.h"
 
@@ -36,6 +37,7 @@
 #include <QTimer>
 #include <QFileInfo>
 #include <QStorageInfo>
+#include <QTemporaryDir>
 
 // formulas to map absolute value ranges to percentages as int
 #define TO_ABSOLUTE(min, max, rel) qRound(float(min) + float((max) - (min) + 1) * float(rel) / 100.0f)
@@ -756,7 +758,8 @@ void EncodeDock::collectProperties(QDomElement& node, int realtime)
     delete p;
 }
 
-MeltJob* EncodeDock::createMeltJob(Mlt::Service* service, const QString& target, int realtime, int pass)
+MeltJob* EncodeDock::createMeltJob(Mlt::Service* service, const QString& target, int realtime, int pass,
+                                   int codecThreads, ExportStreams streams)
 {
     // if image sequence, change filename to include number
     QString mytarget = target;
@@ -822,6 +825,19 @@ MeltJob* EncodeDock::createMeltJob(Mlt::Service* service, const QString& target,
     consumerNode.setAttribute("mlt_service", "avformat");
     consumerNode.setAttribute("target", mytarget);
     collectProperties(consumerNode, realtime);
+    if (streams == VideoStreamOnly) {
+        consumerNode.removeAttribute("acodec");
+        consumerNode.setAttribute("an", 1);
+        consumerNode.setAttribute("audio_off", 1);
+    } else if (streams == AudioStreamOnly) {
+        consumerNode.removeAttribute("vcodec");
+        consumerNode.setAttribute("vn", 1);
+        consumerNode.setAttribute("video_off", 1);
+    }
+    // Codecs that must run with one thread (see collectProperties()) keep it.
+    if (codecThreads >= 0 && consumerNode.hasAttribute("threads")
+            && consumerNode.attribute("threads").toInt() != 1)
+        consumerNode.setAttribute("threads", codecThreads);
     if ("libx265" == ui->videoCodecCombo->currentText()) {
         if (pass == 1 || pass == 2) {
             QString x265params = consumerNode.attribute("x265-params");
@@ -851,7 +867,17 @@ MeltJob* EncodeDock::createMeltJob(Mlt::Service* service, const QString& target,
     for (int i = 0; i < playlists.length();++i)
         playlists.item(i).toElement().setAttribute("autoclose", 1);
 
-    return new EncodeJob(target, dom.toString(2));
+    MeltJob* job = new EncodeJob(target, dom.toString(2));
+    // Tell the job queue how many cores this encode keeps busy. A negative
+    // real_time is the number of rendering threads. Without a threads
+    // attribute libx264 and libx265 pick their own, but lookahead and frame
+    // dependencies keep them from saturating every core, so count on half.
+    int threads = consumerNode.attribute("threads").toInt();
+    int renderThreads = -consumerNode.attribute("real_time").toInt();
+    if (threads <= 0)
+        threads = qMax(1, QThread::idealThreadCount() / 2);
+    job->setThreads(qMax(threads, renderThreads));
+    return job;
 }
 
 void EncodeDock::runMelt(const QString& target, int realtime)
@@ -911,26 +937,114 @@ void EncodeDock::enqueueMelt(const QString& target, int realtime)
                 if (job) {
                     JOBS.add(job);
                     if (pass) {
-                        job = createMeltJob(producer.data(), filename, realtime, 2);
-                        if (job)
-                            JOBS.add(job);
+                        MeltJob* pass2 = createMeltJob(producer.data(), filename, realtime, 2);
+                        if (pass2) {
+                            pass2->addDependency(job);
+                            JOBS.add(pass2);
+                        }
                     }
                 }
             }
         }
-    } else {
+    } else if (!isSegmentable(pass) || !enqueueSegments(service, target)) {
         MeltJob* job = createMeltJob(service, target, realtime, pass);
         if (job) {
             JOBS.add(job);
             if (pass) {
-                job = createMeltJob(service, target, realtime, 2);
-                if (job)
-                    JOBS.add(job);
+                MeltJob* pass2 = createMeltJob(service, target, realtime, 2);
+                if (pass2) {
+                    pass2->addDependency(job);
+                    JOBS.add(pass2);
+                }
             }
         }
     }
 }
 
+bool EncodeDock::isSegmentable(int pass) const
+{
+    if (!ui->segmentedCheckbox->isChecked() || pass || Settings.playerGPU())
+        return false;
+    // Segments start and end on GOP boundaries only when there is video.
+    if (ui->disableVideoCheckbox->isChecked() || ui->formatCombo->currentText() == "image2")
+        return false;
+    const QString& codec = ui->videoCodecCombo->currentText();
+    if (codec == "bmp" || codec == "dpx" || codec == "png" || codec == "ppm" ||
+            codec == "targa" || codec == "tiff")
+        return false;
+    // The in and out points of a single clip are already used to trim it.
+    return ui->fromCombo->currentData().toString() != "clip";
+}
+
+bool EncodeDock::enqueueSegments(Mlt::Producer* service, const QString& target)
+{
+    static const int kMinSegmentSeconds = 60;
+    const int cores = QThread::idealThreadCount();
+    const int length = service->get_playtime();
+    const int gop = qMax(1, ui->gopSpinner->value());
+    const int minLength = qMax(gop, qRound(MLT.profile().fps() * kMinSegmentSeconds));
+    const int count = qMin(cores, length / minLength);
+    if (count < 2)
+        return false;
+    // Every segment except the last holds whole GOPs so that joining them
+    // keeps the keyframe interval of a single encode.
+    const int segmentLength = (length / count + gop - 1) / gop * gop;
+    // Each segment renders with one thread and shares the cores for encoding.
+    const int codecThreads = qMax(1, cores / count);
+
+    // Write the pieces into a new folder next to the target so that they
+    // never replace files of the user and are easily removed.
+    QFileInfo fi(target);
+    QTemporaryDir tempDir(QDir(fi.path()).filePath(QString(".%1-segments-XXXXXX").arg(fi.completeBaseName())));
+    if (!tempDir.isValid()) {
+        LOG_WARNING() << "failed to create a folder for the segments next to" << target;
+        return false;
+    }
+    QDir dir(tempDir.path());
+    LOG_INFO() << "exporting" << length << "frames as" << count << "segments of" << segmentLength << "in" << dir.path();
+    QString xml = MLT.XML(service);
+    QStringList segments;
+    QList<MeltJob*> jobs;
+    for (int in = 0, i = 0; in < length; in += segmentLength, i++) {
+        QScopedPointer<Mlt::Producer> producer(
+                    new Mlt::Producer(MLT.profile(), "xml-string", xml.toUtf8().constData()));
+        producer->set_in_and_out(in, qMin(in + segmentLength, length) - 1);
+        QString filename = dir.filePath(QString("part%1.%2").arg(i + 1, 2, 10, QChar('0')).arg(fi.suffix()));
+        MeltJob* job = createMeltJob(producer.data(), filename, -1, 0, codecThreads, VideoStreamOnly);
+        if (!job) {
+            // createMeltJob() already told the user why.
+            qDeleteAll(jobs);
+            return true;
+        }
+        job->setLabel(tr("%1 (part %2)").arg(fi.fileName()).arg(i + 1));
+        segments << filename;
+        jobs << job;
+    }
+    // Audio codecs such as AAC prepend encoder priming to every stream, so
+    // joining separately encoded audio leaves a gap at each boundary. Render
+    // the audio once over the whole range and mux it in when joining.
+    QString audio;
+    if (!ui->disableAudioCheckbox->isChecked()) {
+        audio = dir.filePath(QString("audio.%1").arg(fi.suffix()));
+        MeltJob* job = createMeltJob(service, audio, -1, 0, codecThreads, AudioStreamOnly);
+        if (!job) {
+            qDeleteAll(jobs);
+            return true;
+        }
+        job->setLabel(tr("%1 (audio)").arg(fi.fileName()));
+        jobs << job;
+    }
+    // From here on, the ConcatJob removes the folder.
+    tempDir.setAutoRemove(false);
+    ConcatJob* concat = new ConcatJob(target, dir.path(), segments, audio);
+    foreach (MeltJob* job, jobs) {
+        concat->addDependency(job);
+        JOBS.add(job);
+    }
+    JOBS.add(concat);
+    return true;
+}
+
 void EncodeDock::encode(const QString& target)
 {
     bool isMulti = true;
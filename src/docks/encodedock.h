@@ -127,6 +127,11 @@ private:
         AudioChannels2,
         AudioChannels6,
     };
+    enum ExportStreams {
+        AllStreams = 0,
+        VideoStreamOnly,
+        AudioStreamOnly
+    };
     Ui::EncodeDock *ui;
     Mlt::Properties *m_presets;
     QScopedPointer<MeltJob> m_immediateJob;
@@ -143,9 +148,12 @@ private:
     void loadPresets();
     Mlt::Properties* collectProperties(int realtime);
     void collectProperties(QDomElement& node, int realtime);
-    MeltJob* createMeltJob(Mlt::Service* service, const QString& target, int realtime, int pass = 0);
+    MeltJob* createMeltJob(Mlt::Service* service, const QString& target, int realtime, int pass = 0,
+                           int codecThreads = -1, ExportStreams streams = AllStreams);
     void runMelt(const QString& target, int realtime = -1);
     void enqueueMelt(const QString& target, int realtime);
+    bool isSegmentable(int pass) const;
+    bool enqueueSegments(Mlt::Producer* service, const QString& target);
     void encode(const QString& target);
     void resetOptions();
     Mlt::Producer* fromProducer() const;
@@ -19,13 +19,16 @@
 #include "jobsdock.h"
 #include "ui_jobsdock.h"
 #include "jobqueue.h"
+#include "settings.h"
 #include <QtWidgets>
 #include <Logger.h>
 #include "dialogs/textviewerdialog.h"
+#include "widgets/jobprogressgraph.h"
 
 JobsDock::JobsDock(QWidget *parent) :
     QDockWidget(parent),
-    ui(new Ui::JobsDock)
+    ui(new Ui::JobsDock),
+    m_progressGraph(new JobProgressGraph(this))
 {
     LOG_DEBUG() << "begin";
     ui->setupUi(this);
@@ -38,6 +41,11 @@ JobsDock::JobsDock(QWidget *parent) :
     header->setSectionResizeMode(JobQueue::COLUMN_OUTPUT, QHeaderView::Stretch);
     header->setSectionResizeMode(JobQueue::COLUMN_STATUS, QHeaderView::ResizeToContents);
     ui->cleanButton->hide();
+    // Show the throughput of the selected job between the list and the buttons.
+    ui->verticalLayout_2->insertWidget(1, m_progressGraph);
+    m_progressGraph->hide();
+    connect(ui->treeView->selectionModel(), SIGNAL(currentChanged(QModelIndex,QModelIndex)),
+            SLOT(onCurrentChanged(QModelIndex)));
     LOG_DEBUG() << "end";
 }
 
@@ -99,9 +107,8 @@ void JobsDock::resizeEvent(QResizeEvent *event)
 void JobsDock::on_treeView_customContextMenuRequested(const QPoint &pos)
 {
     QModelIndex index = ui->treeView->currentIndex();
-    if (!index.isValid()) return;
     QMenu menu(this);
-    AbstractJob* job = JOBS.jobFromIndex(index);
+    AbstractJob* job = index.isValid()? JOBS.jobFromIndex(index) : 0;
     if (job) {
         if (job->ran() && job->state() == QProcess::NotRunning && job->exitStatus() == QProcess::NormalExit) {
             menu.addActions(job->successActions());
@@ -114,11 +121,37 @@ void JobsDock::on_treeView_customContextMenuRequested(const QPoint &pos)
             menu.addAction(ui->actionRemove);
         if (job->ran())
             menu.addAction(ui->actionViewLog);
+        if (!job->progressSamples().isEmpty())
+            menu.addAction(ui->actionExportProgress);
         menu.addActions(job->standardActions());
+        menu.addSeparator();
     }
+    addConcurrencyMenu(menu);
     menu.exec(mapToGlobal(pos));
 }
 
+void JobsDock::addConcurrencyMenu(QMenu& menu)
+{
+    QMenu* subMenu = menu.addMenu(tr("Jobs at Once"));
+    QActionGroup* group = new QActionGroup(subMenu);
+    const int current = Settings.jobsMaxConcurrent();
+    QAction* action = subMenu->addAction(tr("Automatic"));
+    action->setToolTip(tr("Run as many jobs as the processor cores allow"));
+    action->setData(0);
+    action->setCheckable(true);
+    action->setChecked(current <= 0);
+    group->addAction(action);
+    subMenu->addSeparator();
+    for (int n = 1; n <= QThread::idealThreadCount(); n++) {
+        action = subMenu->addAction(QString::number(n));
+        action->setData(n);
+        action->setCheckable(true);
+        action->setChecked(current == n);
+        group->addAction(action);
+    }
+    connect(group, SIGNAL(triggered(QAction*)), SLOT(onConcurrencyTriggered(QAction*)));
+}
+
 void JobsDock::on_actionStopJob_triggered()
 {
     QModelIndex index = ui->treeView->currentIndex();
@@ -180,3 +213,31 @@ void JobsDock::on_actionRemove_triggered()
     if (!index.isValid()) return;
     JOBS.remove(index);
 }
+
+void JobsDock::on_actionExportProgress_triggered()
+{
+    AbstractJob* job = currentJob();
+    if (!job) return;
+    QString caption = tr("Export Progress");
+    QFileInfo fi(job->objectName());
+    QString path = QString("%1/%2.csv").arg(Settings.savePath()).arg(fi.completeBaseName());
+    QString fileName = QFileDialog::getSaveFileName(this, caption, path, tr("CSV (*.csv)"));
+    if (fileName.isEmpty())
+        return;
+    if (QFileInfo(fileName).suffix().isEmpty())
+        fileName += ".csv";
+    if (!job->saveProgressSamples(fileName))
+        QMessageBox::warning(this, caption, tr("Unable to write file %1").arg(fileName));
+}
+
+void JobsDock::onConcurrencyTriggered(QAction* action)
+{
+    JOBS.setMaxConcurrent(action->data().toInt());
+}
+
+void JobsDock::onCurrentChanged(const QModelIndex& current)
+{
+    AbstractJob* job = current.isValid()? JOBS.jobFromIndex(current) : 0;
+    m_progressGraph->setJob(job);
+    m_progressGraph->setVisible(job);
+}
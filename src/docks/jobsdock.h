@@ -22,6 +22,10 @@
 #include <QDockWidget>
 
 class AbstractJob;
+class QAction;
+class JobProgressGraph;
+class QMenu;
+class QModelIndex;
 class QStandardItem;
 
 namespace Ui {
@@ -45,7 +49,10 @@ protected:
     void resizeEvent(QResizeEvent *event);
 
 private:
+    void addConcurrencyMenu(QMenu& menu);
+
     Ui::JobsDock *ui;
+    JobProgressGraph* m_progressGraph;
 
 private slots:
     void on_treeView_customContextMenuRequested(const QPoint &pos);
@@ -56,6 +63,9 @@ private slots:
     void on_menuButton_clicked();
     void on_treeView_doubleClicked(const QModelIndex &index);
     void on_actionRemove_triggered();
+    void on_actionExportProgress_triggered();
+    void onCurrentChanged(const QModelIndex& current);
+    void onConcurrencyTriggered(QAction* action);
 };
 
 #endif // JOBSDOCK_H
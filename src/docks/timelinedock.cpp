@@ -629,6 +629,11 @@ void TimelineDock::remakeAudioLevels(int trackIndex, int clipIndex, bool force)
     }
 }
 
+void TimelineDock::setVisibleRange(int firstFrame, int lastFrame)
+{
+    AudioLevelsTask::setVisibleRange(firstFrame, lastFrame);
+}
+
 void TimelineDock::commitTrimCommand()
 {
     if (m_trimCommand && m_trimDelta) {
@@ -721,6 +726,8 @@ bool TimelineDock::trimClipIn(int trackIndex, int clipIndex, int delta, bool rip
         if (!m_undoHelper) {
             m_undoHelper.reset(new UndoHelper(m_model));
             if (ripple) m_undoHelper->setHints(UndoHelper::SkipXML);
+            if (!ripple || !Settings.timelineRippleAllTracks())
+                m_undoHelper->setTracks(QList<int>() << trackIndex);
             m_undoHelper->recordBeforeState();
         }
         m_model.trimClipIn(trackIndex, clipIndex, delta, ripple);
@@ -757,6 +764,8 @@ bool TimelineDock::trimClipOut(int trackIndex, int clipIndex, int delta, bool ri
         if (!m_undoHelper) {
             m_undoHelper.reset(new UndoHelper(m_model));
             if (ripple) m_undoHelper->setHints(UndoHelper::SkipXML);
+            if (!ripple || !Settings.timelineRippleAllTracks())
+                m_undoHelper->setTracks(QList<int>() << trackIndex);
             m_undoHelper->recordBeforeState();
         }
         m_model.trimClipOut(trackIndex, clipIndex, delta, ripple);
@@ -136,6 +136,7 @@ public slots:
     void onProducerChanged(Mlt::Producer*);
     void emitSelectedFromSelection();
     void remakeAudioLevels(int trackIndex, int clipIndex, bool force = true);
+    void setVisibleRange(int firstFrame, int lastFrame);
     void commitTrimCommand();
 
 protected:
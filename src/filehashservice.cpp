@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "filehashservice.h"
+#include "database.h"
+#include "shotcut_mlt_properties.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <Logger.h>
+
+// Hashing is limited by I/O, so more threads mostly add seeking.
+static const int kMaxThreads = 2;
+
+class FileHashTask : public QRunnable
+{
+public:
+    FileHashTask(FileHashService* service, const QString& path)
+        : QRunnable()
+        , m_service(service)
+        , m_path(path)
+    {}
+
+    void run()
+    {
+        m_service->finish(m_path, m_service->lookup(m_path));
+    }
+
+private:
+    FileHashService* m_service;
+    QString m_path;
+};
+
+FileHashService::FileHashService(QObject* parent)
+    : QObject(parent)
+{
+    m_pool.setMaxThreadCount(kMaxThreads);
+}
+
+FileHashService& FileHashService::singleton()
+{
+    static FileHashService* instance = new FileHashService;
+    return *instance;
+}
+
+QString FileHashService::request(const QString& path, Mlt::Properties& properties)
+{
+    QMutexLocker locker(&m_mutex);
+    QString result = m_hashes.value(path);
+    if (result.isEmpty() && !path.isEmpty()) {
+        bool isHashing = m_pending.contains(path);
+        m_pending[path] << new Mlt::Properties(properties);
+        if (!isHashing)
+            m_pool.start(new FileHashTask(this, path));
+    }
+    return result;
+}
+
+QString FileHashService::knownHash(const QString& path)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hashes.value(path);
+}
+
+QString FileHashService::hash(const QString& path)
+{
+    m_mutex.lock();
+    QString result = m_hashes.value(path);
+    m_mutex.unlock();
+    if (result.isEmpty()) {
+        result = lookup(path);
+        if (!result.isEmpty()) {
+            m_mutex.lock();
+            m_hashes.insert(path, result);
+            m_mutex.unlock();
+        }
+    }
+    return result;
+}
+
+QString FileHashService::computeHash(const QString& path)
+{
+    // This routine is intentionally copied from Kdenlive.
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly)) {
+        QByteArray fileData;
+        // 1 MB = 1 second per 450 files (or faster)
+        // 10 MB = 9 seconds per 450 files (or faster)
+        if (file.size() > 1000000*2) {
+            fileData = file.read(1000000);
+            if (file.seek(file.size() - 1000000))
+                fileData.append(file.readAll());
+        } else {
+            fileData = file.readAll();
+        }
+        file.close();
+        return QCryptographicHash::hash(fileData, QCryptographicHash::Md5).toHex();
+    }
+    return QString();
+}
+
+QString FileHashService::lookup(const QString& path)
+{
+    QFileInfo info(path);
+    if (!info.isFile())
+        return QString();
+    qint64 size = info.size();
+    qint64 modified = info.lastModified().toMSecsSinceEpoch();
+    QString result = DB.getFileHash(path, size, modified);
+    if (result.isEmpty()) {
+        result = computeHash(path);
+        if (!result.isEmpty())
+            DB.putFileHash(path, size, modified, result);
+    }
+    return result;
+}
+
+void FileHashService::finish(const QString& path, const QString& hash)
+{
+    m_mutex.lock();
+    if (!hash.isEmpty())
+        m_hashes.insert(path, hash);
+    QList<Mlt::Properties*> requests = m_pending.take(path);
+    m_mutex.unlock();
+
+    foreach (Mlt::Properties* properties, requests) {
+        if (!hash.isEmpty())
+            properties->set(kShotcutHashProperty, hash.toLatin1().constData());
+        delete properties;
+    }
+    if (hash.isEmpty())
+        LOG_DEBUG() << "failed to hash" << path;
+    else
+        emit hashReady(path, hash);
+}
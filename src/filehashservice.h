@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILEHASHSERVICE_H
+#define FILEHASHSERVICE_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <MltProperties.h>
+
+/*!
+  \class FileHashService
+  \brief The FileHashService computes the file hashes that identify media.
+
+  \threadsafe
+
+  Hashing reads the head and the tail of a file, which can take a long time
+  on network storage, so it is done on a small pool of its own threads.
+  Hashes are remembered in the database by path, size, and modification
+  time, and a file is only read again when one of those changes.
+
+  request() returns at once. When the hash of a file is ready it is set as
+  the shotcut:hash property of every Mlt::Properties that requested it and
+  hashReady() is emitted.
+*/
+
+class FileHashService : public QObject
+{
+    Q_OBJECT
+    explicit FileHashService(QObject* parent = 0);
+
+public:
+    static FileHashService& singleton();
+
+    /*!
+      Returns the hash of the file at \a path if it is known. Otherwise, it
+      starts hashing it and returns an empty string; the hash is set on
+      \a properties when it is ready.
+    */
+    QString request(const QString& path, Mlt::Properties& properties);
+
+    /*!
+      Returns the hash of the file at \a path if it was hashed or looked up
+      before, otherwise an empty string. It reads neither the file nor the
+      database, so it is cheap enough for the GUI thread.
+    */
+    QString knownHash(const QString& path);
+
+    //! Returns the hash of the file at \a path, waiting for it if needed.
+    QString hash(const QString& path);
+
+    //! Reads the file and computes its hash.
+    static QString computeHash(const QString& path);
+
+signals:
+    void hashReady(const QString& path, const QString& hash);
+
+private:
+    friend class FileHashTask;
+    QString lookup(const QString& path);
+    void finish(const QString& path, const QString& hash);
+
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    QHash<QString, QString> m_hashes;
+    QHash<QString, QList<Mlt::Properties*> > m_pending;
+};
+
+#endif // FILEHASHSERVICE_H
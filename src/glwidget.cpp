@@ -277,9 +277,11 @@ void GLWidget::createShader()
 
 static void uploadTextures(QOpenGLContext* context, SharedFrame& frame, GLuint texture[])
 {
-    int width = frame.get_image_width();
-    int height = frame.get_image_height();
-    const uint8_t* image = frame.get_image();
+    // The plane views point straight into the frame's image buffer, so the
+    // planes are handed to GL without an intermediate copy.
+    SharedFramePlane y = frame.get_plane(SharedFramePlane::PlaneY);
+    SharedFramePlane u = frame.get_plane(SharedFramePlane::PlaneU);
+    SharedFramePlane v = frame.get_plane(SharedFramePlane::PlaneV);
     QOpenGLFunctions* f = context->functions();
 
     // Upload each plane of YUV to a texture.
@@ -299,8 +301,8 @@ static void uploadTextures(QOpenGLContext* context, SharedFrame& frame, GLuint t
     check_error(f);
     f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     check_error(f);
-    f->glTexImage2D   (GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0,
-                    GL_LUMINANCE, GL_UNSIGNED_BYTE, image);
+    f->glTexImage2D   (GL_TEXTURE_2D, 0, GL_LUMINANCE, y.width(), y.height(), 0,
+                    GL_LUMINANCE, GL_UNSIGNED_BYTE, y.data());
     check_error(f);
 
     f->glBindTexture  (GL_TEXTURE_2D, texture[1]);
@@ -313,8 +315,8 @@ static void uploadTextures(QOpenGLContext* context, SharedFrame& frame, GLuint t
     check_error(f);
     f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     check_error(f);
-    f->glTexImage2D   (GL_TEXTURE_2D, 0, GL_LUMINANCE, width/2, height/2, 0,
-                    GL_LUMINANCE, GL_UNSIGNED_BYTE, image + width * height);
+    f->glTexImage2D   (GL_TEXTURE_2D, 0, GL_LUMINANCE, u.width(), u.height(), 0,
+                    GL_LUMINANCE, GL_UNSIGNED_BYTE, u.data());
     check_error(f);
 
     f->glBindTexture  (GL_TEXTURE_2D, texture[2]);
@@ -327,8 +329,8 @@ static void uploadTextures(QOpenGLContext* context, SharedFrame& frame, GLuint t
     check_error(f);
     f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     check_error(f);
-    f->glTexImage2D   (GL_TEXTURE_2D, 0, GL_LUMINANCE, width/2, height/2, 0,
-                    GL_LUMINANCE, GL_UNSIGNED_BYTE, image + width * height + width/2 * height/2);
+    f->glTexImage2D   (GL_TEXTURE_2D, 0, GL_LUMINANCE, v.width(), v.height(), 0,
+                    GL_LUMINANCE, GL_UNSIGNED_BYTE, v.data());
     check_error(f);
 }
 
@@ -18,6 +18,7 @@
 
 #include "jobqueue.h"
 #include <QtWidgets>
+#include <QThread>
 #include <Logger.h>
 #include "mainwindow.h"
 #include "settings.h"
@@ -110,23 +111,84 @@ void JobQueue::onFinished(AbstractJob* job, bool isSuccess)
     startNextJob();
 }
 
+// Returns the number of cores that the job is expected to keep busy.
+static int jobThreads(const AbstractJob* job, int cores)
+{
+    int threads = job->threads();
+    return (threads <= 0 || threads > cores)? cores : threads;
+}
+
 void JobQueue::startNextJob()
 {
     if (m_paused) return;
-    QMutexLocker locker(&m_mutex);
-    if (!m_jobs.isEmpty()) {
-        foreach(AbstractJob* job, m_jobs) {
-            // if there is already a job started or running, then exit
-            if (job->ran() && job->state() != QProcess::NotRunning)//开启多任务运行则此处需要注释掉
+    QList<AbstractJob*> failed;
+    QList<AbstractJob*> removed;
+    {
+        QMutexLocker locker(&m_mutex);
+        const int cores = QThread::idealThreadCount();
+        // A limit set by the user replaces the core budget.
+        int maxRunning = Settings.jobsMaxConcurrent();
+        const bool isBudgeted = maxRunning <= 0;
+        if (isBudgeted)
+            maxRunning = cores;
+        int running = 0;
+        int busyThreads = 0;
+        foreach (AbstractJob* job, m_jobs) {
+            if (job->ran() && job->state() != QProcess::NotRunning) {
+                ++running;
+                busyThreads += jobThreads(job, cores);
+            }
+        }
+        while (running < maxRunning) {
+            // Pick the first pending job with the highest priority whose
+            // dependencies, e.g. the first pass of a two-pass encode, are done.
+            AbstractJob* next = 0;
+            foreach (AbstractJob* job, m_jobs) {
+                if (job->ran() || failed.contains(job) || removed.contains(job))
+                    continue;
+                bool isReady = true;
+                foreach (AbstractJob* dependency, job->dependencies()) {
+                    if (!dependency) {
+                        // e.g. a removed first pass or segment
+                        removed << job;
+                        isReady = false;
+                        break;
+                    } else if (!dependency->ran() || dependency->state() != QProcess::NotRunning) {
+                        isReady = false;
+                    } else if (!dependency->succeeded()) {
+                        failed << job;
+                        isReady = false;
+                        break;
+                    }
+                }
+                if (!isReady)
+                    continue;
+                if (!next || job->priority() > next->priority())
+                    next = job;
+            }
+            if (!next)
                 break;
-            // otherwise, start first non-started job and exit
-            if (!job->ran()) {
-                emit signal_Start();
-                job->start();
+            // Always run one job, but do not oversubscribe the cores. Waiting
+            // here instead of starting a smaller job keeps big jobs from starving.
+            int threads = jobThreads(next, cores);
+            if (isBudgeted && running > 0 && busyThreads + threads > cores)
                 break;
-            }
+            emit signal_Start();
+            next->start();
+            ++running;
+            busyThreads += threads;
         }
     }
+    // This re-enters startNextJob() through onFinished(), which may already
+    // have failed the jobs that are still in these lists.
+    foreach (AbstractJob* job, failed) {
+        if (!job->ran())
+            job->fail(tr("The job it depends on did not succeed."));
+    }
+    foreach (AbstractJob* job, removed) {
+        if (!job->ran())
+            job->fail(tr("The job it depends on was removed."));
+    }
 }
 
 AbstractJob* JobQueue::jobFromIndex(const QModelIndex& index) const
@@ -145,6 +207,12 @@ void JobQueue::resume()
     startNextJob();
 }
 
+void JobQueue::setMaxConcurrent(int n)
+{
+    Settings.setJobsMaxConcurrent(n);
+    startNextJob();
+}
+
 bool JobQueue::isPaused() const
 {
     return m_paused;
@@ -171,4 +239,6 @@ void JobQueue::remove(const QModelIndex& index)
 
     m_mutex.unlock();
     emit signal_Finished(false);
+    // Fail the jobs that depended on it.
+    startNextJob();
 }
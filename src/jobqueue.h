@@ -23,6 +23,18 @@
 #include <QStandardItemModel>
 #include <QMutex>
 
+/*!
+  \class JobQueue
+  \brief The JobQueue runs the queued jobs, several at a time.
+
+  Jobs are started by priority and then in the order they were added. A job
+  is admitted while the cores kept busy by the running jobs, according to
+  their AbstractJob::threads(), leave room for it, but at least one job
+  always runs. If Settings.jobsMaxConcurrent() is set, it replaces that
+  budget as the number of jobs that may run at once. A job with dependencies waits until they have finished and fails if
+  one of them did not succeed or was removed from the queue.
+*/
+
 class JobQueue : public QStandardItemModel
 {
     Q_OBJECT
@@ -47,6 +59,8 @@ public:
     bool isPaused() const;
     bool hasIncomplete() const;
     void remove(const QModelIndex& index);
+    //! Sets Settings.jobsMaxConcurrent() and starts the jobs it now admits.
+    void setMaxConcurrent(int n);
 
 signals:
     void jobAdded();
@@ -18,17 +18,29 @@
 
 #include "abstractjob.h"
 #include <QApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
 #include <QTimer>
 #include <Logger.h>
 #ifdef Q_OS_WIN
 #include <windows.h>
 #endif
 
+static const int kMaxLogEntries = 5000;
+static const int kMaxProgressSamples = 1024;
+static const int kProgressSampleMs = 1000;
+
 AbstractJob::AbstractJob(const QString& name)
     : QProcess(0)
     , m_item(0)
     , m_ran(false)
     , m_killed(false)
+    , m_succeeded(false)
+    , m_threads(0)
+    , m_priority(NormalPriority)
+    , m_droppedLogEntries(0)
+    , m_sampleInterval(kProgressSampleMs)
     , m_label(name)
 {
     setObjectName(name);
@@ -40,6 +52,9 @@ AbstractJob::AbstractJob(const QString& name)
 void AbstractJob::start()
 {
     m_ran = true;
+    m_succeeded = false;
+    m_samples.clear();
+    m_sampleInterval = kProgressSampleMs;
     m_time.start();
     emit progressUpdated(m_item, 0);
 }
@@ -66,12 +81,85 @@ bool AbstractJob::stopped() const
 
 void AbstractJob::appendToLog(const QString& s)
 {
+    // Keep only the most recent messages so that a chatty job cannot grow
+    // without bound.
     m_log.append(s);
+    if (m_log.size() > kMaxLogEntries) {
+        m_log.removeFirst();
+        ++m_droppedLogEntries;
+    }
 }
 
 QString AbstractJob::log() const
 {
-    return m_log;
+    QString result;
+    if (m_droppedLogEntries)
+        result = QString("[%1 earlier messages were dropped]\n").arg(m_droppedLogEntries);
+    return result + m_log.join(QString());
+}
+
+bool AbstractJob::saveProgressSamples(const QString& fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+    QTextStream stream(&file);
+    stream << "elapsed_seconds,frame,percent,fps,speed,bytes,remaining_seconds\n";
+    foreach (const ProgressSample& sample, m_samples) {
+        stream << QString::number(sample.elapsed / 1000.0, 'f', 3) << ','
+               << sample.frame << ','
+               << sample.percent << ','
+               << QString::number(sample.fps, 'f', 2) << ','
+               << QString::number(sample.speed, 'f', 3) << ','
+               << sample.bytes << ','
+               << sample.remaining << '\n';
+    }
+    stream.flush();
+    return file.error() == QFile::NoError;
+}
+
+void AbstractJob::sampleProgress(int frame, int percent, double frameRate)
+{
+    const int elapsed = m_time.elapsed();
+    ProgressSample previous = {0, 0, 0, 0.0, 0.0, 0, -1};
+    if (!m_samples.isEmpty()) {
+        previous = m_samples.last();
+        if (elapsed - previous.elapsed < m_sampleInterval)
+            return;
+    }
+    if (m_samples.size() == kMaxProgressSamples) {
+        // Keep every other sample and sample half as often from now on, so
+        // the samples still cover the whole run.
+        for (int i = 0; i < kMaxProgressSamples / 2; i++)
+            m_samples[i] = m_samples[i * 2 + 1];
+        m_samples.resize(kMaxProgressSamples / 2);
+        m_sampleInterval *= 2;
+    }
+
+    ProgressSample sample;
+    sample.elapsed = elapsed;
+    sample.frame = frame;
+    sample.percent = percent;
+    sample.fps = (elapsed > previous.elapsed)?
+        (frame - previous.frame) * 1000.0 / (elapsed - previous.elapsed) : 0.0;
+    sample.speed = (frameRate > 0.0)? sample.fps / frameRate : 0.0;
+    sample.bytes = QFileInfo(objectName()).size();
+    sample.remaining = -1;
+    if (percent > 0 && sample.fps > 0.0) {
+        double total = frame * 100.0 / percent;
+        sample.remaining = qMax(0, qRound((total - frame) / sample.fps));
+    }
+    m_samples << sample;
+    emit progressSampled(this);
+}
+
+QList<AbstractJob*> AbstractJob::dependencies() const
+{
+    QList<AbstractJob*> result;
+    // Removed jobs are returned as null so that the dependent job fails.
+    foreach (AbstractJob* job, m_dependencies)
+        result << job;
+    return result;
 }
 
 void AbstractJob::setLabel(const QString &label)
@@ -97,22 +185,31 @@ void AbstractJob::stop()
     m_killed = true;
 }
 
+void AbstractJob::fail(const QString& reason)
+{
+    LOG_INFO() << "job failed:" << reason;
+    m_ran = true;
+    appendToLog(reason + '\n');
+    emit finished(this, false);
+}
+
 void AbstractJob::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
-    m_log.append(readAll());
+    appendToLog(readAll());
     const QTime& time = QTime::fromMSecsSinceStartOfDay(m_time.elapsed());
     if (exitStatus == QProcess::NormalExit && exitCode == 0 && !m_killed) {
         LOG_INFO() << "job succeeeded";
-        m_log.append(QString("Completed successfully in %1\n").arg(time.toString()));
+        appendToLog(QString("Completed successfully in %1\n").arg(time.toString()));
+        m_succeeded = true;
         emit progressUpdated(m_item, 100);
         emit finished(this, true);
     } else if (m_killed) {
         LOG_INFO() << "job stopped";
-        m_log.append(QString("Stopped by user at %1\n").arg(time.toString()));
+        appendToLog(QString("Stopped by user at %1\n").arg(time.toString()));
         emit finished(this, false);
     } else {
         LOG_INFO() << "job failed with" << exitCode;
-        m_log.append(QString("Failed with exit code %1\n").arg(exitCode));
+        appendToLog(QString("Failed with exit code %1\n").arg(exitCode));
         emit finished(this, false);
     }
 }
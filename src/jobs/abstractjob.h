@@ -22,7 +22,10 @@
 #include <QProcess>
 #include <QModelIndex>
 #include <QList>
+#include <QStringList>
+#include <QVector>
 #include <QTime>
+#include <QPointer>
 
 class QAction;
 class QStandardItem;
@@ -31,6 +34,23 @@ class AbstractJob : public QProcess
 {
     Q_OBJECT
 public:
+    enum Priority {
+        LowPriority = -1,
+        NormalPriority = 0,
+        HighPriority = 1
+    };
+
+    //! A measurement of the throughput of a running job.
+    struct ProgressSample {
+        int elapsed;    //!< milliseconds since the job started
+        int frame;      //!< current frame
+        int percent;
+        double fps;     //!< frames per second since the previous sample
+        double speed;   //!< fps relative to the frame rate of the output
+        qint64 bytes;   //!< size of the output file
+        int remaining;  //!< estimated seconds left, -1 if unknown
+    };
+
     explicit AbstractJob(const QString& name);
     virtual ~AbstractJob() {}
 
@@ -46,20 +66,51 @@ public:
     QList<QAction*> successActions() const { return m_successActions; }
     QTime estimateRemaining(int percent);
     QTime time() const { return m_time; }
+    bool succeeded() const { return m_succeeded; }
+
+    /*!
+      Returns the progress samples of the current or last run. The number of
+      samples is bounded; long runs are sampled less often.
+    */
+    QVector<ProgressSample> progressSamples() const { return m_samples; }
+    //! Writes the progress samples to \a fileName as CSV.
+    bool saveProgressSamples(const QString& fileName) const;
+
+    //! Returns the number of cores the job keeps busy, or 0 for all of them.
+    int threads() const { return m_threads; }
+    void setThreads(int threads) { m_threads = threads; }
+    //! Pending jobs with a higher priority are started first.
+    int priority() const { return m_priority; }
+    void setPriority(int priority) { m_priority = priority; }
+    /*!
+      The job is only started after all of these have finished successfully.
+      A dependency that was removed from the queue is null and fails the job.
+    */
+    QList<AbstractJob*> dependencies() const;
+    void addDependency(AbstractJob* job) { m_dependencies << job; }
 
 public slots:
     virtual void start();
     virtual void stop();
+    //! Finishes a job that has not been started as failed.
+    void fail(const QString& reason);
 
 signals:
     void progressUpdated(QStandardItem* item, int percent);
     void finished(AbstractJob* job, bool isSuccess);
+    void progressSampled(AbstractJob* job);
 
 protected:
     QList<QAction*> m_standardActions;
     QList<QAction*> m_successActions;
     QStandardItem*  m_item;
 
+    /*!
+      Records the progress at \a frame if the sampling interval has passed.
+      \a frameRate is the frame rate of the output.
+    */
+    void sampleProgress(int frame, int percent, double frameRate);
+
 protected slots:
     virtual void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
     virtual void onReadyRead();
@@ -68,7 +119,14 @@ protected slots:
 private:
     bool m_ran;
     bool m_killed;
-    QString m_log;
+    bool m_succeeded;
+    int m_threads;
+    int m_priority;
+    QList<QPointer<AbstractJob> > m_dependencies;
+    QStringList m_log;
+    int m_droppedLogEntries;
+    QVector<ProgressSample> m_samples;
+    int m_sampleInterval;
     QString m_label;
     QTime m_time;
 };
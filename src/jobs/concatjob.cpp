@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "concatjob.h"
+#include "util.h"
+#include <QFile>
+#include <QDir>
+#include <QTextStream>
+#include <Logger.h>
+
+ConcatJob::ConcatJob(const QString& target, const QString& directory, const QStringList& segments,
+                     const QString& audio)
+    : FfmpegJob(target, arguments(target, directory, audio), false)
+    , m_directory(directory)
+    , m_segments(segments)
+{
+    setLabel(tr("Join %1").arg(Util::baseName(target)));
+}
+
+ConcatJob::~ConcatJob()
+{
+    removeDirectory();
+}
+
+void ConcatJob::start()
+{
+    QFile list(listFileName(m_directory));
+    if (list.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QTextStream stream(&list);
+        stream.setCodec("UTF-8");
+        foreach (const QString& segment, m_segments) {
+            QString path = QDir::fromNativeSeparators(segment);
+            stream << "file '" << path.replace("'", "'\\''") << "'\n";
+        }
+    } else {
+        LOG_WARNING() << "failed to write the concat list" << list.fileName();
+    }
+    FfmpegJob::start();
+}
+
+QString ConcatJob::listFileName(const QString& directory)
+{
+    return QDir(directory).filePath("concat.txt");
+}
+
+QStringList ConcatJob::arguments(const QString& target, const QString& directory, const QString& audio)
+{
+    QStringList args;
+    args << "-hide_banner";
+    args << "-f" << "concat";
+    args << "-safe" << "0";
+    args << "-i" << listFileName(directory);
+    if (audio.isEmpty()) {
+        args << "-map" << "0";
+    } else {
+        args << "-i" << audio;
+        args << "-map" << "0:v" << "-map" << "1:a";
+    }
+    args << "-c" << "copy";
+    args << "-y" << target;
+    return args;
+}
+
+void ConcatJob::removeDirectory()
+{
+    if (m_directory.isEmpty() || !QDir(m_directory).exists())
+        return;
+    if (!QDir(m_directory).removeRecursively())
+        LOG_WARNING() << "failed to remove the segments in" << m_directory;
+}
+
+void ConcatJob::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    // Keep the segments of a stopped job for when it is run again.
+    if (!stopped())
+        removeDirectory();
+    FfmpegJob::onFinished(exitCode, exitStatus);
+}
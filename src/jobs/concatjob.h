@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONCATJOB_H
+#define CONCATJOB_H
+
+#include "ffmpegjob.h"
+
+/*!
+  \class ConcatJob
+  \brief The ConcatJob joins the segments of a segmented export into the
+  target file without re-encoding.
+
+  It runs the ffmpeg concat demuxer with stream copy over the segments in
+  order. When the audio was rendered separately, its file is muxed in as
+  the audio stream.
+
+  The segments and the audio are kept in a \a directory of their own, which
+  is removed when the target has been written, when joining fails, or when
+  the job is removed. A stopped job keeps it so that it can be run again.
+*/
+
+class ConcatJob : public FfmpegJob
+{
+    Q_OBJECT
+public:
+    ConcatJob(const QString& target, const QString& directory, const QStringList& segments,
+              const QString& audio = QString());
+    ~ConcatJob();
+    void start();
+
+protected slots:
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    static QString listFileName(const QString& directory);
+    static QStringList arguments(const QString& target, const QString& directory, const QString& audio);
+    void removeDirectory();
+
+    QString m_directory;
+    QStringList m_segments;
+};
+
+#endif // CONCATJOB_H
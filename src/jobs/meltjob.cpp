@@ -25,15 +25,35 @@
 #include <QAction>
 #include <QDialog>
 #include <QDir>
+#include <QDomDocument>
 #include <Logger.h>
 #include "mainwindow.h"
 #include "dialogs/textviewerdialog.h"
 
+// Returns the frame rate of the output of the MLT XML \a xml: that of the
+// consumer if it sets one, otherwise that of the profile.
+static double outputFrameRate(const QString& xml)
+{
+    QDomDocument dom;
+    if (!dom.setContent(xml))
+        return 0.0;
+    QDomElement root = dom.documentElement();
+    QDomElement elements[] = { root.firstChildElement("consumer"), root.firstChildElement("profile") };
+    for (int i = 0; i < 2; i++) {
+        int num = elements[i].attribute("frame_rate_num").toInt();
+        int den = elements[i].attribute("frame_rate_den").toInt();
+        if (num > 0 && den > 0)
+            return double(num) / den;
+    }
+    return 0.0;
+}
+
 MeltJob::MeltJob(const QString& name, const QString& xml)
     : AbstractJob(name)
     , m_xml(QDir::tempPath().append("/shotcut-XXXXXX.mlt"))
     , m_isStreaming(false)
     , m_previousPercent(0)
+    , m_frameRate(outputFrameRate(xml))
 {
     QAction* action = new QAction(tr("View XML"), this);
     action->setToolTip(tr("View the MLT XML for this job"));
@@ -97,15 +117,26 @@ void MeltJob::onViewXmlTriggered()
 
 void MeltJob::onReadyRead()
 {
-    QString msg = readLine();
-    if (msg.contains("percentage:")) {
-        int percent = msg.mid(msg.indexOf("percentage:") + 11).toInt();
-        if (percent != m_previousPercent) {
-            emit progressUpdated(m_item, percent);
-            m_previousPercent = percent;
+    // qmelt is the melt command line tool of MLT, which is built outside of
+    // this project, and its only progress output is the fixed-format
+    // "Current Frame: %10d, percentage: %10d" line of -progress2 on stderr.
+    // That line is the progress channel; the encoded bytes come from the
+    // size of the target file (see sampleProgress()).
+    // Consume every complete line; one readyRead() may deliver many.
+    while (canReadLine()) {
+        QString msg = readLine();
+        if (msg.startsWith("Current Frame:")) {
+            int comma = msg.indexOf(',');
+            int frame = msg.mid(14, comma - 14).trimmed().toInt();
+            int percent = msg.mid(msg.indexOf("percentage:", comma) + 11).trimmed().toInt();
+            sampleProgress(frame, percent, m_frameRate);
+            if (percent != m_previousPercent) {
+                emit progressUpdated(m_item, percent);
+                m_previousPercent = percent;
+            }
+        }
+        else {
+            appendToLog(msg);
         }
-    }
-    else {
-        appendToLog(msg);
     }
 }
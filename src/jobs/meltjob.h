@@ -41,6 +41,7 @@ private:
     QTemporaryFile m_xml;
     bool m_isStreaming;
     int m_previousPercent;
+    double m_frameRate;
 };
 
 #endif // MELTJOB_H
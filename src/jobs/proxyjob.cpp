@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "proxyjob.h"
+#include "util.h"
+#include <QFile>
+#include <Logger.h>
+
+// Decoding is what a proxy saves, so it does not need many threads to make.
+static const int kProxyThreads = 2;
+
+ProxyJob::ProxyJob(const QString& source, const QString& target, const QString& hash, int height)
+    : FfmpegJob(target, arguments(source, target, height), false)
+    , m_source(source)
+    , m_target(target)
+    , m_hash(hash)
+{
+    setLabel(tr("Make proxy for %1").arg(Util::baseName(source)));
+    setPriority(LowPriority);
+    setThreads(kProxyThreads);
+}
+
+QString ProxyJob::partialFileName(const QString& target)
+{
+    return target + ".part";
+}
+
+QStringList ProxyJob::arguments(const QString& source, const QString& target, int height)
+{
+    QStringList args;
+    args << "-hide_banner";
+    args << "-i" << source;
+    args << "-map" << "0:v:0" << "-map" << "0:a?";
+    args << "-vf" << QString("scale=-2:%1").arg(height);
+    args << "-c:v" << "mjpeg" << "-q:v" << "5" << "-pix_fmt" << "yuvj422p";
+    args << "-c:a" << "pcm_s16le";
+    args << "-threads" << QString::number(kProxyThreads);
+    args << "-f" << "mov";
+    args << "-y" << partialFileName(target);
+    return args;
+}
+
+void ProxyJob::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    const QString partial = partialFileName(m_target);
+    if (exitStatus == QProcess::NormalExit && exitCode == 0) {
+        QFile::remove(m_target);
+        if (!QFile::rename(partial, m_target)) {
+            LOG_WARNING() << "failed to rename" << partial << "to" << m_target;
+            exitCode = 1;
+        }
+    } else {
+        QFile::remove(partial);
+    }
+    FfmpegJob::onFinished(exitCode, exitStatus);
+}
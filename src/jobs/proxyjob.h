@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROXYJOB_H
+#define PROXYJOB_H
+
+#include "ffmpegjob.h"
+
+/*!
+  \class ProxyJob
+  \brief The ProxyJob transcodes a media file into a small intra-frame
+  proxy for playback.
+
+  The proxy keeps the frame rate and all audio streams of the source but is
+  scaled down to \a height lines and coded as Motion JPEG, which decodes
+  quickly at any frame. It is written to a temporary file that only replaces
+  \a target once it is complete.
+*/
+
+class ProxyJob : public FfmpegJob
+{
+    Q_OBJECT
+public:
+    ProxyJob(const QString& source, const QString& target, const QString& hash, int height);
+
+    QString source() const { return m_source; }
+    QString target() const { return m_target; }
+    QString hash() const { return m_hash; }
+
+protected slots:
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    static QString partialFileName(const QString& target);
+    static QStringList arguments(const QString& source, const QString& target, int height);
+
+    QString m_source;
+    QString m_target;
+    QString m_hash;
+};
+
+#endif // PROXYJOB_H
@@ -59,6 +59,9 @@
 #include "settings.h"
 #include "leapnetworklistener.h"
 #include "database.h"
+#include "filehashservice.h"
+#include "proxymanager.h"
+#include "playlistimporter.h"
 #include "widgets/gltestwidget.h"
 #include "docks/timelinedock.h"
 #include "widgets/lumamixtransition.h"
@@ -107,6 +110,8 @@ static bool eventDebugCallback(void **data)
 }
 
 static const int AUTOSAVE_TIMEOUT_MS = 10000;
+static const int AUTOSAVE_SNAPSHOT_INTERVAL_MS = 5 * 60 * 1000;
+static const qint64 AUTOSAVE_MAX_JOURNAL_BYTES = 16 * 1024 * 1024;
 
 MainWindow::MainWindow()
     : QMainWindow(0)
@@ -117,6 +122,9 @@ MainWindow::MainWindow()
     , m_keyerGroup(0)
     , m_keyerMenu(0)
     , m_isPlaylistLoaded(false)
+    , m_autosaveNeedsSnapshot(true)
+    , m_autosaveTrackChanged(false)
+    , m_autosaveJournalBytes(0)
     , m_exitCode(EXIT_SUCCESS)
     , m_navigationPosition(0)
     , m_upgradeUrl("http://www.hzlh.com")
@@ -571,12 +579,8 @@ bool MainWindow::saveRepairedXmlFile(MltXmlChecker& checker, QString& fileName)
                    .arg(fi.completeBaseName()).arg(tr("Repaired")).arg(fi.suffix()));
     repaired.open(QIODevice::WriteOnly);
     LOG_INFO() << "repaired MLT XML file name" << repaired.fileName();
-    QFile temp(checker.tempFileName());
-    if (temp.exists() && repaired.exists()) {
-        temp.open(QIODevice::ReadOnly);
-        QByteArray xml = temp.readAll();
-        temp.close();
-
+    QByteArray xml = checker.correctedXml();
+    if (!xml.isEmpty() && repaired.exists()) {
         qint64 n = repaired.write(xml);
         while (n > 0 && n < xml.size()) {
             qint64 x = repaired.write(xml.right(xml.size() - n));
@@ -659,6 +663,9 @@ bool MainWindow::checkAutoSave(QString &url)
             if (!stale->open(QIODevice::ReadWrite)) {
                 LOG_WARNING() << "failed to recover autosave file" << url;
             } else {
+                // Bring the snapshot up to date with the edits journaled since.
+                if (!stale->replayJournal())
+                    LOG_WARNING() << "failed to replay autosave journal" << stale->journalFileName();
                 m_autosaveFile = stale;
                 url = stale->fileName();
                 return true;
@@ -682,13 +689,42 @@ void MainWindow::doAutosave()
     QMutexLocker locker(&m_autosaveMutex);
     if (m_autosaveFile) {
         if (m_autosaveFile->isOpen() || m_autosaveFile->open(QIODevice::ReadWrite)) {
-            saveXML(m_autosaveFile->fileName(), false /* without relative paths */);
+            // Write the snapshot aside so that a crash never leaves a partial file.
+            saveXML(m_autosaveFile->snapshotFileName(), false /* without relative paths */);
+            if (!m_autosaveFile->commitSnapshot())
+                LOG_ERROR() << "failed to commit autosave snapshot" << m_autosaveFile->fileName();
         } else {
             LOG_ERROR() << "failed to open autosave file for writing" << m_autosaveFile->fileName();
         }
     }
 }
 
+void MainWindow::doAutosaveJournal(const QList<int>& tracks)
+{
+    QMutexLocker locker(&m_autosaveMutex);
+    if (m_autosaveFile) {
+        if (!m_autosaveFile->hasSnapshot()) {
+            // There is nothing to journal against, for example after Save As.
+            locker.unlock();
+            doAutosave();
+            return;
+        }
+        // Serialize the changed tracks here, like saveXML() in doAutosave(),
+        // to keep the GUI thread free.
+        foreach (int index, tracks) {
+            QScopedPointer<Mlt::Producer> track(multitrack() ? multitrack()->track(index) : 0);
+            if (!track || !track->is_valid())
+                continue;
+            QByteArray xml = MLT.XML(track.data()).toUtf8();
+            m_autosaveJournalBytes.fetchAndAddOrdered(xml.size());
+            if (!m_autosaveFile->appendTrack(index, xml)) {
+                LOG_ERROR() << "failed to append to autosave journal" << m_autosaveFile->journalFileName();
+                break;
+            }
+        }
+    }
+}
+
 void MainWindow::setFullScreen(bool isFullScreen)
 {
     if (isFullScreen) {
@@ -717,23 +753,7 @@ QString MainWindow::untitledFileName() const
 
 QString MainWindow::getFileHash(const QString& path) const
 {
-    // This routine is intentionally copied from Kdenlive.
-    QFile file(path);
-    if (file.open(QIODevice::ReadOnly)) {
-        QByteArray fileData;
-        // 1 MB = 1 second per 450 files (or faster)
-        // 10 MB = 9 seconds per 450 files (or faster)
-        if (file.size() > 1000000*2) {
-            fileData = file.read(1000000);
-            if (file.seek(file.size() - 1000000))
-                fileData.append(file.readAll());
-        } else {
-            fileData = file.readAll();
-        }
-        file.close();
-        return QCryptographicHash::hash(fileData, QCryptographicHash::Md5).toHex();
-    }
-    return QString();
+    return FileHashService::singleton().hash(path);
 }
 
 QString MainWindow::getHash(Mlt::Properties& properties) const
@@ -747,7 +767,9 @@ QString MainWindow::getHash(Mlt::Properties& properties) const
             resource = QString::fromUtf8(properties.get("warp_resource"));
         else if (service == "vidstab")
             resource = QString::fromUtf8(properties.get("filename"));
-        QString hash = getFileHash(resource);
+        // This does not wait for the file to be read. If the hash is not
+        // known yet, it is set on the properties when it is ready.
+        hash = FileHashService::singleton().request(resource, properties);
         if (!hash.isEmpty())
             properties.set(kShotcutHashProperty, hash.toLatin1().constData());
     }
@@ -800,10 +822,36 @@ static void autosaveTask(MainWindow* p)
     p->doAutosave();
 }
 
+static void autosaveJournalTask(MainWindow* p, QList<int> tracks)
+{
+    LOG_DEBUG() << "journaling" << tracks.size() << "tracks";
+    p->doAutosaveJournal(tracks);
+}
+
 void MainWindow::onAutosaveTimeout()
 {
-    if (isWindowModified())
-        QtConcurrent::run(autosaveTask, this);
+    if (!isWindowModified())
+        return;
+    if (m_autosaveNeedsSnapshot || !multitrack()
+            || !m_autosaveSnapshotTime.isValid()
+            || m_autosaveSnapshotTime.elapsed() > AUTOSAVE_SNAPSHOT_INTERVAL_MS
+            || m_autosaveJournalBytes.load() > AUTOSAVE_MAX_JOURNAL_BYTES) {
+        // A compacted snapshot also clears the journal.
+        m_autosaveNeedsSnapshot = false;
+        m_autosaveDirtyTracks.clear();
+        m_autosaveJournalBytes.store(0);
+        m_autosaveSnapshotTime.start();
+        QtConcurrent::run(&m_autosavePool, autosaveTask, this);
+    } else if (!m_autosaveDirtyTracks.isEmpty()) {
+        QList<int> tracks;
+        const QList<Track>& trackList = m_timelineDock->model()->trackList();
+        foreach (int i, m_autosaveDirtyTracks) {
+            if (i < trackList.size())
+                tracks << trackList[i].mlt_index;
+        }
+        m_autosaveDirtyTracks.clear();
+        QtConcurrent::run(&m_autosavePool, autosaveJournalTask, this, tracks);
+    }
 }
 
 void MainWindow::updateAutoSave()
@@ -859,6 +907,8 @@ void MainWindow::open(QString url, const Mlt::Properties* properties)
             setAudioChannels(MLT.audioChannels());
 
         open(MLT.producer());
+        if (MLT.isClip())
+            ProxyManager::singleton().generate(*MLT.producer());
         if (url.startsWith(AutoSaveFile::path())) {
             if (m_autosaveFile && m_autosaveFile->managedFileName() != untitledFileName()) {
                 m_recentDock->add(m_autosaveFile->managedFileName());
@@ -1008,6 +1058,7 @@ void MainWindow::readPlayerSettings()
     ui->actionRealtime->setChecked(Settings.playerRealtime());
     ui->actionProgressive->setChecked(Settings.playerProgressive());
     ui->actionScrubAudio->setChecked(Settings.playerScrubAudio());
+    ui->actionUseProxy->setChecked(ProxyManager::singleton().isEnabled());
     if (ui->actionJack)
         ui->actionJack->setChecked(Settings.playerJACK());
     if (ui->actionGPU) {
@@ -2467,6 +2518,7 @@ void MainWindow::onPlaylistLoaded()
 
 void MainWindow::onPlaylistCleared()
 {
+    m_autosaveNeedsSnapshot = true;
     m_player->onTabBarClicked(Player::SourceTabIndex);
     setWindowModified(true);
 }
@@ -2486,6 +2538,7 @@ void MainWindow::onPlaylistClosed()
 
 void MainWindow::onPlaylistModified()
 {
+    m_autosaveNeedsSnapshot = true;
     setWindowModified(true);
     if (MLT.producer() && playlist() && (void*) MLT.producer()->get_producer() == (void*) playlist()->get_playlist())
         m_player->onDurationChanged();
@@ -2515,6 +2568,46 @@ void MainWindow::onMultitrackClosed()
 void MainWindow::onMultitrackModified()
 {
     setWindowModified(true);
+    // A change that was not attributed to a track needs a full snapshot.
+    if (!m_autosaveTrackChanged)
+        m_autosaveNeedsSnapshot = true;
+    m_autosaveTrackChanged = false;
+}
+
+void MainWindow::onMultitrackRowsChanged(const QModelIndex& parent)
+{
+    if (parent.isValid())
+        m_autosaveDirtyTracks << parent.row();
+    else
+        m_autosaveNeedsSnapshot = true;
+    m_autosaveTrackChanged = true;
+}
+
+void MainWindow::onMultitrackRowsMoved(const QModelIndex& parent, int, int, const QModelIndex& destination)
+{
+    onMultitrackRowsChanged(parent);
+    onMultitrackRowsChanged(destination);
+}
+
+void MainWindow::onMultitrackDataChanged(const QModelIndex& topLeft, const QModelIndex&, const QVector<int>& roles)
+{
+    // Waveforms and file hashes are not saved in the project.
+    if (!roles.isEmpty()) {
+        bool saved = false;
+        foreach (int role, roles) {
+            if (role != MultitrackModel::AudioLevelsRole && role != MultitrackModel::FileHashRole)
+                saved = true;
+        }
+        if (!saved)
+            return;
+    }
+    // Track headers also change the tractor, e.g. compositing and blend modes.
+    onMultitrackRowsChanged(topLeft.parent());
+}
+
+void MainWindow::onMultitrackReset()
+{
+    m_autosaveNeedsSnapshot = true;
 }
 
 void MainWindow::onMultitrackDurationChanged()
@@ -2525,6 +2618,7 @@ void MainWindow::onMultitrackDurationChanged()
 
 void MainWindow::onCutModified()
 {
+    m_autosaveNeedsSnapshot = true;
     if (!playlist() && !multitrack()) {
         setWindowModified(true);
         updateAutoSave();
@@ -2535,6 +2629,7 @@ void MainWindow::onCutModified()
 
 void MainWindow::onFilterModelChanged()
 {
+    m_autosaveNeedsSnapshot = true;
     setWindowModified(true);
     updateAutoSave();
     if (playlist())
@@ -2967,40 +3062,6 @@ void MainWindow::changeInterpolation(bool checked, const char* method)
     Settings.setPlayerInterpolation(method);
 }
 
-class AppendTask : public QRunnable
-{
-public:
-    AppendTask(PlaylistModel* model, const QStringList& filenames)
-        : QRunnable()
-        , model(model)
-        , filenames(filenames)
-    {
-    }
-    void run()
-    {
-        foreach (QString filename, filenames) {
-            Mlt::Producer p(MLT.profile(), filename.toUtf8().constData());
-            if (p.is_valid()) {
-                // Convert avformat to avformat-novalidate so that XML loads faster.
-                if (!qstrcmp(p.get("mlt_service"), "avformat")) {
-                    p.set("mlt_service", "avformat-novalidate");
-                    p.set("mute_on_pause", 0);
-                }
-                if (QDir::toNativeSeparators(filename) == QDir::toNativeSeparators(MAIN.fileName())) {
-                    MAIN.showStatusMessage(QObject::tr("You cannot add a project to itself!"));
-                    continue;
-                }
-                MLT.setImageDurationFromDefault(&p);
-                MAIN.getHash(p);
-                MAIN.undoStack()->push(new Playlist::AppendCommand(*model, MLT.XML(&p)));
-            }
-        }
-    }
-private:
-    PlaylistModel* model;
-    const QStringList& filenames;
-};
-
 void MainWindow::processMultipleFiles()
 {
     if (m_multipleFiles.length() > 0) {
@@ -3008,7 +3069,16 @@ void MainWindow::processMultipleFiles()
         m_playlistDock->show();
         m_playlistDock->raise();
         emit Signal_raiseLoginwidget();
-        QThreadPool::globalInstance()->start(new AppendTask(model, m_multipleFiles));
+
+        PlaylistImporter* importer = new PlaylistImporter(*model, m_multipleFiles, this);
+        QProgressDialog* dialog = new QProgressDialog(tr("Opening files..."), tr("Cancel"), 0, importer->count(), this);
+        dialog->setAttribute(Qt::WA_DeleteOnClose);
+        dialog->setMinimumDuration(1000);
+        dialog->setValue(0);
+        connect(importer, SIGNAL(progressChanged(int)), dialog, SLOT(setValue(int)));
+        connect(importer, SIGNAL(finished()), dialog, SLOT(close()));
+        connect(dialog, SIGNAL(canceled()), importer, SLOT(cancel()));
+        importer->start();
         foreach (QString filename, m_multipleFiles)
             m_recentDock->add(filename.toUtf8().constData());
         m_multipleFiles.clear();
@@ -3340,6 +3410,14 @@ void MainWindow::on_actionScrubAudio_triggered(bool checked)
     Settings.setPlayerScrubAudio(checked);
 }
 
+void MainWindow::on_actionUseProxy_triggered(bool checked)
+{
+    // This applies to the files and projects opened from now on.
+    ProxyManager::singleton().setEnabled(checked);
+    if (checked && MLT.isClip() && MLT.producer())
+        ProxyManager::singleton().generate(*MLT.producer());
+}
+
 #ifdef Q_OS_WIN
 void MainWindow::onDrawingMethodTriggered(QAction *action)
 {
@@ -3721,6 +3799,8 @@ void MainWindow::readFromClient()
         m_autosaveTimer.setSingleShot(true);
         m_autosaveTimer.setInterval(AUTOSAVE_TIMEOUT_MS);
         connect(&m_autosaveTimer, SIGNAL(timeout()), this, SLOT(onAutosaveTimeout()));
+        // Auto-save tasks must run in order since the journal builds on the snapshot.
+        m_autosavePool.setMaxThreadCount(1);
 
         // Initialize all QML types
         QmlUtilities::registerCommonTypes();
@@ -3858,6 +3938,12 @@ void MainWindow::readFromClient()
         connect(m_timelineDock->model(), SIGNAL(showStatusMessage(QString)), this, SLOT(showStatusMessage(QString)));
         connect(m_timelineDock->model(), SIGNAL(created()), SLOT(onMultitrackCreated()));
         connect(m_timelineDock->model(), SIGNAL(closed()), SLOT(onMultitrackClosed()));
+        connect(m_timelineDock->model(), SIGNAL(rowsInserted(QModelIndex,int,int)), SLOT(onMultitrackRowsChanged(QModelIndex)));
+        connect(m_timelineDock->model(), SIGNAL(rowsRemoved(QModelIndex,int,int)), SLOT(onMultitrackRowsChanged(QModelIndex)));
+        connect(m_timelineDock->model(), SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), SLOT(onMultitrackRowsMoved(QModelIndex,int,int,QModelIndex)));
+        connect(m_timelineDock->model(), SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)), SLOT(onMultitrackDataChanged(QModelIndex,QModelIndex,QVector<int>)));
+        connect(m_timelineDock->model(), SIGNAL(modelReset()), SLOT(onMultitrackReset()));
+        connect(m_timelineDock->model(), SIGNAL(layoutChanged()), SLOT(onMultitrackReset()));
         connect(m_timelineDock->model(), SIGNAL(modified()), SLOT(onMultitrackModified()));
         connect(m_timelineDock->model(), SIGNAL(modified()), SLOT(updateAutoSave()));
         connect(m_timelineDock->model(), SIGNAL(durationChanged()), SLOT(onMultitrackDurationChanged()));
@@ -3974,7 +4060,7 @@ void MainWindow::readFromClient()
             splitDockWidget(m_meltedServerDock, m_meltedPlaylistDock, Qt::Horizontal);
             m_meltedPlaylistDock->toggleViewAction()->setIcon(m_meltedPlaylistDock->windowIcon());
             ui->menuView->addAction(m_meltedPlaylistDock->toggleViewAction());
-            connect(m_meltedServerDock, SIGNAL(connected(QString, quint16)), m_meltedPlaylistDock, SLOT(onConnected(QString,quint16)));
+            connect(m_meltedServerDock, SIGNAL(connected(MvcpClient*)), m_meltedPlaylistDock, SLOT(onConnected(MvcpClient*)));
             connect(m_meltedServerDock, SIGNAL(disconnected()), m_meltedPlaylistDock, SLOT(onDisconnected()));
             connect(m_meltedServerDock, SIGNAL(unitActivated(quint8)), m_meltedPlaylistDock, SLOT(onUnitChanged(quint8)));
             connect(m_meltedServerDock, SIGNAL(unitActivated(quint8)), this, SLOT(onMeltedUnitActivated()));
@@ -3993,9 +4079,8 @@ void MainWindow::readFromClient()
 
             MeltedUnitsModel* unitsModel = (MeltedUnitsModel*) m_meltedServerDock->unitsModel();
             MeltedPlaylistModel* playlistModel = (MeltedPlaylistModel*) m_meltedPlaylistDock->model();
-            connect(m_meltedServerDock, SIGNAL(connected(QString,quint16)), unitsModel, SLOT(onConnected(QString,quint16)));
             connect(unitsModel, SIGNAL(clipIndexChanged(quint8, int)), playlistModel, SLOT(onClipIndexChanged(quint8, int)));
-            connect(unitsModel, SIGNAL(generationChanged(quint8)), playlistModel, SLOT(onGenerationChanged(quint8)));
+            connect(unitsModel, SIGNAL(generationChanged(quint8,int)), playlistModel, SLOT(onGenerationChanged(quint8,int)));
         }
 
         // Configure the View menu.
@@ -21,7 +21,12 @@
 
 #include <QMainWindow>
 #include <QMutex>
+#include <QAtomicInt>
 #include <QTimer>
+#include <QTime>
+#include <QSet>
+#include <QMap>
+#include <QThreadPool>
 #include <QUrl>
 #include <QNetworkAccessManager>
 #include <QScopedPointer>
@@ -74,6 +79,7 @@ public:
     Mlt::Producer* multitrack() const;
     bool isMultitrackValid() const;
     void doAutosave();
+    void doAutosaveJournal(const QList<int>& tracks);
     void setFullScreen(bool isFullScreen);
     QString removeFileScheme(QUrl& url);
     QString untitledFileName() const;
@@ -172,6 +178,12 @@ private:
     QSharedPointer<AutoSaveFile> m_autosaveFile;
     QMutex m_autosaveMutex;
     QTimer m_autosaveTimer;
+    QThreadPool m_autosavePool;
+    QSet<int> m_autosaveDirtyTracks;
+    bool m_autosaveNeedsSnapshot;
+    bool m_autosaveTrackChanged;
+    QTime m_autosaveSnapshotTime;
+    QAtomicInt m_autosaveJournalBytes;
     int m_exitCode;
     int m_navigationPosition;
     QScopedPointer<QAction> m_statusBarAction;
@@ -241,6 +253,10 @@ private slots:
     void onMultitrackCreated();
     void onMultitrackClosed();
     void onMultitrackModified();
+    void onMultitrackRowsChanged(const QModelIndex& parent);
+    void onMultitrackRowsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination);
+    void onMultitrackDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles);
+    void onMultitrackReset();
     void onMultitrackDurationChanged();
     void onCutModified();
     void onFilterModelChanged();
@@ -295,6 +311,7 @@ private slots:
     void onTimelineClipSelected();
     void onAddAllToTimeline(Mlt::Playlist* playlist);
     void on_actionScrubAudio_triggered(bool checked);
+    void on_actionUseProxy_triggered(bool checked);
 #ifdef Q_OS_WIN
     void onDrawingMethodTriggered(QAction*);
 #endif
@@ -28,6 +28,7 @@
 #include "settings.h"
 #include "shotcut_mlt_properties.h"
 #include "mainwindow.h"
+#include "proxymanager.h"
 
 namespace Mlt {
 
@@ -102,16 +103,30 @@ int Controller::open(const QString &url)
 
     close();
 
-    if (Settings.playerGPU() && !profile().is_explicit())
+    // Substitute proxies for the media files and for those in projects.
+    QString hash;
+    QString resource = ProxyManager::singleton().resourceFor(url, &hash);
+    QString projectXml;
+    if (url.endsWith(".mlt") && ProxyManager::singleton().substitute(url, projectXml))
+        m_producer = new Mlt::Producer(profile(), "xml-string", projectXml.toUtf8().constData());
+    else if (Settings.playerGPU() && !profile().is_explicit())
         // Prevent loading normalizing filters, which might be Movit ones that
         // may not have a proper OpenGL context when requesting a sample frame.
-        m_producer = new Mlt::Producer(profile(), "abnormal", url.toUtf8().constData());
+        m_producer = new Mlt::Producer(profile(), "abnormal", resource.toUtf8().constData());
     else
-        m_producer = new Mlt::Producer(profile(), url.toUtf8().constData());
+        m_producer = new Mlt::Producer(profile(), resource.toUtf8().constData());
     if (m_producer->is_valid()) {
         double fps = profile().fps();
         if (!profile().is_explicit()) {
-            profile().from_producer(*m_producer);
+            // A project with proxies keeps the <profile> the xml producer
+            // already applied. Media take the video mode from the original
+            // file, not its smaller proxy.
+            if (resource != url) {
+                Mlt::Producer original(profile(), url.toUtf8().constData());
+                profile().from_producer(original.is_valid()? original : *m_producer);
+            } else if (projectXml.isEmpty()) {
+                profile().from_producer(*m_producer);
+            }
             profile().set_width(alignWidth(profile().width()));
         }
         if ( url.endsWith(".mlt") ) {
@@ -124,8 +139,15 @@ int Controller::open(const QString &url)
         if (profile().fps() != fps || (Settings.playerGPU() && !profile().is_explicit())) {
             // Reload with correct FPS or with Movit normalizing filters attached.
             delete m_producer;
-            m_producer = new Mlt::Producer(profile(), url.toUtf8().constData());
+            if (!projectXml.isEmpty())
+                m_producer = new Mlt::Producer(profile(), "xml-string", projectXml.toUtf8().constData());
+            else
+                m_producer = new Mlt::Producer(profile(), resource.toUtf8().constData());
         }
+        if (!projectXml.isEmpty())
+            m_producer->set("resource", url.toUtf8().constData());
+        else if (resource != url)
+            ProxyManager::setOriginal(*m_producer, url, hash);
         // Convert avformat to avformat-novalidate so that XML loads faster.
         if (!qstrcmp(m_producer->get("mlt_service"), "avformat")) {
             m_producer->set("mlt_service", "avformat-novalidate");
@@ -457,6 +479,9 @@ void Controller::saveXML(const QString& filename, Service* service, bool withRel
         c.start();
         if (ignore)
             s.set("ignore_points", ignore);
+        // Files always refer to the originals, never to proxies.
+        if (!ProxyManager::restoreOriginals(filename))
+            LOG_WARNING() << "failed to restore the original media in" << filename;
     }
 }
 
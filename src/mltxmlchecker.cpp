@@ -20,13 +20,24 @@
 #include "mltcontroller.h"
 #include "shotcut_mlt_properties.h"
 #include "util.h"
+#include "database.h"
 #include <QLocale>
 #include <QDir>
 #include <QCoreApplication>
 #include <QUrl>
 #include <QRegExp>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QtConcurrent/QtConcurrentMap>
 #include <Logger.h>
 
+enum {
+    NeedsGpuFlag = 0x1,
+    HasEffectsFlag = 0x2
+};
+// The number of bytes in which a project must have its <mlt> element.
+static const qint64 kSniffSize = 4096;
+
 static QString getPrefix(const QString& name, const QString& value);
 
 static bool isMltClass(const QStringRef& name)
@@ -45,6 +56,22 @@ static bool isNetworkResource(const QString& string)
     return (schemaTest.exactMatch(string) && QUrl(string).isValid() && !string.startsWith("plain:"));
 }
 
+struct FileExists
+{
+    typedef bool result_type;
+    bool operator()(const QString& path) const
+    {
+        return QFileInfo(path).exists();
+    }
+};
+
+// Resources are often on network shares where each stat is a round trip,
+// so they are checked concurrently.
+static QList<bool> filesExist(const QStringList& paths)
+{
+    return QtConcurrent::blockingMapped<QList<bool> >(paths, FileExists());
+}
+
 static bool isNumericProperty(const QString& name)
 {
     return  name == "length" || name == "geometry" ||
@@ -56,7 +83,6 @@ MltXmlChecker::MltXmlChecker()
     , m_hasEffects(false)
     , m_isCorrected(false)
     , m_decimalPoint(QLocale().decimalPoint())
-    , m_tempFile(QDir::tempPath().append("/shotcut-XXXXXX.mlt"))
     , m_numericValueChanged(false)
 {
     Mlt::Producer producer(MLT.profile(), "color", "black");
@@ -73,13 +99,51 @@ bool MltXmlChecker::check(const QString& fileName)
 {
     LOG_DEBUG() << "begin";
 
+    QFileInfo fileInfo(fileName);
+    const QString path = fileInfo.absoluteFilePath();
+    const qint64 modified = fileInfo.lastModified().toMSecsSinceEpoch();
+    m_basePath = fileInfo.canonicalPath();
+    m_resources.clear();
+    m_resourceHashes.clear();
+    m_resourceSet.clear();
+
+    // Checking again with replacements for unlinked files must read it all.
+    ProjectCheck record;
+    bool isRecorded = m_unlinkedFilesModel.rowCount() == 0
+            && DB.getProjectCheck(path, record) && record.context == context();
+    if (isRecorded && record.size == fileInfo.size() && record.modified == modified
+            && isStillClean(record)) {
+        LOG_DEBUG() << "end (unchanged)";
+        return true;
+    }
+
     QFile file(fileName);
-    if (file.open(QIODevice::ReadOnly | QIODevice::Text) &&
-            m_tempFile.open()) {
-        m_tempFile.resize(0);
-        m_basePath = QFileInfo(fileName).canonicalPath();
-        m_xml.setDevice(&file);
-        m_newXml.setDevice(&m_tempFile);
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        // Only read MLT XML into memory. Anything else, e.g. a media file, is
+        // rejected by the reader after its first bytes.
+        QByteArray data;
+        QString hash;
+        if (file.peek(kSniffSize).contains("<mlt")) {
+            data = file.readAll();
+            hash = QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex());
+            if (isRecorded && record.hash == hash && isStillClean(record)) {
+                // The same content with a new time stamp, for example a copy.
+                record.size = fileInfo.size();
+                record.modified = modified;
+                DB.putProjectCheck(path, record);
+                LOG_DEBUG() << "end (same content)";
+                return true;
+            }
+            m_xml.clear();
+            m_xml.addData(data);
+        } else {
+            m_xml.setDevice(&file);
+        }
+
+        m_newXmlBuffer.close();
+        m_newXmlBuffer.setData(QByteArray());
+        m_newXmlBuffer.open(QIODevice::WriteOnly);
+        m_newXml.setDevice(&m_newXmlBuffer);
         m_newXml.setAutoFormatting(true);
         m_newXml.setAutoFormattingIndent(2);
         if (m_xml.readNextStartElement()) {
@@ -100,21 +164,50 @@ bool MltXmlChecker::check(const QString& fileName)
                 m_newXml.writeEndElement();
                 m_newXml.writeEndDocument();
                 m_isCorrected = m_isCorrected || m_numericValueChanged;
+                checkUnlinkedFiles();
             } else {
                 m_xml.raiseError(QObject::tr("The file is not a MLT XML file."));
             }
         }
-    }
-    if (m_tempFile.isOpen()) {
-        m_tempFile.close();
-//        m_tempFile.open();
-//        LOG_DEBUG() << m_tempFile.readAll().constData();
-//        m_tempFile.close();
+        m_newXmlBuffer.close();
+
+        if (!hash.isEmpty() && m_xml.error() == QXmlStreamReader::NoError
+                && !m_isCorrected && m_unlinkedFilesModel.rowCount() == 0) {
+            record.size = fileInfo.size();
+            record.modified = modified;
+            record.context = context();
+            record.hash = hash;
+            record.flags = (m_needsGPU? NeedsGpuFlag : 0) | (m_hasEffects? HasEffectsFlag : 0);
+            record.resources = m_resources;
+            DB.putProjectCheck(path, record);
+        }
     }
     LOG_DEBUG() << "end";
     return m_xml.error() == QXmlStreamReader::NoError;
 }
 
+bool MltXmlChecker::isStillClean(const ProjectCheck& check)
+{
+    QList<bool> exist = filesExist(check.resources);
+    for (int i = 0; i < exist.size(); ++i) {
+        if (!exist[i]) {
+            LOG_INFO() << "resource of clean project is missing:" << check.resources[i];
+            return false;
+        }
+    }
+    m_needsGPU = check.flags & NeedsGpuFlag;
+    m_hasEffects = check.flags & HasEffectsFlag;
+    return true;
+}
+
+// A clean result only holds for the same locale and installation.
+QString MltXmlChecker::context() const
+{
+    return QString("%1 %2 %3").arg(m_decimalPoint)
+            .arg(QCoreApplication::applicationVersion())
+            .arg(QCoreApplication::applicationDirPath());
+}
+
 QString MltXmlChecker::errorString() const
 {
     return m_xml.errorString();
@@ -367,17 +460,30 @@ void MltXmlChecker::checkUnlinkedFile(const QString& mlt_service)
     if (!m_resource.info.filePath().isEmpty() && !isNetworkResource(m_resource.info.filePath()))
     // not an image sequence
     if ((mlt_service != "pixbuf" && mlt_service != "qimage") || baseName.indexOf('%') == -1)
-    // file does not exist
-    if (!m_resource.info.exists())
-    // not already in the model
-    if (m_unlinkedFilesModel.findItems(m_resource.info.filePath(),
-            Qt::MatchFixedString | Qt::MatchCaseSensitive).isEmpty()) {
-        LOG_ERROR() << "file not found: " << m_resource.info.filePath();
-        QIcon icon(":/icons/oxygen/32x32/status/task-reject.png");
-        QStandardItem* item = new QStandardItem(icon, m_resource.info.filePath());
-        item->setToolTip(item->text());
-        item->setData(m_resource.hash, ShotcutHashRole);
-        m_unlinkedFilesModel.appendRow(item);
+    // not already collected; checkUnlinkedFiles() checks them all at once
+    if (!m_resourceSet.contains(m_resource.info.filePath())) {
+        m_resourceSet << m_resource.info.filePath();
+        m_resources << m_resource.info.filePath();
+        m_resourceHashes << m_resource.hash;
+    }
+}
+
+void MltXmlChecker::checkUnlinkedFiles()
+{
+    QList<bool> exist = filesExist(m_resources);
+    for (int i = 0; i < exist.size(); ++i) {
+        // file does not exist
+        if (!exist[i])
+        // not already in the model
+        if (m_unlinkedFilesModel.findItems(m_resources[i],
+                Qt::MatchFixedString | Qt::MatchCaseSensitive).isEmpty()) {
+            LOG_ERROR() << "file not found: " << m_resources[i];
+            QIcon icon(":/icons/oxygen/32x32/status/task-reject.png");
+            QStandardItem* item = new QStandardItem(icon, m_resources[i]);
+            item->setToolTip(item->text());
+            item->setData(m_resourceHashes[i], ShotcutHashRole);
+            m_unlinkedFilesModel.appendRow(item);
+        }
     }
 }
 
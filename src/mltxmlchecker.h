@@ -21,14 +21,28 @@
 
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
-#include <QTemporaryFile>
+#include <QBuffer>
 #include <QString>
+#include <QStringList>
 #include <QFileInfo>
 #include <QStandardItemModel>
 #include <QVector>
 #include <QPair>
+#include <QSet>
 
 class QUIDevice;
+struct ProjectCheck;
+
+/*!
+  \class MltXmlChecker
+  \brief The MltXmlChecker finds and corrects problems in MLT XML projects.
+
+  The corrected document is written to memory and available from
+  correctedXml(). Projects found clean are recorded in the database with
+  their size, time stamp and content hash. When such a project is checked
+  again unchanged, only its resources are checked for existence, and the
+  document is not parsed again.
+*/
 
 class MltXmlChecker
 {
@@ -50,7 +64,7 @@ public:
     bool needsGPU() const { return m_needsGPU; }
     bool hasEffects() const { return m_hasEffects; }
     bool isCorrected() const { return m_isCorrected; }
-    QString tempFileName() const { return m_tempFile.fileName(); }
+    QByteArray correctedXml() const { return m_newXmlBuffer.data(); }
     QStandardItemModel& unlinkedFilesModel() { return m_unlinkedFilesModel; }
 
 private:
@@ -62,6 +76,9 @@ private:
     bool readResourceProperty(const QString& name, QString& value);
     void checkGpuEffects(const QString& mlt_service);
     void checkUnlinkedFile(const QString& mlt_service);
+    void checkUnlinkedFiles();
+    bool isStillClean(const ProjectCheck& check);
+    QString context() const;
     bool fixUnlinkedFile(QString& value);
     void fixStreamIndex(QString& value);
     bool fixVersion1701WindowsPathBug(QString& value);
@@ -72,10 +89,14 @@ private:
     bool m_hasEffects;
     bool m_isCorrected;
     QChar m_decimalPoint;
-    QTemporaryFile m_tempFile;
+    QBuffer m_newXmlBuffer;
     bool m_numericValueChanged;
     QString m_basePath;
     QStandardItemModel m_unlinkedFilesModel;
+    // Resources to check for existence and their hashes, in document order.
+    QStringList m_resources;
+    QStringList m_resourceHashes;
+    QSet<QString> m_resourceSet;
     typedef QPair<QString, QString> MltProperty;
     QString mlt_class;
     QVector<MltProperty> m_properties;
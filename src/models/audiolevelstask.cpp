@@ -17,41 +17,77 @@
  */
 
 #include "audiolevelstask.h"
-#include "database.h"
 #include "mltcontroller.h"
 #include "shotcut_mlt_properties.h"
 #include "settings.h"
 #include <QString>
-#include <QVariantList>
-#include <QImage>
 #include <QCryptographicHash>
-#include <QRgb>
 #include <QThreadPool>
-#include <QMutex>
-#include <QTime>
+#include <QMutexLocker>
+#include <QFile>
 #include <Logger.h>
 
+// TODO: use project channel count
+static const int kChannels = 2;
+static const int kFrequency = 48000;
+// Chunk length in seconds of audio. Shorter chunks spread better over the
+// threads and lose less work when canceled but each needs its own decoder.
+static const int kChunkSeconds = 120;
+
 static QList<AudioLevelsTask*> tasksList;
 static QMutex tasksListMutex;
+static int visibleFirstFrame = 0;
+static int visibleLastFrame = -1;
+static QMutex visibleRangeMutex;
 
-static void deleteQVariantList(QVariantList* list)
+static void deleteAudioPeaks(AudioPeaksPtr* peaks)
 {
-    delete list;
+    delete peaks;
 }
 
+class AudioLevelsChunk : public QRunnable
+{
+public:
+    AudioLevelsChunk(AudioLevelsTask* task, int index)
+        : QRunnable()
+        , m_task(task)
+        , m_index(index)
+    {}
+
+protected:
+    void run()
+    {
+        AudioPeaksPtr peaks;
+        if (!m_task->m_isCanceled)
+            peaks = m_task->decodeChunk(m_index);
+        // This may delete the task.
+        m_task->chunkFinished(m_index, peaks);
+    }
+
+private:
+    AudioLevelsTask* m_task;
+    int m_index;
+};
+
 AudioLevelsTask::AudioLevelsTask(Mlt::Producer& producer, MultitrackModel* model, const QModelIndex& index)
     : QRunnable()
     , m_model(model)
-    , m_tempProducer(0)
+    , m_position(0)
+    , m_duration(0)
     , m_isCanceled(false)
     , m_isForce(false)
+    , m_totalSamples(0)
+    , m_chunkSamples(0)
+    , m_samplesPerBin(1)
+    , m_pendingChunks(0)
 {
+    // The last chunk to finish deletes the task.
+    setAutoDelete(false);
     m_producers << ProducerAndIndex(new Mlt::Producer(producer), index);
 }
 
 AudioLevelsTask::~AudioLevelsTask()
 {
-    delete m_tempProducer;
     foreach (ProducerAndIndex p, m_producers)
         delete p.first;
 }
@@ -74,8 +110,10 @@ void AudioLevelsTask::start(Mlt::Producer& producer, MultitrackModel* model, con
         if (task) {
             // Otherwise, start a new audio levels generation thread.
             task->m_isForce = force;
+            task->m_position = model->data(index, MultitrackModel::StartRole).toInt();
+            task->m_duration = model->data(index, MultitrackModel::DurationRole).toInt();
             tasksList << task;
-            QThreadPool::globalInstance()->start(task);
+            QThreadPool::globalInstance()->start(task, task->priority());
         }
         tasksListMutex.unlock();
     }
@@ -93,6 +131,13 @@ void AudioLevelsTask::closeAll()
     tasksListMutex.unlock();
 }
 
+void AudioLevelsTask::setVisibleRange(int firstFrame, int lastFrame)
+{
+    QMutexLocker locker(&visibleRangeMutex);
+    visibleFirstFrame = firstFrame;
+    visibleLastFrame = lastFrame;
+}
+
 bool AudioLevelsTask::operator==(AudioLevelsTask &b)
 {
     if (!m_producers.isEmpty() && !b.m_producers.isEmpty()) {
@@ -103,27 +148,22 @@ bool AudioLevelsTask::operator==(AudioLevelsTask &b)
     return false;
 }
 
-Mlt::Producer* AudioLevelsTask::tempProducer()
-{
-    if (!m_tempProducer) {
-        QString service = m_producers.first().first->get("mlt_service");
-        if (service == "avformat-novalidate")
-            service = "avformat";
-        else if (service.startsWith("xml"))
-            service = "xml-nogl";
-        m_tempProducer = new Mlt::Producer(m_profile, service.toUtf8().constData(),
-            m_producers.first().first->get("resource"));
-        if (m_tempProducer->is_valid()) {
-            Mlt::Filter channels(m_profile, "audiochannels");
-            Mlt::Filter converter(m_profile, "audioconvert");
-            Mlt::Filter levels(m_profile, "audiolevel");
-            m_tempProducer->attach(channels);
-            m_tempProducer->attach(converter);
-            m_tempProducer->attach(levels);
-            LOG_DEBUG() << "generating audio levels for" << m_tempProducer->get("resource");
-        }
+Mlt::Producer* AudioLevelsTask::createProducer()
+{
+    QString service = m_producers.first().first->get("mlt_service");
+    if (service == "avformat-novalidate")
+        service = "avformat";
+    else if (service.startsWith("xml"))
+        service = "xml-nogl";
+    Mlt::Producer* producer = new Mlt::Producer(m_profile, service.toUtf8().constData(),
+        m_producers.first().first->get("resource"));
+    if (producer->is_valid()) {
+        Mlt::Filter channels(m_profile, "audiochannels");
+        Mlt::Filter converter(m_profile, "audioconvert");
+        producer->attach(channels);
+        producer->attach(converter);
     }
-    return m_tempProducer;
+    return producer;
 }
 
 QString AudioLevelsTask::cacheKey()
@@ -140,104 +180,190 @@ QString AudioLevelsTask::cacheKey()
     return key;
 }
 
+int AudioLevelsTask::priority() const
+{
+    QMutexLocker locker(&visibleRangeMutex);
+    bool isVisible = m_position <= visibleLastFrame && m_position + m_duration >= visibleFirstFrame;
+    return isVisible? 1 : 0;
+}
+
+QString AudioLevelsTask::chunkPath(int index) const
+{
+    return QString("%1.%2.part").arg(m_path).arg(index);
+}
+
+int AudioLevelsTask::chunkBinCount(int index) const
+{
+    qint64 samples = qMin(m_chunkSamples, m_totalSamples - index * m_chunkSamples);
+    return int((samples + m_samplesPerBin - 1) / m_samplesPerBin);
+}
+
 void AudioLevelsTask::run()
 {
-    // 2 channels interleaved of uchar values
-    QVariantList levels;
-    QImage image = DB.getThumbnail(cacheKey());
-    if (image.isNull() || m_isForce) {
-        const char* key[2] = { "meta.media.audio_level.0", "meta.media.audio_level.1"};
-        QTime updateTime; updateTime.start();
-        // TODO: use project channel count
-        int channels = 2;
-
-        // for each frame
-        int n = tempProducer()->get_playtime();
-        for (int i = 0; i < n && !m_isCanceled; i++) {
-            Mlt::Frame* frame = tempProducer()->get_frame();
+    AudioPeaksPtr peaks;
+    m_path = AudioPeaks::filePath(cacheKey());
+    if (!m_isForce)
+        peaks = AudioPeaks::load(m_path);
+    if (!peaks && !m_isCanceled) {
+        Mlt::Producer* producer = createProducer();
+        if (producer->is_valid()) {
+            LOG_DEBUG() << "generating audio levels for" << producer->get("resource");
+            m_totalSamples = mlt_sample_calculator_to_now(m_profile.fps(), kFrequency, producer->get_playtime());
+        }
+        delete producer;
+
+        // Chunks start on a bin boundary so that their bins can be concatenated.
+        AudioPeaksBuilder builder(kChannels, kFrequency);
+        m_samplesPerBin = builder.samplesPerBin();
+        m_chunkSamples = qint64(kChunkSeconds * kFrequency) / m_samplesPerBin * m_samplesPerBin;
+        int count = int((m_totalSamples + m_chunkSamples - 1) / m_chunkSamples);
+        m_chunks.resize(count);
+        m_pendingChunks = 0;
+        for (int i = 0; i < count; i++) {
+            // Resume from the chunks of a previous, incomplete run.
+            if (m_isForce) {
+                QFile::remove(chunkPath(i));
+            } else {
+                AudioPeaksPtr chunk = AudioPeaks::load(chunkPath(i));
+                if (chunk && chunk->channels() == kChannels && chunk->binCount(0) == chunkBinCount(i))
+                    m_chunks[i] = chunk;
+            }
+            if (!m_chunks[i])
+                ++m_pendingChunks;
+        }
+
+        if (m_pendingChunks > 0) {
+            // Hold the lock until all chunks are queued; the last chunk to
+            // finish deletes this task.
+            QMutexLocker locker(&m_mutex);
+            m_updateTime.start();
+            int priority = this->priority();
+            for (int i = 0; i < count; i++) {
+                if (!m_chunks[i])
+                    QThreadPool::globalInstance()->start(new AudioLevelsChunk(this, i), priority);
+            }
+            return;
+        }
+        // A producer without audio still gets a (silent) peak file, which
+        // prevents continually trying to regenerate audio levels for it.
+        peaks = stitch();
+        if (!peaks->save(m_path))
+            LOG_WARNING() << "failed to save audio peaks" << m_path;
+        for (int i = 0; i < count; i++)
+            QFile::remove(chunkPath(i));
+    }
+    finish(peaks);
+    delete this;
+}
+
+AudioPeaksPtr AudioLevelsTask::decodeChunk(int index)
+{
+    const double fps = m_profile.fps();
+    const qint64 begin = index * m_chunkSamples;
+    const qint64 end = qMin(begin + m_chunkSamples, m_totalSamples);
+    AudioPeaksBuilder builder(kChannels, kFrequency);
+    Mlt::Producer* producer = createProducer();
+
+    if (producer->is_valid()) {
+        // Find the frame that contains the first sample of the chunk.
+        int position = int(begin * fps / kFrequency);
+        while (position > 0 && mlt_sample_calculator_to_now(fps, kFrequency, position) > begin)
+            --position;
+        while (mlt_sample_calculator_to_now(fps, kFrequency, position + 1) <= begin)
+            ++position;
+        producer->seek(position);
+
+        qint64 sample = mlt_sample_calculator_to_now(fps, kFrequency, position);
+        for (; sample < end && !m_isCanceled; position++) {
+            int samples = mlt_sample_calculator(fps, kFrequency, position);
+            // Only use the part of the frame that is inside the chunk.
+            int skip = int(qMax(qint64(0), begin - sample));
+            int count = int(qMin(qint64(samples), end - sample)) - skip;
+            sample += samples;
+            Mlt::Frame* frame = producer->get_frame();
             if (frame && frame->is_valid() && !frame->get_int("test_audio")) {
                 mlt_audio_format format = mlt_audio_s16;
-                int frequency = 48000;
-                int samples = mlt_sample_calculator(m_producers.first().first->get_fps(), frequency, i);
-                frame->get_audio(format, frequency, channels, samples);
-                // for each channel
-                for (int channel = 0; channel < channels; channel++)
-                    // Convert real to uint for caching as image.
-                    // Scale by 0.9 because values may exceed 1.0 to indicate clipping.
-                    levels << 256 * qMin(frame->get_double(key[channel]) * 0.9, 1.0);
-            } else if (!levels.isEmpty()) {
-                for (int channel = 0; channel < channels; channel++)
-                    levels << levels.last();
+                int channels = kChannels;
+                int frequency = kFrequency;
+                const int16_t* audio = (const int16_t*) frame->get_audio(format, frequency, channels, samples);
+                if (audio && samples >= skip + count)
+                    builder.addSamples(audio + skip * kChannels, count);
+                else
+                    builder.addSilence(count);
+            } else {
+                builder.addSilence(count);
             }
             delete frame;
-
-            // Incrementally update the audio levels every 5 seconds.
-            if (updateTime.elapsed() > 5*1000 && !m_isCanceled) {
-                updateTime.restart();
-                foreach (ProducerAndIndex p, m_producers) {
-                    QVariantList* levelsCopy = new QVariantList(levels);
-                    p.first->set(kAudioLevelsProperty, levelsCopy, 0, (mlt_destructor) deleteQVariantList);
-                    m_model->audioLevelsReady(p.second);
-                }
-            }
         }
+    } else {
+        builder.addSilentBins(chunkBinCount(index));
+    }
+    delete producer;
+
+    if (m_isCanceled)
+        return AudioPeaksPtr();
+    AudioPeaksPtr peaks = builder.build();
+    if (!peaks->save(chunkPath(index)))
+        LOG_WARNING() << "failed to save audio peaks" << chunkPath(index);
+    return peaks;
+}
+
+void AudioLevelsTask::chunkFinished(int index, const AudioPeaksPtr& peaks)
+{
+    m_mutex.lock();
+    m_chunks[index] = peaks;
+    bool isLast = --m_pendingChunks == 0;
+    // Incrementally update the audio levels every 5 seconds.
+    if (!isLast && !m_isCanceled && m_updateTime.elapsed() > 5*1000) {
+        m_updateTime.restart();
+        setLevels(stitch());
+    }
+    m_mutex.unlock();
+
+    if (isLast) {
+        AudioPeaksPtr result;
         if (!m_isCanceled) {
-            // Put into an image for caching.
-            int count = levels.size();
-            QImage image((count + 3) / 4 / channels, channels, QImage::Format_ARGB32);
-            n = image.width() * image.height();
-            for (int i = 0; i < n; i ++) {
-                QRgb p;
-                if ((4*i + 3) < count) {
-                    p = qRgba(levels.at(4*i).toInt(), levels.at(4*i+1).toInt(), levels.at(4*i+2).toInt(), levels.at(4*i+3).toInt());
-                } else {
-                    int last = levels.last().toInt();
-                    int r = (4*i+0) < count? levels.at(4*i+0).toInt() : last;
-                    int g = (4*i+1) < count? levels.at(4*i+1).toInt() : last;
-                    int b = (4*i+2) < count? levels.at(4*i+2).toInt() : last;
-                    int a = last;
-                    p = qRgba(r, g, b, a);
-                }
-                image.setPixel(i / 2, i % channels, p);
-            }
-            if (!image.isNull()) {
-                DB.putThumbnail(cacheKey(), image);
+            result = stitch();
+            if (result->save(m_path)) {
+                for (int i = 0; i < m_chunks.size(); i++)
+                    QFile::remove(chunkPath(i));
             } else {
-                // If the produducer does not produce audio, make a special 1x1 RGBA(0,0,0,0) image,
-                // which is used to prevent QImage::isNull() from being true and continually trying
-                // to regenerate audio levels for this file.
-                QImage image(1, 1, QImage::Format_ARGB32);
-                DB.putThumbnail(cacheKey(), image);
+                LOG_WARNING() << "failed to save audio peaks" << m_path;
             }
         }
-    } else if (!m_isCanceled) {
-        // convert cached image
-        int channels = 2;
-        int n = image.width() * image.height();
-        for (int i = 0; n > 1 && i < n; i++) {
-            QRgb p = image.pixel(i / 2, i % channels);
-            levels << qRed(p);
-            levels << qGreen(p);
-            levels << qBlue(p);
-            levels << qAlpha(p);
-        }
+        finish(result);
+        delete this;
     }
+}
+
+AudioPeaksPtr AudioLevelsTask::stitch() const
+{
+    // Chunks that are not done yet are shown as silence.
+    AudioPeaksBuilder builder(kChannels, kFrequency);
+    for (int i = 0; i < m_chunks.size(); i++) {
+        if (m_chunks[i])
+            builder.append(*m_chunks[i]);
+        else
+            builder.addSilentBins(chunkBinCount(i));
+    }
+    return builder.build();
+}
 
+void AudioLevelsTask::finish(const AudioPeaksPtr& peaks)
+{
     // Remove ourself from the global list of audio tasks.
     tasksListMutex.lock();
-    for (int i = 0; i < tasksList.size(); ++i) {
-        if (*tasksList[i] == *this) {
-            tasksList.removeAt(i);
-            break;
-        }
-    }
+    tasksList.removeOne(this);
     tasksListMutex.unlock();
 
-    if (levels.size() > 0 && !m_isCanceled) {
-        foreach (ProducerAndIndex p, m_producers) {
-            QVariantList* levelsCopy = new QVariantList(levels);
-            p.first->set(kAudioLevelsProperty, levelsCopy, 0, (mlt_destructor) deleteQVariantList);
-            m_model->audioLevelsReady(p.second);
-        }
+    if (peaks && peaks->binCount(0) > 0 && !m_isCanceled)
+        setLevels(peaks);
+}
+
+void AudioLevelsTask::setLevels(const AudioPeaksPtr& peaks)
+{
+    foreach (ProducerAndIndex p, m_producers) {
+        p.first->set(kAudioLevelsProperty, new AudioPeaksPtr(peaks), 0, (mlt_destructor) deleteAudioPeaks);
+        m_model->audioLevelsReady(p.second);
     }
 }
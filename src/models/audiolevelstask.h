@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2016 Meltytech, LLC
+ * Copyright (c) 2013-2017 Meltytech, LLC
  * Author: Dan Dennedy <dan@dennedy.org>
  *
  * This program is free software: you can redistribute it and/or modify
@@ -20,12 +20,31 @@
 #define AUDIOLEVELSTASK_H
 
 #include "multitrackmodel.h"
+#include "audiopeaks.h"
 #include <QRunnable>
 #include <QPersistentModelIndex>
 #include <QList>
+#include <QVector>
+#include <QMutex>
+#include <QTime>
 #include <MltProducer.h>
 #include <MltProfile.h>
 
+/*!
+  \class AudioLevelsTask
+  \brief The AudioLevelsTask generates the audio peaks of a clip.
+
+  The media is split into chunks of a fixed number of samples. Each chunk is
+  decoded by its own producer in its own runnable on the global thread pool,
+  and the chunk peaks are stitched into the peak file when all of them are
+  done. Chunks of clips that are visible in the timeline are queued with a
+  higher priority.
+
+  Every finished chunk is written next to the peak file so that a canceled
+  task resumes with the chunks that are still missing the next time it is
+  started for the same media.
+*/
+
 class AudioLevelsTask : public QRunnable
 {
 public:
@@ -33,22 +52,42 @@ public:
     virtual ~AudioLevelsTask();
     static void start(Mlt::Producer& producer, MultitrackModel* model, const QModelIndex& index, bool force = false);
     static void closeAll();
+    //! Sets the range of timeline frames that is currently visible.
+    static void setVisibleRange(int firstFrame, int lastFrame);
     bool operator==(AudioLevelsTask& b);
 
 protected:
     void run();
 
 private:
-    Mlt::Producer* tempProducer();
+    friend class AudioLevelsChunk;
+    Mlt::Producer* createProducer();
     QString cacheKey();
+    int priority() const;
+    QString chunkPath(int index) const;
+    int chunkBinCount(int index) const;
+    AudioPeaksPtr decodeChunk(int index);
+    void chunkFinished(int index, const AudioPeaksPtr& peaks);
+    AudioPeaksPtr stitch() const;
+    void finish(const AudioPeaksPtr& peaks);
+    void setLevels(const AudioPeaksPtr& peaks);
 
     MultitrackModel* m_model;
     typedef QPair<Mlt::Producer*, QPersistentModelIndex> ProducerAndIndex;
     QList<ProducerAndIndex> m_producers;
-    Mlt::Producer* m_tempProducer;
+    int m_position;
+    int m_duration;
     bool m_isCanceled;
     bool m_isForce;
     Mlt::Profile m_profile;
+    QString m_path;
+    qint64 m_totalSamples;
+    qint64 m_chunkSamples;
+    int m_samplesPerBin;
+    QVector<AudioPeaksPtr> m_chunks;
+    int m_pendingChunks;
+    QMutex m_mutex;
+    QTime m_updateTime;
 };
 
 #endif // AUDIOLEVELSTASK_H
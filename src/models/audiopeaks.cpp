@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audiopeaks.h"
+#include "settings.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QScopedPointer>
+#include <Logger.h>
+#include <string.h>
+#include <cmath>
+#include <algorithm>
+
+static const char kPeakFileMagic[4] = { 'S', 'P', 'K', 'S' };
+static const quint32 kPeakFileVersion = 1;
+// The peak files are kept under this total size, most recently used first.
+static const qint64 kMaxPeaksBytes = 512 * 1024 * 1024;
+// The chunks of a run that has not written any for this long are abandoned.
+static const int kMaxChunkAgeSeconds = 24 * 60 * 60;
+
+struct PeakFileHeader
+{
+    char magic[4];
+    quint32 version;
+    quint32 channels;
+    quint32 binsPerSecond;
+    quint32 levelCount;
+    quint32 binCount;      // bins in level 0
+    quint32 reserved[2];
+};
+
+AudioPeaks::AudioPeaks()
+    : m_buffer()
+    , m_file(0)
+    , m_data(0)
+{
+}
+
+AudioPeaks::~AudioPeaks()
+{
+    // Closing the file also removes the memory map.
+    delete m_file;
+}
+
+static QDateTime lastUsed(const QFileInfo& info)
+{
+    // Mounts with relatime still update the access time once a day.
+    return qMax(info.lastRead(), info.lastModified());
+}
+
+static bool isLessRecentlyUsed(const QFileInfo& a, const QFileInfo& b)
+{
+    return lastUsed(a) < lastUsed(b);
+}
+
+QString AudioPeaks::filePath(const QString& key)
+{
+    QDir dir(Settings.appDataLocation());
+    if (!dir.cd("peaks")) {
+        if (dir.mkdir("peaks"))
+            dir.cd("peaks");
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(key.toUtf8());
+    return dir.filePath(QString::fromLatin1(hash.result().toHex()) + ".peaks");
+}
+
+void AudioPeaks::deleteOldFiles()
+{
+    QDir dir(Settings.appDataLocation());
+    if (!dir.cd("peaks"))
+        return;
+    QDateTime now = QDateTime::currentDateTime();
+    foreach (QFileInfo info, dir.entryInfoList(QStringList("*.part"), QDir::Files)) {
+        // A chunk is named <peak file>.<index>.part.
+        QString peaksName = info.completeBaseName();
+        peaksName.truncate(peaksName.lastIndexOf('.'));
+        if (info.lastModified().secsTo(now) > kMaxChunkAgeSeconds || dir.exists(peaksName))
+            QFile::remove(info.filePath());
+    }
+
+    QFileInfoList files = dir.entryInfoList(QStringList("*.peaks"), QDir::Files);
+    qint64 total = 0;
+    foreach (QFileInfo info, files)
+        total += info.size();
+    if (total <= kMaxPeaksBytes)
+        return;
+    std::sort(files.begin(), files.end(), isLessRecentlyUsed);
+    int count = 0;
+    for (int i = 0; i < files.size() && total > kMaxPeaksBytes; i++) {
+        // A file that is still mapped is dropped once it is closed.
+        if (QFile::remove(files[i].filePath())) {
+            total -= files[i].size();
+            ++count;
+        }
+    }
+    LOG_DEBUG() << "deleted" << count << "audio peak files";
+}
+
+AudioPeaksPtr AudioPeaks::load(const QString& path)
+{
+    QScopedPointer<AudioPeaks> peaks(new AudioPeaks);
+    peaks->m_file = new QFile(path);
+    if (!peaks->m_file->open(QIODevice::ReadOnly))
+        return AudioPeaksPtr();
+    qint64 size = peaks->m_file->size();
+    const uchar* data = peaks->m_file->map(0, size);
+    if (!data || !peaks->setData(data, size)) {
+        LOG_WARNING() << "invalid audio peaks file" << path;
+        return AudioPeaksPtr();
+    }
+    return AudioPeaksPtr(peaks.take());
+}
+
+bool AudioPeaks::save(const QString& path) const
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    const PeakFileHeader* header = (const PeakFileHeader*) m_data;
+    qint64 size = m_offsets.isEmpty()? sizeof(PeakFileHeader)
+        : m_offsets.last() + m_counts.last() * header->channels * 2 * sizeof(int16_t);
+    if (file.write((const char*) m_data, size) != size) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool AudioPeaks::setData(const uchar* data, qint64 size)
+{
+    if (size < qint64(sizeof(PeakFileHeader)))
+        return false;
+    const PeakFileHeader* header = (const PeakFileHeader*) data;
+    if (memcmp(header->magic, kPeakFileMagic, sizeof(kPeakFileMagic))
+            || header->version != kPeakFileVersion
+            || header->channels == 0 || header->binsPerSecond == 0)
+        return false;
+
+    m_offsets.clear();
+    m_counts.clear();
+    qint64 offset = sizeof(PeakFileHeader);
+    qint64 count = header->binCount;
+    for (quint32 level = 0; level < header->levelCount; level++) {
+        m_offsets << offset;
+        m_counts << count;
+        offset += count * header->channels * 2 * sizeof(int16_t);
+        count = (count + 1) / 2;
+    }
+    if (offset > size)
+        return false;
+    m_data = data;
+    return true;
+}
+
+int AudioPeaks::channels() const
+{
+    return ((const PeakFileHeader*) m_data)->channels;
+}
+
+int AudioPeaks::binsPerSecond() const
+{
+    return ((const PeakFileHeader*) m_data)->binsPerSecond;
+}
+
+int AudioPeaks::levelCount() const
+{
+    return m_counts.size();
+}
+
+int AudioPeaks::binCount(int level) const
+{
+    return (level >= 0 && level < m_counts.size())? m_counts[level] : 0;
+}
+
+const int16_t* AudioPeaks::bins(int level) const
+{
+    if (level < 0 || level >= m_offsets.size())
+        return 0;
+    return (const int16_t*) (m_data + m_offsets[level]);
+}
+
+int AudioPeaks::peak(int level, int bin) const
+{
+    if (bin < 0 || bin >= binCount(level))
+        return 0;
+    int n = channels() * 2;
+    const int16_t* p = bins(level) + bin * n;
+    int result = 0;
+    for (int i = 0; i < n; i++)
+        result = qMax(result, qAbs(int(p[i])));
+    return result;
+}
+
+int AudioPeaks::levelFor(qreal binsPerPixel) const
+{
+    int level = 0;
+    while (level + 1 < levelCount() && qreal(2 << level) <= binsPerPixel)
+        ++level;
+    return level;
+}
+
+void AudioPeaks::minMax(qreal from, qreal to, int level, int& min, int& max) const
+{
+    min = max = 0;
+    if (level < 0 || level >= levelCount())
+        return;
+    const qreal scale = 1 << level;
+    int first = qMax(0, int(from / scale));
+    int last = qMin(binCount(level), qMax(first + 1, int(ceil(to / scale))));
+    if (first >= last)
+        return;
+
+    const int n = channels() * 2;
+    const int16_t* p = bins(level) + first * n;
+    min = max = p[0];
+    for (int bin = first; bin < last; bin++, p += n) {
+        for (int i = 0; i < n; i += 2) {
+            min = qMin(min, int(p[i]));
+            max = qMax(max, int(p[i + 1]));
+        }
+    }
+}
+
+AudioPeaksBuilder::AudioPeaksBuilder(int channels, int frequency, int binsPerSecond)
+    : m_channels(qMax(1, channels))
+    , m_binsPerSecond(qMax(1, binsPerSecond))
+    , m_samplesPerBin(qMax(1, frequency / m_binsPerSecond))
+    , m_samplesInBin(0)
+    , m_current(m_channels * 2, 0)
+    , m_bins()
+{
+}
+
+void AudioPeaksBuilder::addSamples(const int16_t* samples, int count)
+{
+    int16_t* current = m_current.data();
+    for (int i = 0; i < count; i++) {
+        for (int c = 0; c < m_channels; c++) {
+            int16_t value = *samples++;
+            if (m_samplesInBin == 0) {
+                current[c * 2] = value;
+                current[c * 2 + 1] = value;
+            } else if (value < current[c * 2]) {
+                current[c * 2] = value;
+            } else if (value > current[c * 2 + 1]) {
+                current[c * 2 + 1] = value;
+            }
+        }
+        if (++m_samplesInBin == m_samplesPerBin)
+            closeBin();
+    }
+}
+
+void AudioPeaksBuilder::addSilence(int count)
+{
+    QVector<int16_t> silence(count * m_channels, 0);
+    addSamples(silence.constData(), count);
+}
+
+void AudioPeaksBuilder::append(const AudioPeaks& peaks)
+{
+    Q_ASSERT(m_samplesInBin == 0);
+    if (peaks.channels() != m_channels || peaks.levelCount() == 0)
+        return;
+    m_bins.append((const char*) peaks.bins(0), peaks.binCount(0) * m_channels * 2 * sizeof(int16_t));
+}
+
+void AudioPeaksBuilder::addSilentBins(int count)
+{
+    Q_ASSERT(m_samplesInBin == 0);
+    if (count > 0)
+        m_bins.append(QByteArray(count * m_channels * 2 * sizeof(int16_t), 0));
+}
+
+void AudioPeaksBuilder::closeBin()
+{
+    m_bins.append((const char*) m_current.constData(), m_current.size() * sizeof(int16_t));
+    m_samplesInBin = 0;
+}
+
+AudioPeaksPtr AudioPeaksBuilder::build() const
+{
+    QByteArray level = m_bins;
+    if (m_samplesInBin > 0)
+        level.append((const char*) m_current.constData(), m_current.size() * sizeof(int16_t));
+    const int binSize = m_channels * 2;
+    const int binBytes = binSize * sizeof(int16_t);
+
+    PeakFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kPeakFileMagic, sizeof(kPeakFileMagic));
+    header.version = kPeakFileVersion;
+    header.channels = m_channels;
+    header.binsPerSecond = m_binsPerSecond;
+    header.binCount = level.size() / binBytes;
+
+    QByteArray buffer((const char*) &header, sizeof(header));
+    int levelCount = 0;
+    while (!level.isEmpty()) {
+        buffer.append(level);
+        ++levelCount;
+        int count = level.size() / binBytes;
+        if (count == 1)
+            break;
+        // Reduce pairs of bins into the next level.
+        QByteArray next((count + 1) / 2 * binBytes, 0);
+        const int16_t* src = (const int16_t*) level.constData();
+        int16_t* dst = (int16_t*) next.data();
+        for (int i = 0; i < count; i += 2) {
+            const int16_t* a = src + i * binSize;
+            const int16_t* b = (i + 1 < count)? a + binSize : a;
+            for (int c = 0; c < binSize; c += 2) {
+                dst[c] = qMin(a[c], b[c]);
+                dst[c + 1] = qMax(a[c + 1], b[c + 1]);
+            }
+            dst += binSize;
+        }
+        level = next;
+    }
+    ((PeakFileHeader*) buffer.data())->levelCount = levelCount;
+
+    AudioPeaks* peaks = new AudioPeaks;
+    peaks->m_buffer = buffer;
+    peaks->setData((const uchar*) peaks->m_buffer.constData(), peaks->m_buffer.size());
+    return AudioPeaksPtr(peaks);
+}
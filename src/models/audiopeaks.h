@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AUDIOPEAKS_H
+#define AUDIOPEAKS_H
+
+#include <QSharedPointer>
+#include <QByteArray>
+#include <QString>
+#include <QMetaType>
+#include <QVector>
+#include <stdint.h>
+
+class QFile;
+class AudioPeaks;
+
+typedef QSharedPointer<const AudioPeaks> AudioPeaksPtr;
+
+/*!
+  \class AudioPeaks
+  \brief The AudioPeaks holds the waveform overview of a media file.
+
+  The overview is a pyramid of levels. Level 0 has binsPerSecond() bins per
+  second, and every following level halves the number of bins. Each bin
+  stores the minimum and maximum sample of every channel as signed 16-bit
+  values, interleaved as min0 max0 min1 max1 ...
+
+  The in-memory layout is identical to the peak file layout so that a peak
+  file is used directly through a read-only memory map. Peak files are kept
+  in the "peaks" folder of the application data location, next to the
+  database.
+*/
+
+class AudioPeaks
+{
+public:
+    ~AudioPeaks();
+
+    //! Returns the path of the peak file for the given cache \a key.
+    static QString filePath(const QString& key);
+
+    /*!
+      Deletes the least recently used peak files beyond the size limit of the
+      folder and the chunks left behind by runs that did not complete.
+    */
+    static void deleteOldFiles();
+
+    //! Maps the peak file at \a path. Returns null if it is missing or invalid.
+    static AudioPeaksPtr load(const QString& path);
+
+    //! Writes the peaks to \a path, replacing the file atomically.
+    bool save(const QString& path) const;
+
+    int channels() const;
+    int binsPerSecond() const;
+    int levelCount() const;
+    int binCount(int level) const;
+
+    //! Returns the interleaved min/max pairs of all channels for \a level, or null.
+    const int16_t* bins(int level) const;
+
+    //! Returns the largest absolute sample (0-32768) of any channel in \a bin.
+    int peak(int level, int bin) const;
+
+    /*!
+      Returns the coarsest level at which one bin covers no more than
+      \a binsPerPixel bins of level 0.
+    */
+    int levelFor(qreal binsPerPixel) const;
+
+    /*!
+      Finds the minimum and maximum sample of all channels over the level 0
+      bins [\a from, \a to) by reading the bins of \a level that cover that
+      range.
+    */
+    void minMax(qreal from, qreal to, int level, int& min, int& max) const;
+
+private:
+    friend class AudioPeaksBuilder;
+    AudioPeaks();
+    bool setData(const uchar* data, qint64 size);
+
+    QByteArray m_buffer;
+    QFile* m_file;
+    const uchar* m_data;
+    QVector<qint64> m_offsets;
+    QVector<int> m_counts;
+};
+
+/*!
+  \class AudioPeaksBuilder
+  \brief The AudioPeaksBuilder computes AudioPeaks from interleaved s16
+  samples.
+*/
+
+class AudioPeaksBuilder
+{
+public:
+    AudioPeaksBuilder(int channels, int frequency, int binsPerSecond = 50);
+
+    int samplesPerBin() const { return m_samplesPerBin; }
+
+    void addSamples(const int16_t* samples, int count);
+    void addSilence(int count);
+
+    /*!
+      Appends the level 0 bins of \a peaks, for example the result of
+      another builder that covered the following range of samples. Only
+      complete bins must have been added to this builder so far.
+    */
+    void append(const AudioPeaks& peaks);
+
+    //! Appends \a count silent bins.
+    void addSilentBins(int count);
+
+    //! Returns the peaks of all samples added so far, including the pyramid.
+    AudioPeaksPtr build() const;
+
+private:
+    void closeBin();
+
+    int m_channels;
+    int m_binsPerSecond;
+    int m_samplesPerBin;
+    int m_samplesInBin;
+    QVector<int16_t> m_current;
+    QByteArray m_bins;
+};
+
+Q_DECLARE_METATYPE(AudioPeaksPtr)
+
+#endif // AUDIOPEAKS_H
@@ -23,6 +23,7 @@
 #include "docks/playlistdock.h"
 #include "util.h"
 #include "audiolevelstask.h"
+#include "filehashservice.h"
 #include "shotcut_mlt_properties.h"
 #include <QScopedPointer>
 #include <QApplication>
@@ -41,6 +42,16 @@ MultitrackModel::MultitrackModel(QObject *parent)
     , m_isMakingTransition(false)
 {
     connect(this, SIGNAL(modified()), SLOT(adjustBackgroundDuration()));
+    // Keep the clip records used by data() in step with the announced changes.
+    connect(this, SIGNAL(modelReset()), SLOT(invalidateClipRecords()));
+    connect(this, SIGNAL(layoutChanged()), SLOT(invalidateClipRecords()));
+    connect(this, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), SLOT(invalidateClipRecords()));
+    connect(this, SIGNAL(rowsInserted(QModelIndex,int,int)), SLOT(invalidateClipRecords(QModelIndex)));
+    connect(this, SIGNAL(rowsRemoved(QModelIndex,int,int)), SLOT(invalidateClipRecords(QModelIndex)));
+    connect(this, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)),
+            SLOT(updateClipRecords(QModelIndex,QModelIndex,QVector<int>)));
+    connect(&FileHashService::singleton(), SIGNAL(hashReady(QString,QString)),
+            SLOT(onFileHashReady(QString,QString)));
 }
 
 MultitrackModel::~MultitrackModel()
@@ -82,88 +93,62 @@ QVariant MultitrackModel::data(const QModelIndex &index, int role) const
         return QVariant();
     if (index.parent().isValid()) {
         // Get data for a clip.
-        int i = m_trackList.at(index.internalId()).mlt_index;
-        QScopedPointer<Mlt::Producer> track(m_tractor->track(i));
-        if (track) {
-            Mlt::Playlist playlist(*track);
-//            LOG_DEBUG() << __FUNCTION__ << index.row();
-            QScopedPointer<Mlt::ClipInfo> info(playlist.clip_info(index.row()));
-            if (info)
-            switch (role) {
-            case NameRole: {
-                QString result;
-                if (info->producer && info->producer->is_valid())
-                    result = info->producer->get(kShotcutCaptionProperty);
-                if (result.isNull())
-                    result = Util::baseName(QString::fromUtf8(info->resource));
-                if (result == "<producer>" && info->producer && info->producer->is_valid())
-                    result = QString::fromUtf8(info->producer->get("mlt_service"));
-                return result;
-            }
-            case ResourceRole:
-            case Qt::DisplayRole: {
-                QString result = QString::fromUtf8(info->resource);
-                if (result == "<producer>" && info->producer
-                        && info->producer->is_valid() && info->producer->get("mlt_service"))
-                    result = QString::fromUtf8(info->producer->get("mlt_service"));
-                return result;
-            }
-            case ServiceRole:
-                if (info->producer && info->producer->is_valid())
-                    return QString::fromUtf8(info->producer->get("mlt_service"));
-                break;
-            case IsBlankRole:
-                return playlist.is_blank(index.row());
-            case StartRole:
-                return info->start;
-            case DurationRole:
-                return info->frame_count;
-            case InPointRole:
-                return info->frame_in;
-            case OutPointRole:
-                return info->frame_out;
-            case FramerateRole:
-                return info->fps;
-            case IsAudioRole:
-                return m_trackList[index.internalId()].type == AudioTrackType;
-            case AudioLevelsRole:
-                if (info->producer->get_data(kAudioLevelsProperty))
-                    return QVariant::fromValue(*((QVariantList*) info->producer->get_data(kAudioLevelsProperty)));
-                else
-                    return QVariant();
-            case FadeInRole: {
-                QScopedPointer<Mlt::Filter> filter(getFilter("fadeInVolume", info->producer));
-                if (!filter || !filter->is_valid())
-                    filter.reset(getFilter("fadeInBrightness", info->producer));
-                if (!filter || !filter->is_valid())
-                    filter.reset(getFilter("fadeInMovit", info->producer));
-                return (filter && filter->is_valid())? filter->get_length() : 0;
-            }
-            case FadeOutRole: {
-                QScopedPointer<Mlt::Filter> filter(getFilter("fadeOutVolume", info->producer));
-                if (!filter || !filter->is_valid())
-                    filter.reset(getFilter("fadeOutBrightness", info->producer));
-                if (!filter || !filter->is_valid())
-                    filter.reset(getFilter("fadeOutMovit", info->producer));
-                return (filter && filter->is_valid())? filter->get_length() : 0;
-            }
-            case IsTransitionRole:
-                return isTransition(playlist, index.row());
-            case FileHashRole:
-                return MAIN.getHash(*info->producer);
-            case SpeedRole: {
-                double speed = 1.0;
-                if (info->producer && info->producer->is_valid()) {
-                    if (!qstrcmp("timewarp", info->producer->get("mlt_service")))
-                        speed = info->producer->get_double("warp_speed");
+        ClipRecord* clip = clipRecord(index.internalId(), index.row());
+        if (clip)
+        switch (role) {
+        case NameRole:
+            return clip->name;
+        case ResourceRole:
+        case Qt::DisplayRole:
+            return clip->resource;
+        case ServiceRole:
+            if (!clip->service.isNull())
+                return clip->service;
+            break;
+        case IsBlankRole:
+            return clip->isBlank;
+        case StartRole:
+            return clip->start;
+        case DurationRole:
+            return clip->duration;
+        case InPointRole:
+            return clip->in;
+        case OutPointRole:
+            return clip->out;
+        case FramerateRole:
+            return clip->fps;
+        case IsAudioRole:
+            return m_trackList[index.internalId()].type == AudioTrackType;
+        case AudioLevelsRole:
+            if (clip->audioLevels)
+                return QVariant::fromValue(clip->audioLevels);
+            else
+                return QVariant();
+        case FadeInRole:
+            return clip->fadeIn;
+        case FadeOutRole:
+            return clip->fadeOut;
+        case IsTransitionRole:
+            return clip->isTransition;
+        case FileHashRole:
+            if (clip->hash.isEmpty()) {
+                // Getting the hash may read the file, so it is only done on request.
+                int i = m_trackList.at(index.internalId()).mlt_index;
+                QScopedPointer<Mlt::Producer> track(m_tractor->track(i));
+                if (track) {
+                    Mlt::Playlist playlist(*track);
+                    QScopedPointer<Mlt::ClipInfo> info(playlist.clip_info(index.row()));
+                    if (info && info->producer)
+                        clip->hash = MAIN.getHash(*info->producer);
                 }
-                return speed;
-            }
-            case IsFilteredRole:
-                return isFiltered(info->producer);
-            default:
-                break;
             }
+            return clip->hash;
+        case SpeedRole:
+            return clip->speed;
+        case IsFilteredRole:
+            return clip->isFiltered;
+        default:
+            break;
         }
     }
     else {
@@ -206,6 +191,181 @@ QVariant MultitrackModel::data(const QModelIndex &index, int role) const
     return QVariant();
 }
 
+MultitrackModel::ClipRecord* MultitrackModel::clipRecord(int trackIndex, int clipIndex) const
+{
+    if (trackIndex < 0 || trackIndex >= m_trackList.size() || clipIndex < 0)
+        return 0;
+    if (m_clipRecords.size() != m_trackList.size()) {
+        m_clipRecords.clear();
+        m_clipRecords.resize(m_trackList.size());
+    }
+    QVector<ClipRecord>& records = m_clipRecords[trackIndex];
+    if (clipIndex >= records.size() || !records[clipIndex].isValid) {
+        QScopedPointer<Mlt::Producer> track(m_tractor->track(m_trackList.at(trackIndex).mlt_index));
+        if (!track)
+            return 0;
+        Mlt::Playlist playlist(*track);
+        int n = playlist.count();
+        if (records.size() != n) {
+            // The track changed without notice; start over.
+            records.clear();
+            records.resize(n);
+        }
+        if (clipIndex >= n)
+            return 0;
+        // Update every outdated record of the track in one pass.
+        for (int i = 0; i < n; i++) {
+            if (!records[i].isValid)
+                updateClipRecord(playlist, i, records[i]);
+        }
+        if (!records[clipIndex].isValid)
+            return 0;
+    }
+    return &records[clipIndex];
+}
+
+void MultitrackModel::updateClipRecord(Mlt::Playlist& playlist, int clipIndex, ClipRecord& record) const
+{
+    QScopedPointer<Mlt::ClipInfo> info(playlist.clip_info(clipIndex));
+    record.isValid = !info.isNull();
+    if (!info)
+        return;
+    bool isValid = info->producer && info->producer->is_valid();
+
+    record.name = QString();
+    if (isValid)
+        record.name = info->producer->get(kShotcutCaptionProperty);
+    if (record.name.isNull())
+        record.name = Util::baseName(QString::fromUtf8(info->resource));
+    if (record.name == "<producer>" && isValid)
+        record.name = QString::fromUtf8(info->producer->get("mlt_service"));
+
+    record.resource = QString::fromUtf8(info->resource);
+    if (record.resource == "<producer>" && isValid && info->producer->get("mlt_service"))
+        record.resource = QString::fromUtf8(info->producer->get("mlt_service"));
+
+    record.service = isValid? QString::fromUtf8(info->producer->get("mlt_service")) : QString();
+    record.isBlank = playlist.is_blank(clipIndex);
+    record.start = info->start;
+    record.duration = info->frame_count;
+    record.in = info->frame_in;
+    record.out = info->frame_out;
+    record.fps = info->fps;
+    record.fadeIn = fadeLength(info->producer, "fadeInVolume", "fadeInBrightness", "fadeInMovit");
+    record.fadeOut = fadeLength(info->producer, "fadeOutVolume", "fadeOutBrightness", "fadeOutMovit");
+    record.isTransition = isTransition(playlist, clipIndex);
+    record.hash = info->producer? QString::fromLatin1(info->producer->get(kShotcutHashProperty)) : QString();
+    record.speed = 1.0;
+    if (isValid && !qstrcmp("timewarp", info->producer->get("mlt_service")))
+        record.speed = info->producer->get_double("warp_speed");
+    record.isFiltered = isFiltered(info->producer);
+    record.audioLevels.clear();
+    if (info->producer && info->producer->get_data(kAudioLevelsProperty))
+        record.audioLevels = *((AudioPeaksPtr*) info->producer->get_data(kAudioLevelsProperty));
+}
+
+int MultitrackModel::fadeLength(Mlt::Producer* producer, const char* volume, const char* brightness, const char* movit) const
+{
+    QScopedPointer<Mlt::Filter> filter(getFilter(volume, producer));
+    if (!filter || !filter->is_valid())
+        filter.reset(getFilter(brightness, producer));
+    if (!filter || !filter->is_valid())
+        filter.reset(getFilter(movit, producer));
+    return (filter && filter->is_valid())? filter->get_length() : 0;
+}
+
+void MultitrackModel::onFileHashReady(const QString& path, const QString& hash)
+{
+    // The hash is already set on the producer. Store it in the records of the
+    // clips of that file and notify them with one change per track.
+    QVector<int> roles;
+    roles << FileHashRole;
+    for (int trackIndex = 0; trackIndex < m_clipRecords.size(); trackIndex++) {
+        QVector<ClipRecord>& records = m_clipRecords[trackIndex];
+        int first = -1;
+        int last = -1;
+        for (int i = 0; i < records.size(); i++) {
+            ClipRecord& record = records[i];
+            if (record.isValid && !record.isBlank && record.hash.isEmpty() && record.resource == path) {
+                record.hash = hash;
+                if (first < 0)
+                    first = i;
+                last = i;
+            }
+        }
+        if (first >= 0)
+            emit dataChanged(createIndex(first, 0, trackIndex), createIndex(last, 0, trackIndex), roles);
+    }
+}
+
+void MultitrackModel::invalidateClipRecords()
+{
+    m_clipRecords.clear();
+}
+
+void MultitrackModel::invalidateClipRecords(const QModelIndex& parent)
+{
+    if (!parent.isValid())
+        m_clipRecords.clear();
+    else if (parent.row() < m_clipRecords.size())
+        m_clipRecords[parent.row()].clear();
+}
+
+void MultitrackModel::updateClipRecords(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles)
+{
+    if (!topLeft.parent().isValid())
+        return;
+    // onFileHashReady() updates the records in place.
+    if (roles.size() == 1 && roles.first() == FileHashRole)
+        return;
+    int trackIndex = topLeft.internalId();
+    if (trackIndex >= m_clipRecords.size() || trackIndex >= m_trackList.size()
+            || m_clipRecords[trackIndex].isEmpty())
+        return;
+    QVector<ClipRecord>& records = m_clipRecords[trackIndex];
+    QScopedPointer<Mlt::Producer> track(m_tractor->track(m_trackList.at(trackIndex).mlt_index));
+    if (!track) {
+        records.clear();
+        return;
+    }
+    Mlt::Playlist playlist(*track);
+    if (playlist.count() != records.size()) {
+        records.clear();
+        return;
+    }
+    bool isLevelsOnly = roles.size() == 1 && roles.first() == AudioLevelsRole;
+    int last = qMin(bottomRight.row(), records.size() - 1);
+
+    // Only the changed rows are read again.
+    for (int i = topLeft.row(); i <= last; i++) {
+        ClipRecord& record = records[i];
+        if (isLevelsOnly && record.isValid) {
+            QScopedPointer<Mlt::ClipInfo> info(playlist.clip_info(i));
+            record.audioLevels.clear();
+            if (info && info->producer && info->producer->get_data(kAudioLevelsProperty))
+                record.audioLevels = *((AudioPeaksPtr*) info->producer->get_data(kAudioLevelsProperty));
+        } else {
+            updateClipRecord(playlist, i, record);
+        }
+    }
+    if (isLevelsOnly)
+        return;
+
+    // A change of duration moves the start of the following clips.
+    for (int i = qMax(1, last + 1); i < records.size(); i++) {
+        const ClipRecord& previous = records[i - 1];
+        ClipRecord& record = records[i];
+        if (!previous.isValid) {
+            record.isValid = false;
+        } else if (record.isValid) {
+            int start = previous.start + previous.duration;
+            if (record.start == start)
+                break;
+            record.start = start;
+        }
+    }
+}
+
 QModelIndex MultitrackModel::index(int row, int column, const QModelIndex &parent) const
 {
     if (column > 0)
@@ -22,8 +22,10 @@
 #include <QAbstractItemModel>
 #include <QList>
 #include <QString>
+#include <QVector>
 #include <MltTractor.h>
 #include <MltPlaylist.h>
+#include "audiopeaks.h"
 
 typedef enum {
     PlaylistTrackType = 0,
@@ -165,9 +167,32 @@ public slots:
     void onFilterChanged(Mlt::Filter* filter);
 
 private:
+    /// The role values of a clip, cached for data().
+    struct ClipRecord {
+        ClipRecord() : isValid(false) {}
+        bool isValid;
+        bool isBlank;
+        bool isTransition;
+        bool isFiltered;
+        QString name;
+        QString resource;
+        QString service;
+        QString hash;
+        int start;
+        int duration;
+        int in;
+        int out;
+        double fps;
+        int fadeIn;
+        int fadeOut;
+        double speed;
+        AudioPeaksPtr audioLevels;
+    };
+
     Mlt::Tractor* m_tractor;
     TrackList m_trackList;
     bool m_isMakingTransition;
+    mutable QVector<QVector<ClipRecord> > m_clipRecords;
 
     bool moveClipToTrack(int fromTrack, int toTrack, int clipIndex, int position);
     void moveClipToEnd(Mlt::Playlist& playlist, int trackIndex, int clipIndex, int position);
@@ -187,11 +212,18 @@ private:
     void removeRegion(int trackIndex, int position, int length);
     void clearMixReferences(int trackIndex, int clipIndex);
     bool isFiltered(Mlt::Producer* producer = 0) const;
+    ClipRecord* clipRecord(int trackIndex, int clipIndex) const;
+    void updateClipRecord(Mlt::Playlist& playlist, int clipIndex, ClipRecord& record) const;
+    int fadeLength(Mlt::Producer* producer, const char* volume, const char* brightness, const char* movit) const;
 
     friend class UndoHelper;
 
 private slots:
     void adjustBackgroundDuration();
+    void invalidateClipRecords();
+    void invalidateClipRecords(const QModelIndex& parent);
+    void updateClipRecords(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles);
+    void onFileHashReady(const QString& path, const QString& hash);
 
 };
 
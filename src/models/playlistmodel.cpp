@@ -32,8 +32,11 @@
 
 #include "settings.h"
 #include "database.h"
+#include "thumbnailproducerpool.h"
 #include "mainwindow.h"
 
+static const char* kThumbnailProfile = "atsc_720p_60";
+
 static void deleteQImage(QImage* image)
 {
     delete image;
@@ -54,7 +57,7 @@ public:
         : QRunnable()
         , m_model(model)
         , m_producer(producer)
-        , m_profile("atsc_720p_60")
+        , m_profile(kThumbnailProfile)
         , m_tempProducer(0)
         , m_in(in)
         , m_out(out)
@@ -63,26 +66,17 @@ public:
 
     ~UpdateThumbnailTask()
     {
-        delete m_tempProducer;
+        if (m_tempProducer)
+            ThumbnailProducerPool::singleton().release(m_tempProducer);
     }
 
-    Mlt::Producer* tempProducer()
+    Mlt::Producer* tempProducer(int frameNumber)
     {
+        // The in and out thumbnails share one pooled producer. Since the in
+        // point is made first, it is checked out for that frame.
         if (!m_tempProducer) {
-            QString service = m_producer.get("mlt_service");
-            if (service == "avformat-novalidate")
-                service = "avformat";
-            else if (service.startsWith("xml"))
-                service = "xml-nogl";
-            m_tempProducer = new Mlt::Producer(m_profile, service.toUtf8().constData(), m_producer.get("resource"));
-            if (m_tempProducer->is_valid()) {
-                Mlt::Filter scaler(m_profile, "swscale");
-                Mlt::Filter padder(m_profile, "resize");
-                Mlt::Filter converter(m_profile, "avcolor_space");
-                m_tempProducer->attach(scaler);
-                m_tempProducer->attach(padder);
-                m_tempProducer->attach(converter);
-            }
+            m_tempProducer = ThumbnailProducerPool::singleton().acquire(kThumbnailProfile,
+                m_producer.get("mlt_service"), QString::fromUtf8(m_producer.get("resource")), frameNumber);
         }
         return m_tempProducer;
     }
@@ -146,7 +140,10 @@ public:
     {
         int height = PlaylistModel::THUMBNAIL_HEIGHT * 2;
         int width = PlaylistModel::THUMBNAIL_WIDTH * 2;
-        return MLT.image(*tempProducer(), frameNumber, width, height);
+        Mlt::Producer* producer = tempProducer(frameNumber);
+        if (!producer->is_valid())
+            return MLT.image(0, width, height);
+        return MLT.image(*producer, frameNumber, width, height);
     }
 
 signals:
@@ -606,8 +603,8 @@ void PlaylistModel::move(int from, int to)
 {
     if (!m_playlist) return;
     m_playlist->move(from, to);
-    emit dataChanged(createIndex(from, 0), createIndex(from, columnCount()));
-    emit dataChanged(createIndex(to, 0), createIndex(to, columnCount()));
+    // Every row between from and to shifts by one.
+    emit dataChanged(createIndex(qMin(from, to), 0), createIndex(qMax(from, to), columnCount() - 1));
     emit modified();
 }
 
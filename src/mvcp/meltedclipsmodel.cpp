@@ -18,7 +18,7 @@
 
 #include "meltedclipsmodel.h"
 
-MeltedClipsModel::MeltedClipsModel(MvcpThread* mvcp, QObject *parent)
+MeltedClipsModel::MeltedClipsModel(MvcpClient* mvcp, QObject *parent)
     : QAbstractItemModel(parent)
     , m_mvcp(mvcp)
     , m_root(new QObject)
@@ -166,17 +166,15 @@ void MeltedClipsModel::fetch(QObject *parent, const QModelIndex& index) const
         return;
     parent->setProperty("fetched", true);
 
-    QMutexLocker locker(const_cast<QMutex*>(&m_mutex));
-    QList<QModelIndex> *pending = (QList<QModelIndex>*) &m_pending;
-    pending->append(index);
+    // Responses arrive in the order of the requests.
+    const_cast<MeltedClipsModel*>(this)->m_pending.append(index);
     m_mvcp->cls(parent->objectName(), parent);
 }
 
 void MeltedClipsModel::onClsResult(QObject* parent, QObjectList* results)
 {
+    QModelIndex index = m_pending.takeFirst();
     if (!results->isEmpty()) {
-        m_mutex.lock();
-        const QModelIndex& index = m_pending.takeFirst();
         int n = results->size();
 
         for (int i = 0; i < n; i++) {
@@ -189,7 +187,6 @@ void MeltedClipsModel::onClsResult(QObject* parent, QObjectList* results)
             child->setProperty("size", o->property("size"));
             delete o;
         }
-        m_mutex.unlock();
         beginInsertRows(index, 0, n - 1);
         endInsertRows();
     }
@@ -20,13 +20,13 @@
 #define MELTEDCLIPSMODEL_H
 
 #include <QtCore>
-#include "mvcpthread.h"
+#include "mvcpclient.h"
 
 class MeltedClipsModel : public QAbstractItemModel
 {
     Q_OBJECT
 public:
-    explicit MeltedClipsModel(MvcpThread* mvcp, QObject *parent = 0);
+    explicit MeltedClipsModel(MvcpClient* mvcp, QObject *parent = 0);
     ~MeltedClipsModel();
 
     QStringList mimeTypes() const;
@@ -43,11 +43,10 @@ public:
     bool hasChildren(const QModelIndex &parent) const;
 
 private:
-    MvcpThread* m_mvcp;
+    MvcpClient* m_mvcp;
     QModelIndex m_rootIndex;
     QObject* m_root;
-    QMutex m_mutex;
-    QList<QModelIndex> m_pending;
+    QList<QPersistentModelIndex> m_pending;
 
     void fetch(QObject* parent, const QModelIndex& index) const;
 
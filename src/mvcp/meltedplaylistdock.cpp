@@ -62,9 +62,9 @@ const TransportControllable *MeltedPlaylistDock::transportControl() const
     return m_transportControl;
 }
 
-void MeltedPlaylistDock::onConnected(const QString &address, quint16 port, quint8 unit)
+void MeltedPlaylistDock::onConnected(MvcpClient* mvcp, quint8 unit)
 {
-    m_model.onConnected(address, port, unit);
+    m_model.onConnected(mvcp, unit);
 }
 
 void MeltedPlaylistDock::onDisconnected()
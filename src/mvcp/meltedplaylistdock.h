@@ -47,7 +47,7 @@ signals:
     void insertRequested(int row);
 
 public slots:
-    void onConnected(const QString& address, quint16 port = 5250, quint8 unit = 0);
+    void onConnected(MvcpClient* mvcp, quint8 unit = 0);
     void onDisconnected();
     void onUnitChanged(quint8 unit);
 
@@ -19,15 +19,18 @@
 #include "meltedplaylistmodel.h"
 #include "mltcontroller.h"
 #include "util.h"
+#include <stdlib.h>
 
 MeltedPlaylistModel::MeltedPlaylistModel(QObject *parent)
     : QAbstractTableModel(parent)
     , m_unit(255)
-    , m_list(0)
-    , m_response(0)
+    , m_generation(-1)
+    , m_dirty(false)
+    , m_listPending(false)
+    , m_refreshAgain(false)
+    , m_nextEdit(0)
     , m_index(-1)
     , m_dropRow(-1)
-    , m_tokeniser(0)
 {
     //XXX qt5
 //    setSupportedDragActions(Qt::MoveAction);
@@ -35,19 +38,12 @@ MeltedPlaylistModel::MeltedPlaylistModel(QObject *parent)
 
 MeltedPlaylistModel::~MeltedPlaylistModel()
 {
-    mvcp_list_close(m_list);
-    m_list = 0;
-    mvcp_response_close(m_response);
-    m_response = 0;
 }
 
 int MeltedPlaylistModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent)
-    if (m_list)
-        return mvcp_list_count(m_list);
-    else
-        return 0;
+    return m_entries.size();
 }
 
 int MeltedPlaylistModel::columnCount(const QModelIndex &parent) const
@@ -58,27 +54,26 @@ int MeltedPlaylistModel::columnCount(const QModelIndex &parent) const
 
 QVariant MeltedPlaylistModel::data(const QModelIndex &index, int role) const
 {
-    if (!m_list || index.row() >= mvcp_list_count(m_list))
+    if (index.row() < 0 || index.row() >= m_entries.size())
         return QVariant();
     switch (role) {
     case Qt::DisplayRole:
     case Qt::ToolTipRole: {
-        mvcp_list_entry_t entry;
-        mvcp_list_get(m_list, index.row(), &entry);
+        const Entry& entry = m_entries[index.row()];
         switch (index.column()) {
         case COLUMN_INDEX:
             return QString::number(index.row() + 1);
         case COLUMN_RESOURCE: {
-            QString result = QString::fromUtf8(entry.full);
+            QString result = entry.resource;
             // Use basename for display
             if (role == Qt::DisplayRole)
                 result = Util::baseName(result);
             return result;
         }
         case COLUMN_IN:
-            return entry.in;
+            return (entry.in < 0)? QVariant() : entry.in;
         case COLUMN_OUT:
-            return entry.out;
+            return (entry.out < 0)? QVariant() : entry.out;
         default:
             break;
         }
@@ -142,7 +137,7 @@ bool MeltedPlaylistModel::insertRows(int row, int count, const QModelIndex &pare
 {
     Q_UNUSED(count)
     Q_UNUSED(parent)
-    if (!m_list) return false;
+    if (m_generation < 0) return false;
     if (m_dropRow == -1)
         m_dropRow = row;
     return true;
@@ -152,7 +147,7 @@ bool MeltedPlaylistModel::removeRows(int row, int count, const QModelIndex &pare
 {
     Q_UNUSED(count)
     Q_UNUSED(parent)
-    if (!m_list) return false;
+    if (m_generation < 0) return false;
     if (row == m_dropRow) return false;
     emit moveClip(row, m_dropRow);
     m_dropRow = -1;
@@ -189,153 +184,155 @@ bool MeltedPlaylistModel::dropMimeData(const QMimeData *data, Qt::DropAction act
 
 void MeltedPlaylistModel::gotoClip(int index)
 {
-    m_commands << MVCP_GOTO;
-    m_socket.write(QString("GOTO U%1 0 %2\r\n").arg(m_unit).arg(index).toLatin1());
+    execute(MVCP_GOTO, QString("GOTO U%1 0 %2").arg(m_unit).arg(index));
     onClipIndexChanged(m_unit, index);
 }
 
 void MeltedPlaylistModel::append(const QString &clip, int in, int out, bool notify)
 {
-    m_commands.append(notify? MVCP_APND : MVCP_IGNORE);
-    m_socket.write(QString("APND U%1 \"%2\" %3 %4\r\n").arg(m_unit).arg(clip).arg(in).arg(out).toUtf8());
+    Edit edit;
+    edit.command = MVCP_APND;
+    edit.entry.resource = clip;
+    edit.entry.in = in;
+    edit.entry.out = out;
+    execute(MVCP_APND, QString("APND U%1 \"%2\" %3 %4").arg(m_unit).arg(clip).arg(in).arg(out), notify, &edit);
 }
 
 void MeltedPlaylistModel::remove(int row, bool notify)
 {
-    m_commands.append(notify? MVCP_REMOVE : MVCP_IGNORE);
-    m_socket.write(QString("REMOVE U%1 %2\r\n").arg(m_unit).arg(row).toLatin1());
+    Edit edit;
+    edit.command = MVCP_REMOVE;
+    edit.row = row;
+    execute(MVCP_REMOVE, QString("REMOVE U%1 %2").arg(m_unit).arg(row), notify, &edit);
 }
 
 void MeltedPlaylistModel::insert(const QString &clip, int row, int in, int out, bool notify)
 {
-    m_commands.append(notify? MVCP_INSERT : MVCP_IGNORE);
-    m_socket.write(QString("INSERT U%1 \"%2\" %3 %4 %5\r\n").arg(m_unit).arg(clip).arg(row).arg(in).arg(out).toUtf8());
+    Edit edit;
+    edit.command = MVCP_INSERT;
+    edit.row = row;
+    edit.entry.resource = clip;
+    edit.entry.in = in;
+    edit.entry.out = out;
+    execute(MVCP_INSERT, QString("INSERT U%1 \"%2\" %3 %4 %5").arg(m_unit).arg(clip).arg(row).arg(in).arg(out), notify, &edit);
 }
 
 void MeltedPlaylistModel::move(int from, int to, bool notify)
 {
-    m_commands.append(notify? MVCP_MOVE : MVCP_IGNORE);
-    m_socket.write(QString("MOVE U%1 %2 %3\r\n").arg(m_unit).arg(from).arg(to).toLatin1());
+    Edit edit;
+    edit.command = MVCP_MOVE;
+    edit.row = from;
+    edit.to = to;
+    execute(MVCP_MOVE, QString("MOVE U%1 %2 %3").arg(m_unit).arg(from).arg(to), notify, &edit);
 }
 
 void MeltedPlaylistModel::wipe()
 {
-    m_commands << MVCP_IGNORE;
-    m_socket.write(QString("WIPE U%1\r\n").arg(m_unit).toLatin1());
+    execute(MVCP_IGNORE, QString("WIPE U%1").arg(m_unit));
 }
 
 void MeltedPlaylistModel::clean()
 {
-    m_commands << MVCP_IGNORE;
-    m_socket.write(QString("CLEAN U%1\r\n").arg(m_unit).toLatin1());
+    execute(MVCP_IGNORE, QString("CLEAN U%1").arg(m_unit));
 }
 
 void MeltedPlaylistModel::clear()
 {
-    m_commands << MVCP_IGNORE;
-    m_socket.write(QString("CLEAR U%1\r\n").arg(m_unit).toLatin1());
+    execute(MVCP_IGNORE, QString("CLEAR U%1").arg(m_unit));
 }
 
 void MeltedPlaylistModel::play(double speed)
 {
-    m_commands << MVCP_IGNORE;
-    m_socket.write(QString("PLAY U%1 %2\r\n").arg(m_unit).arg(1000 * speed).toLatin1());
+    execute(MVCP_IGNORE, QString("PLAY U%1 %2").arg(m_unit).arg(1000 * speed));
 }
 
 void MeltedPlaylistModel::pause()
 {
-    m_commands << MVCP_IGNORE;
-    m_socket.write(QString("PAUSE U%1\r\n").arg(m_unit).toLatin1());
+    execute(MVCP_IGNORE, QString("PAUSE U%1").arg(m_unit));
 }
 
 void MeltedPlaylistModel::stop()
 {
-    m_commands << MVCP_IGNORE;
-    m_socket.write(QString("STOP U%1\r\n").arg(m_unit).toLatin1());
+    execute(MVCP_IGNORE, QString("STOP U%1").arg(m_unit));
 }
 
 void MeltedPlaylistModel::seek(int position)
 {
     pause();
-    m_commands << MVCP_IGNORE;
-    m_socket.write(QString("GOTO U%1 %2\r\n").arg(m_unit).arg(position).toLatin1());
+    execute(MVCP_IGNORE, QString("GOTO U%1 %2").arg(m_unit).arg(position));
 }
 
 void MeltedPlaylistModel::rewind()
 {
-    m_commands << MVCP_IGNORE;
-    m_socket.write(QString("REW U%1\r\n").arg(m_unit).toLatin1());
+    execute(MVCP_IGNORE, QString("REW U%1").arg(m_unit));
 }
 
 void MeltedPlaylistModel::fastForward()
 {
-    m_commands << MVCP_IGNORE;
-    m_socket.write(QString("FF U%1\r\n").arg(m_unit).toLatin1());
+    execute(MVCP_IGNORE, QString("FF U%1").arg(m_unit));
 }
 
 void MeltedPlaylistModel::previous()
 {
-    m_commands << MVCP_IGNORE;
-    m_socket.write(QString("GOTO U%1 0 -1\r\n").arg(m_unit).toLatin1());
+    execute(MVCP_IGNORE, QString("GOTO U%1 0 -1").arg(m_unit));
 }
 
 void MeltedPlaylistModel::next()
 {
-    m_commands << MVCP_IGNORE;
-    m_socket.write(QString("GOTO U%1 0 +1\r\n").arg(m_unit).toLatin1());
+    execute(MVCP_IGNORE, QString("GOTO U%1 0 +1").arg(m_unit));
 }
 
 void MeltedPlaylistModel::setIn(int in)
 {
-    m_commands << MVCP_IGNORE;
-    m_socket.write(QString("SIN U%1 %2\r\n").arg(m_unit).arg(in).toLatin1());
+    execute(MVCP_IGNORE, QString("SIN U%1 %2").arg(m_unit).arg(in));
 }
 
 void MeltedPlaylistModel::setOut(int out)
 {
-    m_commands << MVCP_IGNORE;
-    m_socket.write(QString("SOUT U%1 %2\r\n").arg(m_unit).arg(out).toLatin1());
+    execute(MVCP_IGNORE, QString("SOUT U%1 %2").arg(m_unit).arg(out));
 }
 
-void MeltedPlaylistModel::onConnected(const QString &address, quint16 port, quint8 unit)
+void MeltedPlaylistModel::onConnected(MvcpClient* mvcp, quint8 unit)
 {
-    connect(&m_socket, SIGNAL(readyRead()), this, SLOT(readResponse()));
+    m_mvcp = mvcp;
     m_unit = unit;
-    m_commands << MVCP_IGNORE;
-    m_response = mvcp_response_init();
-    m_tokeniser = mvcp_tokeniser_init();
-    m_socket.connectToHost(address, port);
 }
 
 void MeltedPlaylistModel::onDisconnected()
 {
-    m_socket.disconnect(this);
-    m_socket.disconnectFromHost();
+    // Requests of the closed connection are never answered.
+    m_mvcp = 0;
+    m_edits.clear();
+    reset();
+}
+
+void MeltedPlaylistModel::reset()
+{
     beginResetModel();
-    mvcp_list_close(m_list);
-    m_list = 0;
-    mvcp_response_close(m_response);
-    m_response = 0;
-    if (m_tokeniser) {
-        mvcp_tokeniser_close(m_tokeniser);
-        m_tokeniser = 0;
-    }
+    m_entries.clear();
+    m_generation = -1;
+    m_dirty = false;
+    m_listPending = false;
+    m_refreshAgain = false;
     endResetModel();
 }
 
 void MeltedPlaylistModel::refresh()
 {
-    m_commands << MVCP_LIST;
-    m_socket.write(QString("LIST U%1\r\n").arg(m_unit).toLatin1());
+    // A LIST that is already in flight may have been answered before the
+    // change that triggered this, so ask again once it arrives.
+    if (m_listPending) {
+        m_refreshAgain = true;
+        return;
+    }
+    m_listPending = true;
+    execute(MVCP_LIST, QString("LIST U%1").arg(m_unit));
 }
 
 void MeltedPlaylistModel::onUnitChanged(quint8 unit)
 {
     m_unit = unit;
-    beginResetModel();
-    mvcp_list_close(m_list);
-    m_list = 0;
-    endResetModel();
+    reset();
     refresh();
 }
 
@@ -349,73 +346,168 @@ void MeltedPlaylistModel::onClipIndexChanged(quint8 unit, int index)
     }
 }
 
-void MeltedPlaylistModel::onGenerationChanged(quint8 unit)
+void MeltedPlaylistModel::onGenerationChanged(quint8 unit, int generation)
 {
-    if (unit == m_unit)
-        onUnitChanged(m_unit);
+    // Nothing to fetch when the mirror already includes the change, for
+    // example because it was made by one of our own commands.
+    if (unit == m_unit && (generation != m_generation || m_dirty))
+        refresh();
 }
 
-void MeltedPlaylistModel::readResponse()
+void MeltedPlaylistModel::execute(int command, const QString& text, bool notify, const Edit* edit)
 {
-    QByteArray data = m_socket.readAll();
-    if (data.size() > 0 && m_tokeniser) {
-        m_data.append(data);
-        if (!m_data.contains('\n'))
-            return;
-        // There can be multiple responses in the same data block, so we use a
-        // tokeniser feeding into the mvcp_response.
-        mvcp_tokeniser_parse_new(m_tokeniser, const_cast<char*>(m_data.constData()), "\n");
-        m_data.clear();
-
-        for (int i = 0; i < mvcp_tokeniser_count(m_tokeniser); i++) {
-            char* line = mvcp_tokeniser_get_string(m_tokeniser, i);
-            // mvcp_response_write() looks for line feeds
-            if (line[strlen(line) - 1] == '\r')
-                line[strlen(line) - 1] = '\n';
-            mvcp_response_write(m_response, line, strlen(line));
-            int last_line = mvcp_response_count(m_response) - 1;
-            if (last_line < 0)
-                continue;
-            int terminated = 0;
-            int status = mvcp_response_get_error_code(m_response);
-            switch(status) {
-            case 201:
-            case 500:
-                terminated = !strcmp(mvcp_response_get_line(m_response, last_line), "");
-                break;
-            case 202:
-                terminated = last_line >= 1;
-                break;
-            default:
-                terminated = 1;
-                break;
-            }
-            if (terminated) {
-                int command = m_commands.isEmpty()? MVCP_IGNORE : m_commands.takeFirst();
-                switch (command) {
-                case MVCP_LIST: {
-                    m_list = (mvcp_list) calloc(1, sizeof(*m_list));
-                    m_list->response = mvcp_response_clone(m_response);
-                    if (mvcp_response_count(m_response ) >= 2)
-                        m_list->generation = atoi(mvcp_response_get_line(m_response, 1));
-                    beginInsertRows(QModelIndex(), 0, mvcp_list_count(m_list) - 1);
-                    endInsertRows();
-                    emit loaded();
-                    break;
-                }
-                case MVCP_APND:
-                case MVCP_REMOVE:
-                case MVCP_INSERT:
-                case MVCP_MOVE:
-                    if (status == 200)
-                        emit success();
-                    break;
-                default:
-                    break;
-                }
-                mvcp_response_close(m_response);
-                m_response = mvcp_response_init();
+    if (!m_mvcp)
+        return;
+    // The tag also records the unit so that late responses for a previous
+    // unit are ignored, and the id of the edit the response confirms.
+    int tag = command | (notify? kNotifyFlag : 0) | (m_unit << kUnitShift);
+    if (edit) {
+        int id = m_nextEdit;
+        m_nextEdit = (m_nextEdit + 1) & kEditMask;
+        m_edits.insert(id, *edit);
+        tag |= id << kEditShift;
+    }
+    m_mvcp->send(text, this, "onResponse", tag);
+}
+
+void MeltedPlaylistModel::onResponse(const MvcpResponse& response)
+{
+    int command = response.tag() & kCommandMask;
+    bool notify = response.tag() & kNotifyFlag;
+    bool currentUnit = ((response.tag() >> kUnitShift) & kUnitMask) == m_unit;
+
+    switch (command) {
+    case MVCP_LIST:
+        if (currentUnit) {
+            m_listPending = false;
+            if (response.code() == 201)
+                applyList(response);
+            if (m_refreshAgain) {
+                m_refreshAgain = false;
+                refresh();
             }
         }
+        break;
+    case MVCP_APND:
+    case MVCP_REMOVE:
+    case MVCP_INSERT:
+    case MVCP_MOVE: {
+        Edit edit = m_edits.take((response.tag() >> kEditShift) & kEditMask);
+        if (!currentUnit)
+            break;
+        if (response.code() == 200) {
+            applyEdit(edit);
+            if (notify)
+                emit success();
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void MeltedPlaylistModel::applyEdit(const Edit& edit)
+{
+    if (m_generation < 0)
+        return;
+    int count = m_entries.size();
+    switch (edit.command) {
+    case MVCP_APND:
+        beginInsertRows(QModelIndex(), count, count);
+        m_entries.append(edit.entry);
+        endInsertRows();
+        break;
+    case MVCP_INSERT:
+        if (edit.row < 0 || edit.row > count) {
+            m_dirty = true;
+            return;
+        }
+        beginInsertRows(QModelIndex(), edit.row, edit.row);
+        m_entries.insert(edit.row, edit.entry);
+        endInsertRows();
+        break;
+    case MVCP_REMOVE:
+        if (edit.row < 0 || edit.row >= count) {
+            m_dirty = true;
+            return;
+        }
+        beginRemoveRows(QModelIndex(), edit.row, edit.row);
+        m_entries.removeAt(edit.row);
+        endRemoveRows();
+        break;
+    case MVCP_MOVE:
+        if (edit.row < 0 || edit.row >= count || edit.to < 0 || edit.to >= count) {
+            m_dirty = true;
+            return;
+        }
+        if (edit.row != edit.to) {
+            beginMoveRows(QModelIndex(), edit.row, edit.row, QModelIndex(),
+                          (edit.to > edit.row)? edit.to + 1 : edit.to);
+            m_entries.move(edit.row, edit.to);
+            endMoveRows();
+        }
+        break;
+    default:
+        return;
+    }
+    // The server assigns the in and out points when they are not given, so
+    // the mirror only matches after the next LIST.
+    if (edit.command == MVCP_APND || edit.command == MVCP_INSERT)
+        m_dirty = m_dirty || edit.entry.in < 0 || edit.entry.out < 0;
+    // Every successful edit bumps the playlist generation once.
+    ++m_generation;
+}
+
+void MeltedPlaylistModel::applyList(const MvcpResponse& response)
+{
+    QList<Entry> entries;
+    mvcp_list list = (mvcp_list) calloc(1, sizeof(*list));
+    list->response = response.toMvcpResponse();
+    for (int i = 0; i < mvcp_list_count(list); i++) {
+        mvcp_list_entry_t item;
+        if (mvcp_list_get(list, i, &item) == mvcp_ok) {
+            Entry entry;
+            entry.resource = QString::fromUtf8(item.full);
+            entry.in = item.in;
+            entry.out = item.out;
+            entries << entry;
+        }
+    }
+    mvcp_list_close(list);
+    bool firstLoad = m_generation < 0;
+    m_generation = response.line(1).toInt();
+    m_dirty = false;
+
+    // Only signal the rows between the unchanged head and tail.
+    int oldCount = m_entries.size();
+    int newCount = entries.size();
+    int head = 0;
+    while (head < oldCount && head < newCount && m_entries[head] == entries[head])
+        ++head;
+    int tail = 0;
+    while (tail < oldCount - head && tail < newCount - head
+           && m_entries[oldCount - 1 - tail] == entries[newCount - 1 - tail])
+        ++tail;
+    int oldChanged = oldCount - head - tail;
+    int newChanged = newCount - head - tail;
+    int common = qMin(oldChanged, newChanged);
+
+    for (int i = 0; i < common; i++)
+        m_entries[head + i] = entries[head + i];
+    if (common > 0)
+        emit dataChanged(createIndex(head, 0), createIndex(head + common - 1, COLUMN_COUNT - 1));
+    if (oldChanged > common) {
+        beginRemoveRows(QModelIndex(), head + common, head + oldChanged - 1);
+        for (int i = common; i < oldChanged; i++)
+            m_entries.removeAt(head + common);
+        endRemoveRows();
+    } else if (newChanged > common) {
+        beginInsertRows(QModelIndex(), head + common, head + newChanged - 1);
+        for (int i = common; i < newChanged; i++)
+            m_entries.insert(head + i, entries[head + i]);
+        endInsertRows();
     }
+    if (firstLoad || oldChanged || newChanged)
+        emit loaded();
 }
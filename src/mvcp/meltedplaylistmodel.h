@@ -20,11 +20,12 @@
 #define MELTEDPLAYLISTMODEL_H
 
 #include <QAbstractTableModel>
-#include <QTcpSocket>
+#include <QHash>
+#include <QPointer>
 #include <QStringList>
 #include <QMimeData>
 #include <mvcp.h>
-#include <mvcp_tokeniser.h>
+#include "mvcpclient.h"
 
 class MeltedPlaylistModel : public QAbstractTableModel
 {
@@ -89,27 +90,61 @@ signals:
     void success();
 
 public slots:
-    void onConnected(const QString& address, quint16 port = 5250, quint8 unit = 0);
+    void onConnected(MvcpClient* mvcp, quint8 unit = 0);
     void onDisconnected();
     void refresh();
     void onUnitChanged(quint8 unit);
     void onClipIndexChanged(quint8 unit, int index);
-    void onGenerationChanged(quint8 unit);
+    void onGenerationChanged(quint8 unit, int generation);
 
 private slots:
-    void readResponse();
-//    void onSocketError(QAbstractSocket::SocketError socketError);
+    void onResponse(const MvcpResponse& response);
 
 private:
-    QTcpSocket m_socket;
+    struct Entry {
+        QString resource;
+        int in;
+        int out;
+        Entry() : in(-1), out(-1) {}
+        bool operator==(const Entry& other) const {
+            return in == other.in && out == other.out && resource == other.resource;
+        }
+    };
+
+    struct Edit {
+        int command;
+        int row;
+        int to;
+        Entry entry;
+        Edit() : command(MVCP_IGNORE), row(-1), to(-1) {}
+    };
+
+    // Layout of the request tags
+    enum {
+        kCommandMask = 0xff,
+        kNotifyFlag = 0x100,
+        kUnitShift = 9,
+        kUnitMask = 0xff,
+        kEditShift = 17,
+        kEditMask = 0x3fff
+    };
+
+    void execute(int command, const QString& text, bool notify = false, const Edit* edit = 0);
+    void applyEdit(const Edit& edit);
+    void applyList(const MvcpResponse& response);
+    void reset();
+
+    QPointer<MvcpClient> m_mvcp;
     quint8 m_unit;
-    mvcp_list m_list;
-    mvcp_response m_response;
+    QList<Entry> m_entries;
+    QHash<int, Edit> m_edits;
+    int m_nextEdit;
+    int m_generation;
+    bool m_dirty;
+    bool m_listPending;
+    bool m_refreshAgain;
     int m_index;
-    QList<int> m_commands;
     int m_dropRow;
-    QByteArray m_data;
-    mvcp_tokeniser m_tokeniser;
 };
 
 #endif // MELTEDPLAYLISTMODEL_H
@@ -30,8 +30,8 @@
 MeltedServerDock::MeltedServerDock(QWidget *parent)
     : QDockWidget(parent)
     , ui(new Ui::MeltedServerDock)
-    , m_parser(0)
     , m_mvcp(0)
+    , m_consolePending(0)
 {
     ui->setupUi(this);
 
@@ -50,7 +50,7 @@ MeltedServerDock::MeltedServerDock(QWidget *parent)
     // setup units table
     MeltedUnitsModel* unitsModel = new MeltedUnitsModel(this);
     ui->unitsTableView->setModel(unitsModel);
-    connect(this, SIGNAL(connected(MvcpThread*)), unitsModel, SLOT(onConnected(MvcpThread*)));
+    connect(this, SIGNAL(connected(MvcpClient*)), unitsModel, SLOT(onConnected(MvcpClient*)));
     connect(this, SIGNAL(disconnected()), unitsModel, SLOT(onDisconnected()));
     connect(unitsModel, SIGNAL(positionUpdated(quint8,int,double,int,int,int,bool)), this, SLOT(onPositionUpdated(quint8,int,double,int,int,int,bool)));
 
@@ -65,8 +65,6 @@ MeltedServerDock::MeltedServerDock(QWidget *parent)
 
 MeltedServerDock::~MeltedServerDock()
 {
-    if (m_parser)
-        mvcp_parser_close(m_parser);
     delete ui;
 }
 
@@ -98,30 +96,56 @@ void MeltedServerDock::on_lineEdit_returnPressed()
 
 void MeltedServerDock::onCommandExecuted(QString command)
 {
-    if (!m_parser || command.isEmpty())
+    if (!m_mvcp || !m_mvcp->isConnected() || command.isEmpty())
         return;
 
-    mvcp_response response = mvcp_parser_execute(m_parser,
-        const_cast<char*>(command.toUtf8().constData()));
-    if (response) {
-        for (int index = 0; index < mvcp_response_count(response); index++) {
-            QString line = QString::fromUtf8(mvcp_response_get_line(response, index));
-            m_console->append(line);
-        }
-        mvcp_response_close(response);
-    }
     QString s = command.toLower();
-    if (s == "bye" || s == "exit")
+    // Hide the prompt until the response arrives.
+    m_console->setPrompt("", false);
+    ++m_consolePending;
+    m_mvcp->send(command, this, "onConsoleResponse", (s == "bye" || s == "exit")? 1 : 0);
+}
+
+void MeltedServerDock::onConsoleResponse(const MvcpResponse& response)
+{
+    for (int index = 0; index < response.count(); index++)
+        m_console->append(QString::fromUtf8(response.line(index)));
+    if (--m_consolePending == 0) {
+        m_console->moveCursor(QTextCursor::End);
+        m_console->setPrompt("> ");
+    }
+    if (response.tag())
         ui->connectButton->setChecked(false);
 }
 
+void MeltedServerDock::onServerConnected(QString greeting)
+{
+    m_console->append(greeting.append('\n'));
+    m_console->setEnabled(true);
+    m_console->setPrompt("> ");
+    m_console->setFocus();
+    ui->treeView->setModel(new MeltedClipsModel(m_mvcp));
+    ui->treeView->setEnabled(true);
+    emit connected(m_mvcp);
+    ui->stackedWidget->setCurrentIndex(1);
+    ui->connectButton->setText(tr("Disconnect"));
+    ui->menuButton->setEnabled(true);
+}
+
+void MeltedServerDock::onServerDisconnected()
+{
+    ui->connectButton->setChecked(false);
+}
+
 void MeltedServerDock::on_connectButton_toggled(bool checked)
 {
-    if (m_parser) {
-        delete m_mvcp;
+    if (m_mvcp) {
+        // This may be called from a signal of the client.
+        m_mvcp->disconnect(this);
+        m_mvcp->disconnectFromServer();
+        m_mvcp->deleteLater();
         m_mvcp = 0;
-        mvcp_parser_close(m_parser);
-        m_parser = 0;
+        m_consolePending = 0;
         m_console->setPrompt("");
         m_console->reset();
         m_console->setDisabled(true);
@@ -133,28 +157,10 @@ void MeltedServerDock::on_connectButton_toggled(bool checked)
     if (checked) {
         QStringList address = ui->lineEdit->text().split(':');
         quint16 port = address.size() > 1 ? QString(address[1]).toUInt() : 5250;
-        m_parser = mvcp_parser_init_remote(
-                    const_cast<char*>(address[0].toUtf8().constData()), port);
-        mvcp_response response = mvcp_parser_connect( m_parser );
-        if (response) {
-            for (int index = 0; index < mvcp_response_count(response); index++)
-                m_console->append(QString::fromUtf8(mvcp_response_get_line(response, index)).append('\n'));
-            mvcp_response_close(response);
-            m_console->setEnabled(true);
-            m_console->setPrompt("> ");
-            m_console->setFocus();
-            m_mvcp = new MvcpThread(address[0], port);
-            ui->treeView->setModel(new MeltedClipsModel(m_mvcp));
-            ui->treeView->setEnabled(true);
-            emit connected(m_mvcp);
-            emit connected(address[0], port);
-            ui->stackedWidget->setCurrentIndex(1);
-            ui->connectButton->setText(tr("Disconnect"));
-            ui->menuButton->setEnabled(true);
-        }
-        else {
-            ui->connectButton->setChecked(false);
-        }
+        m_mvcp = new MvcpClient(this);
+        connect(m_mvcp, SIGNAL(connected(QString)), this, SLOT(onServerConnected(QString)));
+        connect(m_mvcp, SIGNAL(disconnected()), this, SLOT(onServerDisconnected()));
+        m_mvcp->connectToServer(address[0], port);
     } else {
         ui->stackedWidget->setCurrentIndex(0);
         ui->connectButton->setText(tr("Connect"));
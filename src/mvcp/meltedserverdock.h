@@ -21,8 +21,7 @@
 
 #include <QDockWidget>
 #include <QModelIndex>
-#include <mvcp_remote.h>
-#include "mvcpthread.h"
+#include "mvcpclient.h"
 
 class QConsole;
 
@@ -46,8 +45,7 @@ public:
     QAction* actionStop() const;
 
 signals:
-    void connected(MvcpThread*);
-    void connected(QString address, quint16 port);
+    void connected(MvcpClient*);
     void disconnected();
     void unitActivated(quint8);
     void unitOpened(quint8);
@@ -63,6 +61,9 @@ public slots:
 private slots:
     void on_lineEdit_returnPressed();
     void onCommandExecuted(QString);
+    void onConsoleResponse(const MvcpResponse& response);
+    void onServerConnected(QString greeting);
+    void onServerDisconnected();
     void on_connectButton_toggled(bool checked);
     void on_unitsTableView_clicked(const QModelIndex &index);
     void on_unitsTableView_doubleClicked(const QModelIndex &index);
@@ -80,8 +81,8 @@ private slots:
 private:
     Ui::MeltedServerDock *ui;
     QConsole* m_console;
-    mvcp_parser m_parser;
-    MvcpThread* m_mvcp;
+    MvcpClient* m_mvcp;
+    int m_consolePending;
     QString m_mappedClipsRoot;
 };
 
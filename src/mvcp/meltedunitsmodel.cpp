@@ -17,14 +17,12 @@
  */
 
 #include "meltedunitsmodel.h"
-#include <QTimer>
-#include <mvcp_util.h>
 #include <Logger.h>
+#include <string.h>
 
 MeltedUnitsModel::MeltedUnitsModel(QObject *parent)
     : QAbstractTableModel(parent)
     , m_mvcp(0)
-    , m_tokeniser(0)
     , m_statusSent(false)
 {
 }
@@ -72,30 +70,20 @@ QVariant MeltedUnitsModel::headerData(int section, Qt::Orientation orientation,
         return QVariant();
 }
 
-void MeltedUnitsModel::onConnected(MvcpThread *a_mvcp)
+void MeltedUnitsModel::onConnected(MvcpClient *a_mvcp)
 {
     m_mvcp = a_mvcp;
+    m_statusSent = false;
     connect(m_mvcp, SIGNAL(ulsResult(QStringList)), this, SLOT(onUlsResult(QStringList)));
+    connect(m_mvcp, SIGNAL(statusReceived(QByteArray)), this, SLOT(onStatusReceived(QByteArray)));
     m_mvcp->uls();
 }
 
-void MeltedUnitsModel::onConnected(const QString &address, quint16 port, quint8 /*unit*/)
-{
-    m_tokeniser = mvcp_tokeniser_init();
-    m_statusSent = false;
-    connect(&m_socket, SIGNAL(readyRead()), this, SLOT(readResponse()));
-    m_socket.connectToHost(address, port);
-}
-
 void MeltedUnitsModel::onDisconnected()
 {
-    m_socket.disconnect(this);
-    m_socket.disconnectFromHost();
+    if (m_mvcp)
+        m_mvcp->disconnect(this);
     m_mvcp = 0;
-    if (m_tokeniser) {
-        mvcp_tokeniser_close(m_tokeniser);
-        m_tokeniser = 0;
-    }
     if (rowCount() > 0) {
         emit beginRemoveRows(QModelIndex(), 0, rowCount() - 1);
         foreach (QObject* o, m_units)
@@ -120,55 +108,36 @@ QString MeltedUnitsModel::decodeStatus(unit_status status)
     return QString();
 }
 
-void MeltedUnitsModel::readResponse()
+void MeltedUnitsModel::onStatusReceived(QByteArray line)
 {
-    QByteArray data = m_socket.readAll();
-    if (data.size() > 0 && m_tokeniser)
-    {
-        mvcp_status_t status;
-        m_data.append(data);
-        if (m_data.contains('\n')) {
-            mvcp_tokeniser_parse_new(m_tokeniser, const_cast<char*>(m_data.constData()), "\n");
-            m_data.clear();
-            for (int i = 0; i < mvcp_tokeniser_count(m_tokeniser); i++) {
-                char* line = mvcp_tokeniser_get_string(m_tokeniser, i);
-                if (!line || strlen(line) <= 1 || !strcmp(line, "100 VTR Ready\r"))
-                    continue;
-                if (line[strlen(line) - 1] == '\r') {
-                    mvcp_util_chomp(line);
-                    mvcp_status_parse(&status, line);
-                    if (status.status != unit_unknown && status.unit < m_units.size()) {
-                        // Refresh the status table cell if changed
-                        if (!m_units[status.unit]->property("unit_status").isValid() ||
-                                m_units[status.unit]->property("unit_status").toInt() != status.status) {
-                            m_units[status.unit]->setProperty("unit_status", status.status);
-                            m_units[status.unit]->setProperty("status", decodeStatus(status.status));
-                            emit dataChanged(createIndex(status.unit, 1), createIndex(status.unit, 1));
-                        }
-                        // Inform others like the MeltedPlaylistModel when the currently playing clip has changed.
-                        if (!m_units[status.unit]->property("clip_index").isValid() ||
-                                m_units[status.unit]->property("clip_index").toInt() != status.clip_index) {
-                            m_units[status.unit]->setProperty("clip_index", status.clip_index);
-                            emit clipIndexChanged(status.unit, status.clip_index);
-                        }
-                        // Inform others like the MeltedPlaylistModel when the playlist has changed.
-                        if (!m_units[status.unit]->property("generation").isValid() ||
-                                m_units[status.unit]->property("generation").toInt() != status.generation) {
-                            m_units[status.unit]->setProperty("generation", status.generation);
-                            emit generationChanged(status.unit);
-                        }
-                        emit positionUpdated(status.unit, status.position, status.fps,
-                            status.in, status.out, status.length, status.status == unit_playing);
-                    }
-                    else if (status.status != unit_unknown && status.unit >= m_units.size()) {
-                        m_mvcp->uls();
-                    }
-                }
-                else {
-                    m_data.append(line, strlen(line));
-                }
-            }
+    mvcp_status_t status;
+    memset(&status, 0, sizeof(status));
+    mvcp_status_parse(&status, line.data());
+    if (status.status != unit_unknown && status.unit < m_units.size()) {
+        // Refresh the status table cell if changed
+        if (!m_units[status.unit]->property("unit_status").isValid() ||
+                m_units[status.unit]->property("unit_status").toInt() != status.status) {
+            m_units[status.unit]->setProperty("unit_status", status.status);
+            m_units[status.unit]->setProperty("status", decodeStatus(status.status));
+            emit dataChanged(createIndex(status.unit, 1), createIndex(status.unit, 1));
+        }
+        // Inform others like the MeltedPlaylistModel when the currently playing clip has changed.
+        if (!m_units[status.unit]->property("clip_index").isValid() ||
+                m_units[status.unit]->property("clip_index").toInt() != status.clip_index) {
+            m_units[status.unit]->setProperty("clip_index", status.clip_index);
+            emit clipIndexChanged(status.unit, status.clip_index);
         }
+        // Inform others like the MeltedPlaylistModel when the playlist has changed.
+        if (!m_units[status.unit]->property("generation").isValid() ||
+                m_units[status.unit]->property("generation").toInt() != status.generation) {
+            m_units[status.unit]->setProperty("generation", status.generation);
+            emit generationChanged(status.unit, status.generation);
+        }
+        emit positionUpdated(status.unit, status.position, status.fps,
+            status.in, status.out, status.length, status.status == unit_playing);
+    }
+    else if (status.status != unit_unknown && status.unit >= m_units.size() && m_mvcp) {
+        m_mvcp->uls();
     }
 }
 
@@ -184,7 +153,7 @@ void MeltedUnitsModel::onUlsResult(QStringList units)
         emit dataChanged(createIndex(i, 0), createIndex(i, 0));
     }
     if (!m_statusSent) {
-        m_socket.write(QString("STATUS\r\n").toLatin1());
+        m_mvcp->subscribeStatus();
         m_statusSent = true;
     }
 }
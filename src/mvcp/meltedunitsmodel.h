@@ -20,11 +20,8 @@
 #define MELTEDUNITSMODEL_H
 
 #include <QAbstractTableModel>
-#include <QTcpSocket>
-#include "mvcpthread.h"
-#include <mvcp_tokeniser.h>
-
-class QTimer;
+#include <QPointer>
+#include "mvcpclient.h"
 
 class MeltedUnitsModel : public QAbstractTableModel
 {
@@ -41,29 +38,23 @@ public:
 signals:
     void disconnected();
     void clipIndexChanged(quint8 unit, int index);
-    void generationChanged(quint8 unit);
+    void generationChanged(quint8 unit, int generation);
     void positionUpdated(quint8 unit, int position, double fps, int in, int out, int length, bool isPlaying);
 
 public slots:
-    void onConnected(MvcpThread*);
-    void onConnected(const QString& address, quint16 port = 5250, quint8 unit = 0);
+    void onConnected(MvcpClient*);
     void onDisconnected();
 
-private slots:
-    void readResponse();
-
 private:
-    MvcpThread* m_mvcp;
-    QTcpSocket m_socket;
+    QPointer<MvcpClient> m_mvcp;
     QObjectList m_units;
-    mvcp_tokeniser m_tokeniser;
-    QByteArray m_data;
     bool m_statusSent;
 
     QString decodeStatus(unit_status status);
 
 private slots:
     void onUlsResult(QStringList);
+    void onStatusReceived(QByteArray line);
 };
 
 #endif // MELTEDUNITSMODEL_H
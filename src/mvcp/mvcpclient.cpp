@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mvcpclient.h"
+#include <QVariant>
+#include <Logger.h>
+#include <stdlib.h>
+#include <string.h>
+
+MvcpResponse::MvcpResponse()
+    : m_tag(0)
+    , m_code(0)
+{
+}
+
+QByteArray MvcpResponse::line(int index) const
+{
+    if (index < 0 || index >= count())
+        return QByteArray();
+    int start = m_offsets[index];
+    int end = m_offsets[index + 1];
+    while (end > start && (m_data[end - 1] == '\n' || m_data[end - 1] == '\r'))
+        --end;
+    return m_data.mid(start, end - start);
+}
+
+mvcp_response MvcpResponse::toMvcpResponse() const
+{
+    mvcp_response response = mvcp_response_init();
+    if (!m_data.isEmpty())
+        mvcp_response_write(response, m_data.constData(), m_data.size());
+    return response;
+}
+
+MvcpClient::MvcpClient(QObject *parent)
+    : QObject(parent)
+    , m_port(5250)
+    , m_greeted(false)
+    , m_responseStart(0)
+    , m_scanned(0)
+    , m_statusGreeted(false)
+{
+    m_socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(&m_socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+    connect(&m_socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(onSocketError(QAbstractSocket::SocketError)));
+    connect(&m_statusSocket, SIGNAL(readyRead()), this, SLOT(onStatusReadyRead()));
+}
+
+void MvcpClient::connectToServer(const QString& address, quint16 port)
+{
+    disconnectFromServer();
+    m_address = address;
+    m_port = port;
+    m_socket.connectToHost(address, port);
+}
+
+void MvcpClient::disconnectFromServer()
+{
+    m_socket.abort();
+    m_statusSocket.abort();
+    m_greeted = false;
+    m_pending.clear();
+    m_clsParents.clear();
+    m_buffer.clear();
+    m_responseStart = 0;
+    m_scanned = 0;
+    m_lineStarts.clear();
+    m_statusBuffer.clear();
+    m_statusGreeted = false;
+}
+
+void MvcpClient::send(const QString& command, QObject* receiver, const char* member, int tag)
+{
+    Request request;
+    request.receiver = receiver;
+    request.member = member;
+    request.tag = tag;
+    m_pending.append(request);
+    // QTcpSocket buffers this while still connecting, and the server only
+    // reads it after its greeting, which is why the greeting is not matched
+    // against a request.
+    m_socket.write(command.toUtf8().append("\r\n"));
+}
+
+void MvcpClient::onReadyRead()
+{
+    m_buffer.append(m_socket.readAll());
+    int end;
+    while ((end = m_buffer.indexOf('\n', m_scanned)) >= 0) {
+        m_lineStarts.append(m_scanned);
+        m_scanned = end + 1;
+        if (isTerminated())
+            finishResponse();
+    }
+    // Drop the complete responses once per read instead of once per line.
+    if (m_responseStart > 0) {
+        m_buffer.remove(0, m_responseStart);
+        m_scanned -= m_responseStart;
+        for (int i = 0; i < m_lineStarts.size(); i++)
+            m_lineStarts[i] -= m_responseStart;
+        m_responseStart = 0;
+    }
+}
+
+bool MvcpClient::isTerminated() const
+{
+    if (!m_greeted)
+        return true;
+    int lines = m_lineStarts.size();
+    int lastLength = m_scanned - m_lineStarts.last();
+    bool lastIsEmpty = lastLength == 1 || (lastLength == 2 && m_buffer[m_lineStarts.last()] == '\r');
+    switch (atoi(m_buffer.constData() + m_responseStart)) {
+    case 201:
+    case 500:
+        return lines > 1 && lastIsEmpty;
+    case 202:
+        return lines > 1;
+    default:
+        return true;
+    }
+}
+
+void MvcpClient::finishResponse()
+{
+    MvcpResponse response;
+    response.m_code = atoi(m_buffer.constData() + m_responseStart);
+    response.m_data = m_buffer.mid(m_responseStart, m_scanned - m_responseStart);
+    for (int i = 0; i < m_lineStarts.size(); i++)
+        response.m_offsets.append(m_lineStarts[i] - m_responseStart);
+    response.m_offsets.append(m_scanned - m_responseStart);
+    m_responseStart = m_scanned;
+    m_lineStarts.clear();
+
+    if (!m_greeted) {
+        m_greeted = true;
+        emit connected(QString::fromUtf8(response.line(0)));
+    } else if (m_pending.isEmpty()) {
+        LOG_WARNING() << "unexpected MVCP response" << response.line(0);
+    } else {
+        Request request = m_pending.takeFirst();
+        response.m_tag = request.tag;
+        if (request.receiver && !request.member.isEmpty())
+            QMetaObject::invokeMethod(request.receiver, request.member.constData(),
+                Qt::DirectConnection, Q_ARG(MvcpResponse, response));
+    }
+}
+
+void MvcpClient::onSocketError(QAbstractSocket::SocketError)
+{
+    LOG_WARNING() << "MVCP connection to" << m_address << "failed:" << m_socket.errorString();
+    disconnectFromServer();
+    emit disconnected();
+}
+
+void MvcpClient::subscribeStatus()
+{
+    if (m_statusSocket.state() != QAbstractSocket::UnconnectedState)
+        return;
+    m_statusGreeted = false;
+    m_statusBuffer.clear();
+    m_statusSocket.connectToHost(m_address, m_port);
+    m_statusSocket.write("STATUS\r\n");
+}
+
+void MvcpClient::onStatusReadyRead()
+{
+    m_statusBuffer.append(m_statusSocket.readAll());
+    int start = 0;
+    int end;
+    while ((end = m_statusBuffer.indexOf('\n', start)) >= 0) {
+        int length = end - start;
+        if (length > 0 && m_statusBuffer[end - 1] == '\r')
+            --length;
+        QByteArray line = m_statusBuffer.mid(start, length);
+        start = end + 1;
+        if (!m_statusGreeted)
+            m_statusGreeted = true;
+        else if (!line.isEmpty())
+            emit statusReceived(line);
+    }
+    m_statusBuffer.remove(0, start);
+}
+
+void MvcpClient::uls()
+{
+    send("ULS", this, "onUlsResponse");
+}
+
+void MvcpClient::onUlsResponse(const MvcpResponse& response)
+{
+    mvcp_units units = (mvcp_units) calloc(1, sizeof(*units));
+    units->response = response.toMvcpResponse();
+    QStringList unitList;
+    for (int i = 0; i < mvcp_units_count(units); i++) {
+        mvcp_unit_entry_t unit;
+        mvcp_units_get(units, i, &unit);
+        unitList << QString::fromUtf8(unit.guid);
+    }
+    mvcp_units_close(units);
+    emit ulsResult(unitList);
+}
+
+void MvcpClient::cls(QString path, QObject* parent)
+{
+    parent->setProperty("path", path);
+    m_clsParents.append(parent);
+    send(QString("CLS \"%1\"").arg(path), this, "onClsResponse");
+}
+
+void MvcpClient::onClsResponse(const MvcpResponse& response)
+{
+    QPointer<QObject> parent = m_clsParents.takeFirst();
+    if (!parent)
+        return;
+    QObjectList* result = new QObjectList;
+    mvcp_dir dir = (mvcp_dir) calloc(1, sizeof(*dir));
+    dir->directory = strdup(parent->property("path").toString().toUtf8().constData());
+    dir->response = response.toMvcpResponse();
+    int n = mvcp_dir_count(dir);
+    for (int i = 0; i < n; i++) {
+        mvcp_dir_entry_t entry;
+        mvcp_dir_get(dir, i, &entry);
+        QObject* o = new QObject;
+        o->setObjectName(QString::fromUtf8(entry.full));
+        o->setProperty("name", QString::fromUtf8(entry.name));
+        o->setProperty("dir", entry.dir);
+        o->setProperty("size", entry.size);
+        result->append(o);
+    }
+    mvcp_dir_close(dir);
+    emit clsResult(parent, result);
+}
+
+void MvcpClient::usta(quint8 unit)
+{
+    send(QString("USTA U%1").arg(unit), this, "onUstaResponse", unit);
+}
+
+void MvcpClient::onUstaResponse(const MvcpResponse& response)
+{
+    mvcp_status_t status;
+    memset(&status, 0, sizeof(status));
+    status.unit = response.tag();
+    QByteArray line = response.line(1);
+    if (response.code() == 202 && response.count() == 2)
+        mvcp_status_parse(&status, line.data());
+    else if (response.code() == 403)
+        status.status = unit_undefined;
+    QString s;
+    switch (status.status) {
+    case unit_unknown:      s = tr("unknown"); break;
+    case unit_undefined:    s = tr("undefined"); break;
+    case unit_offline:      s = tr("offline"); break;
+    case unit_not_loaded:   s = tr("unloaded"); break;
+    case unit_stopped:      s = tr("stopped"); break;
+    case unit_playing:      s = tr("playing"); break;
+    case unit_paused:       s = tr("paused"); break;
+    case unit_disconnected: s = tr("disconnected"); break;
+    }
+    QObject* result = new QObject;
+    result->setProperty("unit", status.unit);
+    result->setProperty("status", s);
+    result->setProperty("clip", QString::fromUtf8(status.clip));
+    result->setProperty("position", status.position);
+    result->setProperty("generation", status.generation);
+    result->setProperty("clip_index", status.clip_index);
+    emit ustaResult(result);
+}
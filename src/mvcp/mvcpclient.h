@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MVCPCLIENT_H
+#define MVCPCLIENT_H
+
+#include <QObject>
+#include <QTcpSocket>
+#include <QPointer>
+#include <QStringList>
+#include <QVector>
+#include <mvcp.h>
+
+/*!
+  \class MvcpResponse
+  \brief The MvcpResponse holds one complete response of a melted server.
+
+  The lines are kept as they arrived in one block together with the offsets
+  at which each line starts, so no line is copied until it is asked for.
+*/
+
+class MvcpResponse
+{
+public:
+    MvcpResponse();
+
+    int tag() const { return m_tag; }
+    int code() const { return m_code; }
+    bool isSuccess() const { return m_code >= 200 && m_code < 300; }
+
+    //! Returns the number of lines including the status line.
+    int count() const { return qMax(0, m_offsets.size() - 1); }
+
+    //! Returns line \a index without the line terminator.
+    QByteArray line(int index) const;
+
+    //! Returns a libmvcp response of the same lines; the caller must close it.
+    mvcp_response toMvcpResponse() const;
+
+private:
+    friend class MvcpClient;
+    int m_tag;
+    int m_code;
+    QByteArray m_data;
+    QVector<int> m_offsets;
+};
+
+Q_DECLARE_METATYPE(MvcpResponse)
+
+/*!
+  \class MvcpClient
+  \brief The MvcpClient talks to a melted server without blocking.
+
+  Commands are written as soon as they are sent, so several of them can be in
+  flight on the one connection. Because the server answers in order, each
+  response is handed to the receiver of the oldest outstanding command. The
+  responses are parsed incrementally as data arrives: a line is scanned only
+  once and consumed bytes are discarded once per read.
+
+  Unit status notifications need a connection of their own because the
+  STATUS command turns it into a push-only stream. subscribeStatus() opens it
+  from the same object, so both are serviced by the event loop of the thread
+  owning the client and nothing ever waits on the network.
+*/
+
+class MvcpClient : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MvcpClient(QObject *parent = 0);
+
+    void connectToServer(const QString& address, quint16 port = 5250);
+    void disconnectFromServer();
+    bool isConnected() const { return m_greeted; }
+    QString address() const { return m_address; }
+    quint16 port() const { return m_port; }
+
+    /*!
+      Sends \a command and returns immediately. When its response arrives
+      the slot \a member (a name without signature) of \a receiver is invoked
+      with the MvcpResponse carrying \a tag. The response is dropped if no
+      receiver is given or it was destroyed.
+    */
+    void send(const QString& command, QObject* receiver = 0, const char* member = 0, int tag = 0);
+
+    //! Returns the number of commands still waiting for a response.
+    int pendingCount() const { return m_pending.size(); }
+
+    void uls();
+    void cls(QString path, QObject *parent);
+    void usta(quint8 unit);
+
+    //! Starts emitting statusReceived() for every status change of any unit.
+    void subscribeStatus();
+
+signals:
+    void connected(QString greeting);
+    void disconnected();
+    void ulsResult(QStringList);  // list of unit names
+    void clsResult(QObject* parent, QObjectList* children); // each object has name, full, dir, and size properties
+    void ustaResult(QObject*);    // properties named same as mcvp_status
+    void statusReceived(QByteArray line);
+
+private slots:
+    void onReadyRead();
+    void onStatusReadyRead();
+    void onSocketError(QAbstractSocket::SocketError);
+    void onUlsResponse(const MvcpResponse& response);
+    void onClsResponse(const MvcpResponse& response);
+    void onUstaResponse(const MvcpResponse& response);
+
+private:
+    struct Request {
+        QPointer<QObject> receiver;
+        QByteArray member;
+        int tag;
+    };
+
+    bool isTerminated() const;
+    void finishResponse();
+
+    QString m_address;
+    quint16 m_port;
+    QTcpSocket m_socket;
+    QTcpSocket m_statusSocket;
+    bool m_greeted;
+    QList<Request> m_pending;
+    QList<QPointer<QObject> > m_clsParents;
+    QByteArray m_buffer;
+    int m_responseStart;
+    int m_scanned;
+    QVector<int> m_lineStarts;
+    QByteArray m_statusBuffer;
+    bool m_statusGreeted;
+};
+
+#endif // MVCPCLIENT_H
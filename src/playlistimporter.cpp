@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "playlistimporter.h"
+#include "mainwindow.h"
+#include "mltcontroller.h"
+#include "filehashservice.h"
+#include "proxymanager.h"
+#include "shotcut_mlt_properties.h"
+#include "models/playlistmodel.h"
+#include "commands/playlistcommands.h"
+#include <QDir>
+#include <QRunnable>
+#include <QUndoStack>
+#include <Logger.h>
+
+class ImportFileTask : public QRunnable
+{
+public:
+    ImportFileTask(PlaylistImporter* importer, int index, const QString& filename)
+        : QRunnable()
+        , m_importer(importer)
+        , m_index(index)
+        , m_filename(filename)
+    {}
+
+    void run()
+    {
+        Mlt::Producer* producer = 0;
+        if (!m_importer->m_isCanceled.load()) {
+            // This is a worker thread, so it can wait for the hash, which
+            // also makes it known to ProxyManager::resourceFor().
+            QString hash = FileHashService::singleton().hash(m_filename);
+            QString resource = ProxyManager::singleton().resourceFor(m_filename);
+            producer = new Mlt::Producer(MLT.profile(), resource.toUtf8().constData());
+            if (producer->is_valid()) {
+                // Convert avformat to avformat-novalidate so that XML loads faster.
+                if (!qstrcmp(producer->get("mlt_service"), "avformat")) {
+                    producer->set("mlt_service", "avformat-novalidate");
+                    producer->set("mute_on_pause", 0);
+                }
+                MLT.setImageDurationFromDefault(producer);
+                if (resource != m_filename) {
+                    ProxyManager::setOriginal(*producer, m_filename, hash);
+                } else if (!hash.isEmpty()) {
+                    producer->set(kShotcutHashProperty, hash.toLatin1().constData());
+                }
+            } else {
+                LOG_WARNING() << "failed to open" << m_filename;
+                delete producer;
+                producer = 0;
+            }
+        }
+        m_importer->setProducer(m_index, producer);
+    }
+
+private:
+    PlaylistImporter* m_importer;
+    int m_index;
+    QString m_filename;
+};
+
+PlaylistImporter::PlaylistImporter(PlaylistModel& model, const QStringList& filenames, QObject* parent)
+    : QObject(parent)
+    , m_model(model)
+    , m_openedCount(0)
+    , m_isCanceled(0)
+{
+    foreach (QString filename, filenames) {
+        if (QDir::toNativeSeparators(filename) == QDir::toNativeSeparators(MAIN.fileName()))
+            MAIN.showStatusMessage(QObject::tr("You cannot add a project to itself!"));
+        else
+            m_filenames << filename;
+    }
+    m_producers.fill(0, m_filenames.count());
+    m_pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+PlaylistImporter::~PlaylistImporter()
+{
+    m_pool.waitForDone();
+    qDeleteAll(m_producers);
+}
+
+void PlaylistImporter::start()
+{
+    if (m_filenames.isEmpty()) {
+        emit finished();
+        deleteLater();
+        return;
+    }
+    for (int i = 0; i < m_filenames.count(); i++)
+        m_pool.start(new ImportFileTask(this, i, m_filenames[i]));
+}
+
+void PlaylistImporter::cancel()
+{
+    // The remaining tasks return without opening their file.
+    m_isCanceled.store(1);
+}
+
+// This is called by the tasks in their threads; each writes its own slot.
+void PlaylistImporter::setProducer(int index, Mlt::Producer* producer)
+{
+    m_producers[index] = producer;
+    QMetaObject::invokeMethod(this, "onFileOpened", Qt::QueuedConnection);
+}
+
+void PlaylistImporter::onFileOpened()
+{
+    emit progressChanged(++m_openedCount);
+    if (m_openedCount == m_filenames.count()) {
+        if (!m_isCanceled.load())
+            commit();
+        emit finished();
+        deleteLater();
+    }
+}
+
+void PlaylistImporter::commit()
+{
+    QUndoStack* undoStack = MAIN.undoStack();
+    undoStack->beginMacro(tr("Append %n playlist item(s)", 0, m_filenames.count()));
+    foreach (Mlt::Producer* producer, m_producers) {
+        if (producer)
+            undoStack->push(new Playlist::AppendCommand(m_model, *producer));
+    }
+    undoStack->endMacro();
+    foreach (Mlt::Producer* producer, m_producers) {
+        if (producer)
+            ProxyManager::singleton().generate(*producer);
+    }
+}
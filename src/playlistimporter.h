@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PLAYLISTIMPORTER_H
+#define PLAYLISTIMPORTER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <MltProducer.h>
+
+class PlaylistModel;
+
+/*!
+  \class PlaylistImporter
+  \brief The PlaylistImporter appends a list of files to the playlist.
+
+  The files are opened and hashed concurrently on a pool of its own. When
+  all of them are open, the valid ones are appended in the original order
+  as one undoable macro. The producers are appended directly instead of
+  being serialized to XML and parsed again.
+
+  The importer reports progress as the number of opened files and deletes
+  itself after finished() is emitted. After cancel() nothing is appended.
+*/
+
+class PlaylistImporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    PlaylistImporter(PlaylistModel& model, const QStringList& filenames, QObject* parent = 0);
+    virtual ~PlaylistImporter();
+
+    void start();
+    int count() const { return m_filenames.count(); }
+
+public slots:
+    void cancel();
+
+signals:
+    void progressChanged(int value);
+    void finished();
+
+private slots:
+    void onFileOpened();
+
+private:
+    friend class ImportFileTask;
+    void setProducer(int index, Mlt::Producer* producer);
+    void commit();
+
+    PlaylistModel& m_model;
+    QStringList m_filenames;
+    QVector<Mlt::Producer*> m_producers;
+    int m_openedCount;
+    QAtomicInt m_isCanceled;
+    QThreadPool m_pool;
+};
+
+#endif // PLAYLISTIMPORTER_H
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "proxymanager.h"
+#include "database.h"
+#include "filehashservice.h"
+#include "jobqueue.h"
+#include "settings.h"
+#include "shotcut_mlt_properties.h"
+#include "jobs/proxyjob.h"
+#include <QDir>
+#include <QDomDocument>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <Logger.h>
+
+static QDomElement findProperty(const QDomElement& service, const QString& name)
+{
+    for (QDomElement e = service.firstChildElement("property"); !e.isNull();
+         e = e.nextSiblingElement("property")) {
+        if (e.attribute("name") == name)
+            return e;
+    }
+    return QDomElement();
+}
+
+static void setPropertyText(QDomElement& property, const QString& text)
+{
+    while (property.hasChildNodes())
+        property.removeChild(property.firstChild());
+    property.appendChild(property.ownerDocument().createTextNode(text));
+}
+
+ProxyManager::ProxyManager(QObject* parent)
+    : QObject(parent)
+    , m_enabled(Settings.playerProxy())
+    , m_pending()
+{
+    connect(&FileHashService::singleton(), SIGNAL(hashReady(QString,QString)),
+            SLOT(onHashReady(QString,QString)));
+}
+
+ProxyManager& ProxyManager::singleton()
+{
+    static ProxyManager* instance = new ProxyManager;
+    return *instance;
+}
+
+void ProxyManager::setEnabled(bool enabled)
+{
+    m_enabled.store(enabled);
+    Settings.setPlayerProxy(enabled);
+}
+
+QString ProxyManager::proxyDirectory()
+{
+    QDir dir(Settings.appDataLocation());
+    if (!dir.cd("proxies")) {
+        if (dir.mkdir("proxies"))
+            dir.cd("proxies");
+    }
+    return dir.path();
+}
+
+QString ProxyManager::proxyFor(const QString& hash) const
+{
+    if (hash.isEmpty())
+        return QString();
+    QString path = DB.getProxy(hash);
+    if (!path.isEmpty() && !QFile::exists(path)) {
+        LOG_INFO() << "proxy is gone" << path;
+        DB.removeProxy(hash);
+        path.clear();
+    }
+    return path;
+}
+
+QString ProxyManager::resourceFor(const QString& url, QString* hash) const
+{
+    if (!isEnabled() || url.endsWith(".mlt") || url.endsWith(".xml") || !QFileInfo(url).isFile())
+        return url;
+    QString result = FileHashService::singleton().knownHash(url);
+    if (hash)
+        *hash = result;
+    QString proxy = proxyFor(result);
+    return proxy.isEmpty()? url : proxy;
+}
+
+void ProxyManager::setOriginal(Mlt::Properties& producer, const QString& original, const QString& hash)
+{
+    producer.set(kOriginalResourceProperty, original.toUtf8().constData());
+    if (!hash.isEmpty())
+        producer.set(kShotcutHashProperty, hash.toLatin1().constData());
+    // Show the name of the original rather than that of the proxy.
+    if (!producer.get(kShotcutCaptionProperty))
+        producer.set(kShotcutCaptionProperty, QFileInfo(original).fileName().toUtf8().constData());
+}
+
+void ProxyManager::generate(Mlt::Producer& producer)
+{
+    if (!isEnabled() || !producer.is_valid() || producer.get(kOriginalResourceProperty))
+        return;
+    if (!QString(producer.get("mlt_service")).startsWith("avformat"))
+        return;
+    const int height = Settings.playerProxyHeight();
+    if (producer.get_int("meta.media.height") <= height)
+        return;
+    QString resource = QString::fromUtf8(producer.get("resource"));
+    QString hash = producer.get(kShotcutHashProperty);
+    if (hash.isEmpty())
+        hash = FileHashService::singleton().request(resource, producer);
+    if (hash.isEmpty())
+        m_waitingForHash << resource;
+    else
+        queueJob(resource, hash);
+}
+
+void ProxyManager::queueJob(const QString& resource, const QString& hash)
+{
+    if (m_pending.contains(hash) || !proxyFor(hash).isEmpty())
+        return;
+    QString target = QDir(proxyDirectory()).filePath(hash + ".mov");
+    ProxyJob* job = new ProxyJob(resource, target, hash, Settings.playerProxyHeight());
+    connect(job, SIGNAL(finished(AbstractJob*,bool)), SLOT(onJobFinished(AbstractJob*,bool)));
+    m_pending << hash;
+    JOBS.add(job);
+}
+
+void ProxyManager::onHashReady(const QString& path, const QString& hash)
+{
+    if (m_waitingForHash.remove(path) && isEnabled())
+        queueJob(path, hash);
+}
+
+void ProxyManager::onJobFinished(AbstractJob* job, bool isSuccess)
+{
+    ProxyJob* proxyJob = qobject_cast<ProxyJob*>(job);
+    if (!proxyJob)
+        return;
+    m_pending.remove(proxyJob->hash());
+    if (isSuccess)
+        DB.putProxy(proxyJob->hash(), proxyJob->target());
+}
+
+bool ProxyManager::substitute(const QString& fileName, QString& xml) const
+{
+    xml.clear();
+    if (!isEnabled())
+        return false;
+    QFile file(fileName);
+    QDomDocument dom;
+    if (!file.open(QIODevice::ReadOnly) || !dom.setContent(&file))
+        return false;
+    file.close();
+
+    QDomElement mlt = dom.documentElement();
+    QDir root(mlt.attribute("root", QFileInfo(fileName).absolutePath()));
+    int count = 0;
+    QDomNodeList producers = dom.elementsByTagName("producer");
+    for (int i = 0; i < producers.length(); ++i) {
+        QDomElement producer = producers.item(i).toElement();
+        if (!findProperty(producer, "mlt_service").text().startsWith("avformat")
+                || !findProperty(producer, kOriginalResourceProperty).isNull())
+            continue;
+        // Only saved hashes are used; hashing every file would slow loading.
+        QString proxy = proxyFor(findProperty(producer, kShotcutHashProperty).text());
+        QDomElement resource = findProperty(producer, "resource");
+        if (proxy.isEmpty() || resource.isNull())
+            continue;
+        QDomElement original = dom.createElement("property");
+        original.setAttribute("name", kOriginalResourceProperty);
+        original.appendChild(dom.createTextNode(root.absoluteFilePath(resource.text())));
+        producer.appendChild(original);
+        setPropertyText(resource, proxy);
+        ++count;
+    }
+    if (!count)
+        return false;
+    LOG_INFO() << "using" << count << "proxies for" << fileName;
+    // Relative paths are resolved against root, which a string does not have.
+    mlt.setAttribute("root", root.absolutePath());
+    xml = dom.toString(0);
+    return true;
+}
+
+int ProxyManager::restoreOriginals(QDomDocument& dom)
+{
+    int count = 0;
+    QDomNodeList producers = dom.elementsByTagName("producer");
+    for (int i = 0; i < producers.length(); ++i) {
+        QDomElement producer = producers.item(i).toElement();
+        QDomElement original = findProperty(producer, kOriginalResourceProperty);
+        if (original.isNull())
+            continue;
+        QDomElement resource = findProperty(producer, "resource");
+        if (!resource.isNull())
+            setPropertyText(resource, original.text());
+        producer.removeChild(original);
+        ++count;
+    }
+    return count;
+}
+
+bool ProxyManager::restoreOriginals(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    QByteArray data = file.readAll();
+    file.close();
+    if (!data.contains(kOriginalResourceProperty))
+        return true;
+
+    QDomDocument dom;
+    if (!dom.setContent(data))
+        return false;
+    restoreOriginals(dom);
+    QSaveFile out(fileName);
+    if (!out.open(QIODevice::WriteOnly))
+        return false;
+    out.write(dom.toByteArray(2));
+    return out.commit();
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROXYMANAGER_H
+#define PROXYMANAGER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QSet>
+#include <QString>
+#include <MltProducer.h>
+
+class AbstractJob;
+class QDomDocument;
+
+/*!
+  \class ProxyManager
+  \brief The ProxyManager makes and substitutes low resolution proxies of
+  media files for playback.
+
+  Proxies are transcoded in the background by a ProxyJob and recorded in
+  the database by the hash of the original file, so a proxy follows its
+  media when it is moved or renamed. They are kept in the "proxies" folder
+  of the application data location.
+
+  When proxies are enabled, clips and projects are opened with the proxy in
+  place of the original resource. Such a producer carries the original
+  resource in the shotcut:originalResource property, which survives copies
+  through MLT XML. Controller::saveXML() puts the originals back into every
+  file it writes, so projects, autosaves and exports never refer to a
+  proxy.
+
+  resourceFor() may be called from any thread.
+*/
+
+class ProxyManager : public QObject
+{
+    Q_OBJECT
+    explicit ProxyManager(QObject* parent = 0);
+
+public:
+    static ProxyManager& singleton();
+
+    bool isEnabled() const { return m_enabled.load(); }
+    void setEnabled(bool enabled);
+
+    //! Returns the proxy of the media with \a hash, or an empty string.
+    QString proxyFor(const QString& hash) const;
+
+    /*!
+      Returns the file to open for the media at \a url: its proxy when proxies
+      are enabled and one exists, otherwise \a url. Only a hash that is
+      already known is used, so the file is never read here. The hash of
+      \a url is stored in \a hash when it is known.
+    */
+    QString resourceFor(const QString& url, QString* hash = 0) const;
+
+    //! Marks \a producer, opened from a proxy, as standing in for \a original.
+    static void setOriginal(Mlt::Properties& producer, const QString& original, const QString& hash);
+
+    /*!
+      Queues a ProxyJob for \a producer if proxies are enabled and it is a
+      video file larger than the proxy size without a proxy. If its hash is
+      not known yet, the job is queued once FileHashService has it.
+    */
+    void generate(Mlt::Producer& producer);
+
+    /*!
+      Loads the project \a fileName into \a xml with the proxies substituted.
+      Returns false, leaving \a xml empty, if no proxy applies.
+    */
+    bool substitute(const QString& fileName, QString& xml) const;
+
+    //! Puts the original resources back into the MLT XML file \a fileName.
+    static bool restoreOriginals(const QString& fileName);
+
+private slots:
+    void onHashReady(const QString& path, const QString& hash);
+    void onJobFinished(AbstractJob* job, bool isSuccess);
+
+private:
+    static QString proxyDirectory();
+    void queueJob(const QString& resource, const QString& hash);
+    static int restoreOriginals(QDomDocument& dom);
+
+    QAtomicInt m_enabled;
+    QSet<QString> m_pending;
+    QSet<QString> m_waitingForHash;
+};
+
+#endif // PROXYMANAGER_H
@@ -91,9 +91,9 @@ Rectangle {
         if (!waveform.visible) return
         // This is needed to make the model have the correct count.
         // Model as a property expression is not working in all cases.
+        // The waveform tiles repaint themselves only when their levels, zoom
+        // or trim actually change.
         waveformRepeater.model = Math.ceil(waveform.innerWidth / waveform.maxWidth)
-        for (var i = 0; i < waveformRepeater.count; i++)
-            waveformRepeater.itemAt(0).update()
     }
 
     function imagePath(time) {
@@ -149,13 +149,13 @@ Rectangle {
         anchors.bottom: parent.bottom
         anchors.margins: parent.border.width
         opacity: 0.7
-        property int maxWidth: 10000
+        property int maxWidth: 2048
         property int innerWidth: clipRoot.width - clipRoot.border.width * 2
 
         Repeater {
             id: waveformRepeater
             TimelineWaveform {
-                width: Math.min(waveform.innerWidth, waveform.maxWidth)
+                width: Math.min(waveform.innerWidth - index * waveform.maxWidth, waveform.maxWidth)
                 height: waveform.height
                 fillColor: getColor()
                 property int channels: 2
@@ -61,6 +61,12 @@ Rectangle {
         multitrack.trackHeight = Math.max(30, multitrack.trackHeight - 20)
     }
 
+    function updateVisibleRange() {
+        var x = scrollView.flickableItem.contentX
+        timeline.setVisibleRange(x / multitrack.scaleFactor,
+                                 (x + scrollView.width) / multitrack.scaleFactor)
+    }
+
     function pulseLockButtonOnTrack(index) {
         trackHeaderRepeater.itemAt(index).pulseLockButton()
     }
@@ -565,7 +571,16 @@ Rectangle {
     Connections {
         target: multitrack
         onLoaded: toolbar.scaleSlider.value = Math.pow(multitrack.scaleFactor - 0.01, 1.0 / 3.0)
-        onScaleFactorChanged: Logic.scrollIfNeeded()
+        onScaleFactorChanged: {
+            Logic.scrollIfNeeded()
+            updateVisibleRange()
+        }
+    }
+
+    Connections {
+        target: scrollView.flickableItem
+        onContentXChanged: updateVisibleRange()
+        onWidthChanged: updateVisibleRange()
     }
 
     // This provides continuous scrolling at the left/right edges.
@@ -226,6 +226,9 @@ void QmlFilter::analyze(bool isAudio)
         connect(job, &AbstractJob::finished, this, &QmlFilter::analyzeFinished);
         QFileInfo info(QString::fromUtf8(service.get("resource")));
         job->setLabel(tr("Analyze %1").arg(info.fileName()));
+        // The user is waiting for the result.
+        job->setPriority(AbstractJob::HighPriority);
+        job->setThreads(1);
         JOBS.add(job);
     }
 }
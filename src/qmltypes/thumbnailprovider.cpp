@@ -22,12 +22,15 @@
 #include "mltcontroller.h"
 #include "models/playlistmodel.h"
 #include "database.h"
+#include "thumbnailproducerpool.h"
 
 #include <Logger.h>
 
+static const char* kProfileName = "atsc_720p_60";
+
 ThumbnailProvider::ThumbnailProvider()
     : QQuickImageProvider(QQmlImageProviderBase::Image, QQmlImageProviderBase::ForceAsynchronousImageLoading)
-    , m_profile("atsc_720p_60")
+    , m_profile(kProfileName)
 {
 }
 
@@ -54,15 +57,13 @@ QImage ThumbnailProvider::requestImage(const QString &id, QSize *size, const QSi
         QString key = cacheKey(properties, service, resource, hash, frameNumber);
         result = DB.getThumbnail(key);
         if (result.isNull()) {
-            if (service == "avformat-novalidate")
-                service = "avformat";
-            else if (service.startsWith("xml"))
-                service = "xml-nogl";
-            Mlt::Producer producer(m_profile, service.toUtf8().constData(), resource.toUtf8().constData());
-            if (producer.is_valid()) {
-                result = makeThumbnail(producer, frameNumber, requestedSize);
+            Mlt::Producer* producer = ThumbnailProducerPool::singleton()
+                .acquire(kProfileName, service, resource, frameNumber);
+            if (producer->is_valid()) {
+                result = makeThumbnail(*producer, frameNumber, requestedSize);
                 DB.putThumbnail(key, result);
             }
+            ThumbnailProducerPool::singleton().release(producer);
         }
         if (size)
             *size = result.size();
@@ -94,9 +95,6 @@ QString ThumbnailProvider::cacheKey(Mlt::Properties& properties, const QString&
 
 QImage ThumbnailProvider::makeThumbnail(Mlt::Producer &producer, int frameNumber, const QSize& requestedSize)
 {
-    Mlt::Filter scaler(m_profile, "swscale");
-    Mlt::Filter padder(m_profile, "resize");
-    Mlt::Filter converter(m_profile, "avcolor_space");
     int height = PlaylistModel::THUMBNAIL_HEIGHT * 2;
     int width = PlaylistModel::THUMBNAIL_WIDTH * 2;
 
@@ -104,9 +102,5 @@ QImage ThumbnailProvider::makeThumbnail(Mlt::Producer &producer, int frameNumber
         width = requestedSize.width();
         height = requestedSize.height();
     }
-
-    producer.attach(scaler);
-    producer.attach(padder);
-    producer.attach(converter);
     return MLT.image(producer, frameNumber, width, height);
 }
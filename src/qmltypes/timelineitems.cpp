@@ -17,12 +17,15 @@
 
 #include "timelineitems.h"
 #include "mltcontroller.h"
+#include "models/audiopeaks.h"
+#include "widgets/iecscale.h"
 
 #include <QQuickPaintedItem>
 #include <QPainter>
 #include <QPalette>
 #include <QPainterPath>
 #include <QLinearGradient>
+#include <cmath>
 
 class TimelineTransition : public QQuickPaintedItem
 {
@@ -92,41 +95,92 @@ public:
 class TimelineWaveform : public QQuickPaintedItem
 {
     Q_OBJECT
-    Q_PROPERTY(QVariant levels MEMBER m_audioLevels NOTIFY propertyChanged)
-    Q_PROPERTY(QColor fillColor MEMBER m_color NOTIFY propertyChanged)
-    Q_PROPERTY(int inPoint MEMBER m_inPoint NOTIFY inPointChanged)
-    Q_PROPERTY(int outPoint MEMBER m_outPoint NOTIFY outPointChanged)
+    Q_PROPERTY(QVariant levels READ levels WRITE setLevels NOTIFY propertyChanged)
+    Q_PROPERTY(QColor fillColor READ fillColor WRITE setFillColor NOTIFY propertyChanged)
+    Q_PROPERTY(int inPoint READ inPoint WRITE setInPoint NOTIFY inPointChanged)
+    Q_PROPERTY(int outPoint READ outPoint WRITE setOutPoint NOTIFY outPointChanged)
 
 public:
     TimelineWaveform()
+        : m_inPoint(0)
+        , m_outPoint(0)
     {
         setAntialiasing(QPainter::Antialiasing);
-        connect(this, SIGNAL(propertyChanged()), this, SLOT(update()));
+    }
+
+    QVariant levels() const { return QVariant::fromValue(m_peaks); }
+    QColor fillColor() const { return m_color; }
+    int inPoint() const { return m_inPoint; }
+    int outPoint() const { return m_outPoint; }
+
+    // The rendered texture is only invalidated when something that affects
+    // it changes, i.e. new peaks, the zoom (width) or a trim (in/out).
+    void setLevels(const QVariant& levels)
+    {
+        AudioPeaksPtr peaks = levels.value<AudioPeaksPtr>();
+        if (peaks != m_peaks) {
+            m_peaks = peaks;
+            emit propertyChanged();
+            update();
+        }
+    }
+
+    void setFillColor(const QColor& color)
+    {
+        if (color != m_color) {
+            m_color = color;
+            emit propertyChanged();
+            update();
+        }
+    }
+
+    void setInPoint(int inPoint)
+    {
+        if (inPoint != m_inPoint) {
+            m_inPoint = inPoint;
+            emit inPointChanged();
+            update();
+        }
+    }
+
+    void setOutPoint(int outPoint)
+    {
+        if (outPoint != m_outPoint) {
+            m_outPoint = outPoint;
+            emit outPointChanged();
+            update();
+        }
     }
 
     void paint(QPainter *painter)
     {
-        QVariantList data = m_audioLevels.toList();
-        if (data.isEmpty())
+        if (!m_peaks || !m_peaks->binCount(0) || width() < 1)
             return;
 
-        // In and out points are # frames at current fps,
-        // but audio levels are created at 25 fps.
-        // Scale in and out point to 25 fps.
-        const int inPoint = qRound(m_inPoint / MLT.profile().fps() * 25.0);
-        const int outPoint = qRound(m_outPoint / MLT.profile().fps() * 25.0);
+        // In and out points are # frames at current fps interleaved with
+        // 2 channels, but audio peaks are stored per fixed time bins.
+        const qreal binsPerPoint = m_peaks->binsPerSecond() / MLT.profile().fps() / 2.0;
+        const qreal inPoint = m_inPoint * binsPerPoint;
+        const qreal outPoint = m_outPoint * binsPerPoint;
         const qreal indicesPrPixel = qreal(outPoint - inPoint) / width();
+        // Pick the level of detail that has about one bin per pixel.
+        const int level = m_peaks->levelFor(indicesPrPixel);
+        const int count = m_peaks->binCount(0);
 
         QPainterPath path;
         path.moveTo(-1, height());
         int i = 0;
         for (; i < width(); ++i)
         {
-            int idx = inPoint + int(i * indicesPrPixel);
-            if (idx + 1 >= data.length())
+            qreal from = inPoint + i * indicesPrPixel;
+            if (from >= count)
                 break;
-            qreal level = qMax(data.at(idx).toReal(), data.at(idx + 1).toReal()) / 256;
-            path.lineTo(i, height() - level * height());
+            int min, max;
+            m_peaks->minMax(from, from + qMax<qreal>(indicesPrPixel, 1.0), level, min, max);
+            int peak = qMax(qAbs(min), qAbs(max));
+            qreal value = peak? IEC_Scale(20 * log10(peak / 32768.0)) : 0.0;
+            // Scale by 0.9 because values may exceed 1.0 to indicate clipping.
+            path.lineTo(i, height() - value * 0.9 * height());
         }
         path.lineTo(i, height());
         painter->fillPath(path, m_color.lighter());
@@ -141,8 +195,16 @@ signals:
     void inPointChanged();
     void outPointChanged();
 
+protected:
+    void geometryChanged(const QRectF& newGeometry, const QRectF& oldGeometry)
+    {
+        QQuickPaintedItem::geometryChanged(newGeometry, oldGeometry);
+        if (newGeometry.size() != oldGeometry.size())
+            update();
+    }
+
 private:
-    QVariant m_audioLevels;
+    AudioPeaksPtr m_peaks;
     int m_inPoint;
     int m_outPoint;
     QColor m_color;
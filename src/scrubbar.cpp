@@ -77,6 +77,7 @@ void ScrubBar::setScale(int maximum)
 void ScrubBar::setFramerate(double fps)
 {
     m_fps = fps;
+    m_timecodes.clear();
 }
 
 int ScrubBar::position() const
@@ -86,22 +87,49 @@ int ScrubBar::position() const
 
 void ScrubBar::setInPoint(int in)
 {
+    const int oldIn = m_in;
     m_in = qMax(in, -1);
-    updatePixmap();
+    updateSelection(oldIn, m_out);
     emit inChanged(in);
 }
 
 void ScrubBar::setOutPoint(int out)
 {
+    const int oldOut = m_out;
     m_out = qMin(out, m_max);
-    updatePixmap();
+    updateSelection(m_in, oldOut);
     emit outChanged(out);
 }
 
 void ScrubBar::setMarkers(const QList<int> &list)
 {
     m_markers = list;
-    updatePixmap();
+    update();
+}
+
+void ScrubBar::updateSelection(int oldIn, int oldOut)
+{
+    const bool hadSelection = oldIn > -1 && oldOut > oldIn;
+    const bool hasSelection = m_in > -1 && m_out > m_in;
+    const bool hadMarkers = oldIn < 0 && oldOut < 0;
+    const bool hasMarkers = m_in < 0 && m_out < 0;
+    if (hadSelection != hasSelection || hadMarkers != hasMarkers) {
+        update();
+    } else {
+        if (oldIn != m_in)
+            updateStrip(oldIn, m_in);
+        if (oldOut != m_out)
+            updateStrip(oldOut, m_out);
+    }
+}
+
+// Repaints the part of the bar between two frames including the in and out
+// point handles that may sit on either of them.
+void ScrubBar::updateStrip(int from, int to)
+{
+    const int x = margin + qMin(from, to) * m_scale;
+    const int w = qAbs(to - from) * m_scale;
+    update(x - selectionSize, 0, w + 2 * selectionSize + 1, height());
 }
 
 void ScrubBar::mousePressEvent(QMouseEvent * event)
@@ -186,6 +214,41 @@ void ScrubBar::paintEvent(QPaintEvent *e)
 
     if (!isEnabled()) return;
 
+    // The overlays use device pixels like the ruler.
+    const int ratio = devicePixelRatio();
+    const int l_height = height() * ratio;
+    const int l_margin = margin * ratio;
+    const int l_selectionSize = selectionSize * ratio;
+    p.save();
+    p.scale(1.0 / ratio, 1.0 / ratio);
+
+    // selected region
+    if (m_in > -1 && m_out > m_in) {
+        const int in = m_in * m_scale * ratio;
+        const int out = m_out * m_scale * ratio;
+        p.fillRect(l_margin + in, 0, out - in, l_selectionSize, Qt::red);
+        p.fillRect(l_margin + in + (2 + ratio), ratio, // 2 for the in point line
+                   out - in - 2 * (2 + ratio) - qFloor(0.5 * ratio),
+                   l_selectionSize - ratio * 2,
+                   palette().highlight().color());
+    }
+
+    // draw markers
+    if (m_in < 0 && m_out < 0) {
+        const int markerHeight = fontMetrics().ascent() + 2 * ratio;
+        int i = 1;
+        p.setPen(palette().text().color());
+        foreach (int pos, m_markers) {
+            int x = l_margin + pos * m_scale * ratio;
+            QString s = QString::number(i++);
+            int markerWidth = fontMetrics().width(s) * 1.5;
+            p.fillRect(x, 0, 1, l_height, palette().highlight().color());
+            p.fillRect(x - markerWidth/2, 0, markerWidth, markerHeight, palette().highlight().color());
+            p.drawText(x - markerWidth/3, markerHeight - 2 * ratio, s);
+        }
+    }
+    p.restore();
+
     // draw pointer
     QPolygon pa(3);
     const int x = selectionSize / 2 - 1;
@@ -231,7 +294,8 @@ void ScrubBar::resizeEvent(QResizeEvent *)
 bool ScrubBar::event(QEvent *event)
 {
     QWidget::event(event);
-    if (event->type() == QEvent::PaletteChange || event->type() == QEvent::StyleChange)
+    if (event->type() == QEvent::PaletteChange || event->type() == QEvent::StyleChange
+            || event->type() == QEvent::EnabledChange)
         updatePixmap();
     return false;
 }
@@ -249,7 +313,6 @@ void ScrubBar::updatePixmap()
     m_pixmap.fill(palette().window().color());
     QPainter p(&m_pixmap);
     p.setFont(font());
-    const int markerHeight = fontMetrics().ascent() + 2 * ratio;
     QPen pen;
 
     if (!isEnabled()) {
@@ -262,17 +325,6 @@ void ScrubBar::updatePixmap()
     // background color
     p.fillRect(l_margin, 0, l_width - 2 * l_margin, l_height, palette().base().color());
 
-    // selected region
-    if (m_in > -1 && m_out > m_in) {
-        const int in = m_in * m_scale * ratio;
-        const int out = m_out * m_scale * ratio;
-        p.fillRect(l_margin + in, 0, out - in, l_selectionSize, Qt::red);
-        p.fillRect(l_margin + in + (2 + ratio), ratio, // 2 for the in point line
-                   out - in - 2 * (2 + ratio) - qFloor(0.5 * ratio),
-                   l_selectionSize - ratio * 2,
-                   palette().highlight().color());
-    }
-
     // draw time ticks
     pen.setColor(palette().text().color());
     pen.setWidth(ratio);
@@ -291,24 +343,22 @@ void ScrubBar::updatePixmap()
 
     // draw timecode
     if (l_interval > l_timecodeWidth && MLT.producer()) {
+        // The labels are laid out once and reused for every width and scale
+        // that has a tick on the same frame.
+        const int top = l_selectionSize - 2 * ratio;
+        if (m_timecodes.size() > 1000)
+            m_timecodes.clear();
         int x = l_margin;
         for (int i = 0; x < l_width - l_margin - l_timecodeWidth; i++, x += l_interval) {
-            int y = l_selectionSize + fontMetrics().ascent() - 2 * ratio;
             int frames = qRound(i * m_fps * m_secondsPerTick);
-            p.drawText(x + 2 * ratio, y, MLT.producer()->frames_to_time(frames));
-        }
-    }
-
-    // draw markers
-    if (m_in < 0 && m_out < 0) {
-        int i = 1;
-        foreach (int pos, m_markers) {
-            int x = l_margin + pos * m_scale * ratio;
-            QString s = QString::number(i++);
-            int markerWidth = fontMetrics().width(s) * 1.5;
-            p.fillRect(x, 0, 1, l_height, palette().highlight().color());
-            p.fillRect(x - markerWidth/2, 0, markerWidth, markerHeight, palette().highlight().color());
-            p.drawText(x - markerWidth/3, markerHeight - 2 * ratio, s);
+            QHash<int, QStaticText>::iterator label = m_timecodes.find(frames);
+            if (label == m_timecodes.end()) {
+                QStaticText text(MLT.producer()->frames_to_time(frames));
+                text.setTextFormat(Qt::PlainText);
+                text.prepare(QTransform(), font());
+                label = m_timecodes.insert(frames, text);
+            }
+            p.drawStaticText(x + 2 * ratio, top, label.value());
         }
     }
 
@@ -20,6 +20,18 @@
 #define SCRUBBAR_H
 
 #include <QWidget>
+#include <QHash>
+#include <QStaticText>
+
+/*!
+  \class ScrubBar
+  \brief The ScrubBar is the time ruler with in and out points below the player.
+
+  The ticks and timecode labels only change with the size, scale and
+  palette, so they are rendered once into a pixmap. The selection, the in and
+  out points, the markers and the playhead are painted over it on each paint
+  event, and changing them only repaints the strip of the bar they affect.
+*/
 
 class ScrubBar : public QWidget
 {
@@ -71,12 +83,15 @@ private:
     int m_in;
     int m_out;
     enum controls m_activeControl;
-    QPixmap m_pixmap;
+    QPixmap m_pixmap;   // ruler: background, ticks and timecode labels
     int m_timecodeWidth;
     int m_secondsPerTick;
     QList<int> m_markers;
+    QHash<int, QStaticText> m_timecodes; // laid out labels by frame number
 
     void updatePixmap();
+    void updateSelection(int oldIn, int oldOut);
+    void updateStrip(int from, int to);
 };
 
 #endif // SCRUBBAR_H
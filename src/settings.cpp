@@ -204,6 +204,17 @@ void ShotcutSettings::setEncodeFreeSpaceCheck(bool b)
     settings.setValue("encode/freeSpaceCheck", b);
 }
 
+int ShotcutSettings::jobsMaxConcurrent() const
+{
+    // 0 lets the number of cores decide.
+    return settings.value("jobs/maxConcurrent", 0).toInt();
+}
+
+void ShotcutSettings::setJobsMaxConcurrent(int n)
+{
+    settings.setValue("jobs/maxConcurrent", n);
+}
+
 bool ShotcutSettings::showConvertClipDialog() const
 {
     return settings.value("showConvertClipDialog", true).toBool();
@@ -366,6 +377,21 @@ void ShotcutSettings::setPlayerScrubAudio(bool b)
     settings.setValue("player/scrubAudio", b);
 }
 
+bool ShotcutSettings::playerProxy() const
+{
+    return settings.value("player/proxy", false).toBool();
+}
+
+void ShotcutSettings::setPlayerProxy(bool b)
+{
+    settings.setValue("player/proxy", b);
+}
+
+int ShotcutSettings::playerProxyHeight() const
+{
+    return settings.value("player/proxyHeight", 540).toInt();
+}
+
 int ShotcutSettings::playerVolume() const
 {
     return settings.value("player/volume", 88).toInt();
@@ -78,6 +78,8 @@ public:
     void setEncodePath(const QString&);
     bool encodeFreeSpaceCheck() const;
     void setEncodeFreeSpaceCheck(bool);
+    int jobsMaxConcurrent() const;
+    void setJobsMaxConcurrent(int);
     bool showConvertClipDialog() const;
     void setShowConvertClipDialog(bool);
 
@@ -112,6 +114,9 @@ public:
     void setPlayerRealtime(bool);
     bool playerScrubAudio() const;
     void setPlayerScrubAudio(bool);
+    bool playerProxy() const;
+    void setPlayerProxy(bool);
+    int playerProxyHeight() const;
     int playerVolume() const;
     void setPlayerVolume(int);
     float playerZoom() const;
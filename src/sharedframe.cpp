@@ -29,6 +29,79 @@ private:
     Q_DISABLE_COPY(FrameData)
 };
 
+SharedFramePlane::SharedFramePlane()
+  : d()
+  , m_format(mlt_image_none)
+  , m_data(0)
+  , m_width(0)
+  , m_height(0)
+  , m_stride(0)
+  , m_step(0)
+{
+}
+
+SharedFramePlane::SharedFramePlane(const SharedFramePlane& other)
+  : d(other.d)
+  , m_format(other.m_format)
+  , m_data(other.m_data)
+  , m_width(other.m_width)
+  , m_height(other.m_height)
+  , m_stride(other.m_stride)
+  , m_step(other.m_step)
+{
+}
+
+SharedFramePlane::~SharedFramePlane()
+{
+}
+
+SharedFramePlane& SharedFramePlane::operator=(const SharedFramePlane& other)
+{
+    d = other.d;
+    m_format = other.m_format;
+    m_data = other.m_data;
+    m_width = other.m_width;
+    m_height = other.m_height;
+    m_stride = other.m_stride;
+    m_step = other.m_step;
+    return *this;
+}
+
+SharedFrameAudio::SharedFrameAudio()
+  : d()
+  , m_format(mlt_audio_none)
+  , m_data(0)
+  , m_channels(0)
+  , m_frequency(0)
+  , m_samples(0)
+{
+}
+
+SharedFrameAudio::SharedFrameAudio(const SharedFrameAudio& other)
+  : d(other.d)
+  , m_format(other.m_format)
+  , m_data(other.m_data)
+  , m_channels(other.m_channels)
+  , m_frequency(other.m_frequency)
+  , m_samples(other.m_samples)
+{
+}
+
+SharedFrameAudio::~SharedFrameAudio()
+{
+}
+
+SharedFrameAudio& SharedFrameAudio::operator=(const SharedFrameAudio& other)
+{
+    d = other.d;
+    m_format = other.m_format;
+    m_data = other.m_data;
+    m_channels = other.m_channels;
+    m_frequency = other.m_frequency;
+    m_samples = other.m_samples;
+    return *this;
+}
+
 SharedFrame::SharedFrame()
   : d(new FrameData)
 {
@@ -54,6 +127,11 @@ SharedFrame& SharedFrame::operator=(const SharedFrame& other)
    return *this;
 }
 
+bool SharedFrame::operator==(const SharedFrame& other) const
+{
+    return d == other.d;
+}
+
 bool SharedFrame::is_valid() const
 {
     return d->f.is_valid();
@@ -174,6 +252,89 @@ const uint8_t* SharedFrame::get_image() const
     return (uint8_t*)d->f.get_image(format, width, height, 0);
 }
 
+SharedFramePlane SharedFrame::get_plane(SharedFramePlane::Plane plane) const
+{
+    SharedFramePlane view;
+    int width = get_image_width();
+    int height = get_image_height();
+    const uint8_t* image = get_image();
+    if (!image || width <= 0 || height <= 0)
+        return view;
+
+    mlt_image_format format = get_image_format();
+    const uint8_t* data = 0;
+    int stride = width;
+    int step = 1;
+
+    if (plane == SharedFramePlane::PlanePacked) {
+        int bpp = 1;
+        mlt_image_format_size(format, width, 1, &bpp);
+        data = image;
+        step = qMax(1, bpp);
+        stride = width * step;
+    } else if (plane == SharedFramePlane::PlaneA) {
+        int size = 0;
+        data = (const uint8_t*) d->f.get_data("alpha", size);
+        if (!data && format == mlt_image_rgb24a) {
+            data = image + 3;
+            stride = width * 4;
+            step = 4;
+        }
+    } else if (format == mlt_image_yuv420p) {
+        switch (plane) {
+        case SharedFramePlane::PlaneY:
+            data = image;
+            break;
+        case SharedFramePlane::PlaneU:
+            data = image + width * height;
+            width /= 2;
+            height /= 2;
+            stride = width;
+            break;
+        case SharedFramePlane::PlaneV:
+            data = image + width * height + (width / 2) * (height / 2);
+            width /= 2;
+            height /= 2;
+            stride = width;
+            break;
+        default:
+            break;
+        }
+    } else if (format == mlt_image_yuv422) {
+        // Packed Y0 U Y1 V
+        stride = width * 2;
+        switch (plane) {
+        case SharedFramePlane::PlaneY:
+            data = image;
+            step = 2;
+            break;
+        case SharedFramePlane::PlaneU:
+            data = image + 1;
+            width /= 2;
+            step = 4;
+            break;
+        case SharedFramePlane::PlaneV:
+            data = image + 3;
+            width /= 2;
+            step = 4;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (data) {
+        view.d = d;
+        view.m_format = format;
+        view.m_data = data;
+        view.m_width = width;
+        view.m_height = height;
+        view.m_stride = stride;
+        view.m_step = step;
+    }
+    return view;
+}
+
 mlt_audio_format SharedFrame::get_audio_format() const
 {
     return (mlt_audio_format)d->f.get_int( "audio_format" );
@@ -202,3 +363,18 @@ const int16_t* SharedFrame::get_audio() const
     int samples = get_audio_samples();
     return (int16_t*)d->f.get_audio(format, frequency, channels, samples);
 }
+
+SharedFrameAudio SharedFrame::get_audio_view() const
+{
+    SharedFrameAudio view;
+    const int16_t* audio = get_audio();
+    if (audio && get_audio_format() == mlt_audio_s16) {
+        view.d = d;
+        view.m_format = mlt_audio_s16;
+        view.m_data = audio;
+        view.m_channels = get_audio_channels();
+        view.m_frequency = get_audio_frequency();
+        view.m_samples = get_audio_samples();
+    }
+    return view;
+}
@@ -25,6 +25,96 @@
 #include <stdint.h>
 
 class FrameData;
+class SharedFrame;
+
+/*!
+  \class SharedFramePlane
+  \brief The SharedFramePlane provides a read-only view of one image plane of a
+  SharedFrame.
+
+  \threadsafe
+
+  A plane view holds a reference to the frame it was taken from. Therefore, the
+  pointer returned by data() remains valid for as long as the view exists, even
+  if every SharedFrame referring to the same frame has been destroyed.
+
+  For packed formats (e.g. yuv422) the samples of a plane are interleaved with
+  other components; step() gives the distance in bytes between two horizontally
+  adjacent samples and stride() the distance between two lines.
+*/
+
+class SharedFramePlane
+{
+public:
+    enum Plane {
+        PlaneY = 0,  //!< Luma (yuv formats only)
+        PlaneU,      //!< Cb (yuv formats only)
+        PlaneV,      //!< Cr (yuv formats only)
+        PlaneA,      //!< Alpha
+        PlanePacked  //!< The whole image as stored by MLT
+    };
+
+    SharedFramePlane();
+    SharedFramePlane(const SharedFramePlane& other);
+    ~SharedFramePlane();
+    SharedFramePlane& operator=(const SharedFramePlane& other);
+
+    bool is_valid() const { return m_data != 0; }
+    mlt_image_format format() const { return m_format; }
+    const uint8_t* data() const { return m_data; }
+    const uint8_t* line(int y) const { return m_data + y * m_stride; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int stride() const { return m_stride; }
+    int step() const { return m_step; }
+
+private:
+    friend class SharedFrame;
+    QExplicitlySharedDataPointer<FrameData> d;
+    mlt_image_format m_format;
+    const uint8_t* m_data;
+    int m_width;
+    int m_height;
+    int m_stride;
+    int m_step;
+};
+
+/*!
+  \class SharedFrameAudio
+  \brief The SharedFrameAudio provides a read-only view of the interleaved
+  audio of a SharedFrame.
+
+  \threadsafe
+
+  Like SharedFramePlane, the view keeps the frame alive so that data() can be
+  used without copying the samples.
+*/
+
+class SharedFrameAudio
+{
+public:
+    SharedFrameAudio();
+    SharedFrameAudio(const SharedFrameAudio& other);
+    ~SharedFrameAudio();
+    SharedFrameAudio& operator=(const SharedFrameAudio& other);
+
+    bool is_valid() const { return m_data != 0 && m_samples > 0; }
+    mlt_audio_format format() const { return m_format; }
+    const int16_t* data() const { return m_data; }
+    const int16_t* sample(int i) const { return m_data + i * m_channels; }
+    int channels() const { return m_channels; }
+    int frequency() const { return m_frequency; }
+    int samples() const { return m_samples; }
+
+private:
+    friend class SharedFrame;
+    QExplicitlySharedDataPointer<FrameData> d;
+    mlt_audio_format m_format;
+    const int16_t* m_data;
+    int m_channels;
+    int m_frequency;
+    int m_samples;
+};
 
 /*!
   \class SharedFrame
@@ -53,22 +143,26 @@ public:
     SharedFrame(const SharedFrame& other);
     ~SharedFrame();
     SharedFrame& operator=(const SharedFrame& other);
+    //! Returns true if both refer to the same wrapped Mlt::Frame.
+    bool operator==(const SharedFrame& other) const;
 
     bool is_valid() const;
     Mlt::Frame clone(bool audio = false, bool image = false, bool alpha = false) const;
     int get_int(const char *name) const;
     int64_t get_int64(const char *name) const;
-	double get_double(const char *name) const;
+    double get_double(const char *name) const;
     int get_position() const;
     mlt_image_format get_image_format() const;
     int get_image_width() const;
     int get_image_height() const;
     const uint8_t* get_image() const;
+    SharedFramePlane get_plane(SharedFramePlane::Plane plane) const;
     mlt_audio_format get_audio_format() const;
     int get_audio_channels() const;
     int get_audio_frequency() const;
     int get_audio_samples() const;
     const int16_t* get_audio() const;
+    SharedFrameAudio get_audio_view() const;
 private:
     QExplicitlySharedDataPointer<FrameData> d;
 };
@@ -45,6 +45,8 @@
 #define kShotcutDetailProperty "shotcut:detail"
 #define kShotcutHashProperty "shotcut:hash"
 #define kShotcutSkipConvertProperty "shotcut:skipConvert"
+/* Only while a proxy stands in for a file; never written to a saved file. */
+#define kOriginalResourceProperty "shotcut:originalResource"
 
 /* Project specific properties */
 #define kShotcutProjectAudioChannels "shotcut:projectAudioChannels"
@@ -53,7 +53,7 @@ SOURCES += main.cpp\
     mvcp/mvcp_socket.cpp \
     mvcp/meltedclipsmodel.cpp \
     mvcp/meltedunitsmodel.cpp \
-    mvcp/mvcpthread.cpp \
+    mvcp/mvcpclient.cpp \
     mvcp/meltedplaylistmodel.cpp \
     mvcp/meltedplaylistdock.cpp \
     mvcp/meltedserverdock.cpp \
@@ -78,6 +78,11 @@ SOURCES += main.cpp\
     leapnetworklistener.cpp \
     widgets/webvfxproducer.cpp \
     database.cpp \
+    thumbnailcache.cpp \
+    thumbnailproducerpool.cpp \
+    filehashservice.cpp \
+    proxymanager.cpp \
+    playlistimporter.cpp \
     widgets/gltestwidget.cpp \
     models/multitrackmodel.cpp \
     docks/timelinedock.cpp \
@@ -97,17 +102,24 @@ SOURCES += main.cpp\
     docks/scopedock.cpp \
     controllers/scopecontroller.cpp \
     widgets/scopes/scopewidget.cpp \
+    widgets/scopes/scopescheduler.cpp \
+    widgets/scopes/audioanalyzer.cpp \
     widgets/scopes/audioloudnessscopewidget.cpp \
     widgets/scopes/audiopeakmeterscopewidget.cpp \
     widgets/scopes/audiospectrumscopewidget.cpp \
     widgets/scopes/audiowaveformscopewidget.cpp \
     widgets/scopes/videowaveformscopewidget.cpp \
+    widgets/scopes/videohistogramscopewidget.cpp \
+    widgets/scopes/videorgbparadescopewidget.cpp \
+    widgets/scopes/videoscopekernel.cpp \
     sharedframe.cpp \
     widgets/audioscale.cpp \
+    widgets/jobprogressgraph.cpp \
     widgets/playlisttable.cpp \
     widgets/playlisticonview.cpp \
     commands/undohelper.cpp \
     models/audiolevelstask.cpp \
+    models/audiopeaks.cpp \
     mltxmlchecker.cpp \
     widgets/avfoundationproducerwidget.cpp \
     widgets/gdigrabwidget.cpp \
@@ -115,6 +127,8 @@ SOURCES += main.cpp\
     widgets/timelinepropertieswidget.cpp \
     jobs/ffprobejob.cpp \
     jobs/ffmpegjob.cpp \
+    jobs/concatjob.cpp \
+    jobs/proxyjob.cpp \
     dialogs/unlinkedfilesdialog.cpp \
     CallDLL/callunifyloginsrv.cpp \
     MyWidgets/loginwidget.cpp \
@@ -167,7 +181,7 @@ HEADERS  += mainwindow.h \
     mvcp/qconsole.h \
     mvcp/meltedclipsmodel.h \
     mvcp/meltedunitsmodel.h \
-    mvcp/mvcpthread.h \
+    mvcp/mvcpclient.h \
     mvcp/meltedplaylistmodel.h \
     mvcp/meltedplaylistdock.h \
     mvcp/meltedserverdock.h \
@@ -193,6 +207,11 @@ HEADERS  += mainwindow.h \
     leapnetworklistener.h \
     widgets/webvfxproducer.h \
     database.h \
+    thumbnailcache.h \
+    thumbnailproducerpool.h \
+    filehashservice.h \
+    proxymanager.h \
+    playlistimporter.h \
     widgets/gltestwidget.h \
     models/multitrackmodel.h \
     docks/timelinedock.h \
@@ -212,18 +231,26 @@ HEADERS  += mainwindow.h \
     docks/scopedock.h \
     controllers/scopecontroller.h \
     widgets/scopes/scopewidget.h \
+    widgets/scopes/scopescheduler.h \
+    widgets/scopes/audioanalyzer.h \
     widgets/scopes/audioloudnessscopewidget.h \
     widgets/scopes/audiopeakmeterscopewidget.h \
     widgets/scopes/audiospectrumscopewidget.h \
     widgets/scopes/audiowaveformscopewidget.h \
     widgets/scopes/videowaveformscopewidget.h \
+    widgets/scopes/videohistogramscopewidget.h \
+    widgets/scopes/videorgbparadescopewidget.h \
+    widgets/scopes/videoscopekernel.h \
     dataqueue.h \
+    dataringbuffer.h \
     sharedframe.h \
     widgets/audioscale.h \
+    widgets/jobprogressgraph.h \
     widgets/playlisttable.h \
     widgets/playlisticonview.h \
     commands/undohelper.h \
     models/audiolevelstask.h \
+    models/audiopeaks.h \
     shotcut_mlt_properties.h \
     mltxmlchecker.h \
     widgets/avfoundationproducerwidget.h \
@@ -232,6 +259,8 @@ HEADERS  += mainwindow.h \
     widgets/timelinepropertieswidget.h \
     jobs/ffprobejob.h \
     jobs/ffmpegjob.h \
+    jobs/concatjob.h \
+    jobs/proxyjob.h \
     dialogs/unlinkedfilesdialog.h \
     CallDLL/callunifyloginsrv.h \
     MyWidgets/loginwidget.h \
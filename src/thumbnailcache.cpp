@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "thumbnailcache.h"
+#include <QHash>
+#include <QMutexLocker>
+
+// The budget for all shards, about a thousand 160x90 thumbnails.
+static const int kMaxBytes = 64 * 1024 * 1024;
+
+ThumbnailCache& ThumbnailCache::singleton()
+{
+    static ThumbnailCache instance(kMaxBytes);
+    return instance;
+}
+
+ThumbnailCache::ThumbnailCache(int maxBytes)
+    : m_hits(0)
+    , m_misses(0)
+{
+    for (int i = 0; i < ShardCount; i++)
+        m_shards[i].images.setMaxCost(maxBytes / ShardCount);
+}
+
+ThumbnailCache::Shard& ThumbnailCache::shard(const QString& key)
+{
+    return m_shards[qHash(key) % ShardCount];
+}
+
+QImage ThumbnailCache::image(const QString& key)
+{
+    Shard& s = shard(key);
+    QMutexLocker locker(&s.mutex);
+    // QCache::object() also makes this the most recently used entry.
+    QImage* image = s.images.object(key);
+    if (image) {
+        m_hits.ref();
+        return *image;
+    }
+    m_misses.ref();
+    return QImage();
+}
+
+void ThumbnailCache::insert(const QString& key, const QImage& image)
+{
+    if (image.isNull())
+        return;
+    Shard& s = shard(key);
+    QMutexLocker locker(&s.mutex);
+    s.images.insert(key, new QImage(image), qMax(1, image.byteCount()));
+}
+
+void ThumbnailCache::clear()
+{
+    for (int i = 0; i < ShardCount; i++) {
+        QMutexLocker locker(&m_shards[i].mutex);
+        m_shards[i].images.clear();
+    }
+}
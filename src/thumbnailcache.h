@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <QAtomicInt>
+
+/*!
+  \class ThumbnailCache
+  \brief The ThumbnailCache keeps recently used, decoded thumbnails in memory.
+
+  \threadsafe
+
+  The cache is limited by the number of bytes of image data and evicts the
+  least recently used thumbnails first. It is divided into shards, each with
+  its own lock and an equal share of the budget, so that the thumbnail
+  threads rarely wait for each other. Keys are the thumbnail cache keys that
+  are also used by the database.
+*/
+
+class ThumbnailCache
+{
+public:
+    static ThumbnailCache& singleton();
+
+    explicit ThumbnailCache(int maxBytes);
+
+    //! Returns the thumbnail for \a key or a null image if it is not cached.
+    QImage image(const QString& key);
+    void insert(const QString& key, const QImage& image);
+    void clear();
+
+    int hits() const { return m_hits.load(); }
+    int misses() const { return m_misses.load(); }
+
+private:
+    Q_DISABLE_COPY(ThumbnailCache)
+
+    enum { ShardCount = 8 };
+    struct Shard {
+        QMutex mutex;
+        QCache<QString, QImage> images;
+    };
+
+    Shard& shard(const QString& key);
+
+    Shard m_shards[ShardCount];
+    QAtomicInt m_hits;
+    QAtomicInt m_misses;
+};
+
+#endif // THUMBNAILCACHE_H
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "thumbnailproducerpool.h"
+#include <QMutexLocker>
+#include <MltFilter.h>
+
+// MLT closes the least recently used avformat producers beyond its service
+// cache size (see Controller::updateAvformatCaching), which is at least 4.
+static const int kMaxIdle = 4;
+
+ThumbnailProducerPool& ThumbnailProducerPool::singleton()
+{
+    // Not deleted at exit, which would be after MLT is closed.
+    static ThumbnailProducerPool* instance = new ThumbnailProducerPool(kMaxIdle);
+    return *instance;
+}
+
+ThumbnailProducerPool::ThumbnailProducerPool(int maxIdle)
+    : m_maxIdle(maxIdle)
+    , m_nextTicket(0)
+    , m_clock(0)
+{
+}
+
+ThumbnailProducerPool::~ThumbnailProducerPool()
+{
+    foreach (Slot* slot, m_slots) {
+        delete slot->producer;
+        delete slot;
+    }
+    qDeleteAll(m_profiles);
+}
+
+Mlt::Producer* ThumbnailProducerPool::acquire(const char* profileName, const QString& service,
+                                              const QString& resource, int frameNumber)
+{
+    QString name = service;
+    if (name == "avformat-novalidate")
+        name = "avformat";
+    else if (name.startsWith("xml"))
+        name = "xml-nogl";
+    QString key = QString("%1 %2 %3").arg(profileName).arg(name).arg(resource);
+
+    QMutexLocker locker(&m_mutex);
+    if (++m_nextTicket <= 0)
+        m_nextTicket = 1;
+    int ticket = m_nextTicket;
+    Slot* slot = m_slots.value(key);
+
+    if (!slot) {
+        // Open the file without holding the lock. Other requests for it wait
+        // in the queue of the new slot.
+        slot = new Slot;
+        slot->key = key;
+        slot->producer = 0;
+        slot->owner = ticket;
+        slot->lastUsed = 0;
+        m_slots.insert(key, slot);
+        Mlt::Profile* profile = this->profile(profileName);
+        locker.unlock();
+
+        Mlt::Producer* producer = new Mlt::Producer(*profile, name.toUtf8().constData(), resource.toUtf8().constData());
+        if (producer->is_valid()) {
+            Mlt::Filter scaler(*profile, "swscale");
+            Mlt::Filter padder(*profile, "resize");
+            Mlt::Filter converter(*profile, "avcolor_space");
+            producer->attach(scaler);
+            producer->attach(padder);
+            producer->attach(converter);
+        }
+        locker.relock();
+        slot->producer = producer;
+    } else if (slot->owner) {
+        slot->queue.insert(frameNumber, ticket);
+        while (slot->owner != ticket)
+            m_released.wait(&m_mutex);
+    } else {
+        slot->owner = ticket;
+    }
+    return slot->producer;
+}
+
+void ThumbnailProducerPool::release(Mlt::Producer* producer)
+{
+    QList<Mlt::Producer*> closed;
+    m_mutex.lock();
+    Slot* slot = 0;
+    foreach (Slot* s, m_slots) {
+        if (s->producer == producer) {
+            slot = s;
+            break;
+        }
+    }
+    if (!slot) {
+        closed << producer;
+    } else if (!slot->queue.isEmpty()) {
+        // Hand the producer to the waiter with the lowest frame number.
+        QMultiMap<int, int>::iterator next = slot->queue.begin();
+        slot->owner = next.value();
+        slot->queue.erase(next);
+        m_released.wakeAll();
+    } else {
+        slot->owner = 0;
+        slot->lastUsed = ++m_clock;
+        if (!producer->is_valid()) {
+            // Try again next time; the file may become available.
+            m_slots.remove(slot->key);
+            closed << producer;
+            delete slot;
+        }
+        evict(closed);
+    }
+    m_mutex.unlock();
+    qDeleteAll(closed);
+}
+
+Mlt::Profile* ThumbnailProducerPool::profile(const char* name)
+{
+    Mlt::Profile* profile = m_profiles.value(name);
+    if (!profile) {
+        profile = new Mlt::Profile(name);
+        m_profiles.insert(name, profile);
+    }
+    return profile;
+}
+
+void ThumbnailProducerPool::evict(QList<Mlt::Producer*>& closed)
+{
+    forever {
+        Slot* oldest = 0;
+        int idle = 0;
+        foreach (Slot* slot, m_slots) {
+            if (!slot->owner && slot->queue.isEmpty()) {
+                ++idle;
+                if (!oldest || slot->lastUsed < oldest->lastUsed)
+                    oldest = slot;
+            }
+        }
+        if (idle <= m_maxIdle)
+            break;
+        m_slots.remove(oldest->key);
+        closed << oldest->producer;
+        delete oldest;
+    }
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef THUMBNAILPRODUCERPOOL_H
+#define THUMBNAILPRODUCERPOOL_H
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <MltProducer.h>
+#include <MltProfile.h>
+
+/*!
+  \class ThumbnailProducerPool
+  \brief The ThumbnailProducerPool keeps producers open for making thumbnails.
+
+  \threadsafe
+
+  Opening a file is much more expensive than decoding one frame, so the
+  producers that make thumbnails are kept open and reused. A producer is
+  keyed by its profile name, service, and resource, and it already has the
+  scaling and color space filters that thumbnails need.
+
+  A producer is used by one thread at a time. Requests for a file whose
+  producer is busy wait for it instead of opening the file again, and they
+  are served in order of their frame number so that the producer mostly
+  seeks forward. Idle producers beyond maxIdle() are closed, least recently
+  used first.
+*/
+
+class ThumbnailProducerPool
+{
+public:
+    static ThumbnailProducerPool& singleton();
+
+    explicit ThumbnailProducerPool(int maxIdle);
+    ~ThumbnailProducerPool();
+
+    int maxIdle() const { return m_maxIdle; }
+
+    /*!
+      Checks out the producer for \a resource and waits if another thread is
+      using it. \a frameNumber is the first frame the caller is going to
+      seek to. The result must be returned with release(), even if it is not
+      valid.
+    */
+    Mlt::Producer* acquire(const char* profileName, const QString& service,
+                           const QString& resource, int frameNumber);
+    void release(Mlt::Producer* producer);
+
+private:
+    Q_DISABLE_COPY(ThumbnailProducerPool)
+
+    struct Slot {
+        QString key;
+        Mlt::Producer* producer;
+        int owner;                  // ticket of the user, 0 if idle
+        QMultiMap<int, int> queue;  // frame number to ticket of waiters
+        quint64 lastUsed;
+    };
+
+    Mlt::Profile* profile(const char* name);
+    void evict(QList<Mlt::Producer*>& closed);
+
+    int m_maxIdle;
+    QMutex m_mutex;
+    QWaitCondition m_released;
+    QHash<QString, Slot*> m_slots;
+    QHash<QString, Mlt::Profile*> m_profiles;
+    int m_nextTicket;
+    quint64 m_clock;
+};
+
+#endif // THUMBNAILPRODUCERPOOL_H
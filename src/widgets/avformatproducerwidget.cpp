@@ -562,7 +562,9 @@ void AvformatProducerWidget::on_actionFFmpegIntegrityCheck_triggered()
     args << "-v" << "info";
     args << "-i" << resource;
     args << "-f" << "null" << "pipe:";
-    JOBS.add(new FfmpegJob(resource, args));
+    AbstractJob* job = new FfmpegJob(resource, args);
+    job->setPriority(AbstractJob::HighPriority);
+    JOBS.add(job);
 }
 
 void AvformatProducerWidget::on_actionFFmpegConvert_triggered()
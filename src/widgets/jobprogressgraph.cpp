@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "jobprogressgraph.h"
+#include "jobs/abstractjob.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <QPolygonF>
+#include <QTime>
+
+JobProgressGraph::JobProgressGraph(QWidget* parent)
+    : QWidget(parent)
+    , m_job()
+{
+    setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Fixed);
+}
+
+void JobProgressGraph::setJob(AbstractJob* job)
+{
+    if (m_job == job)
+        return;
+    if (m_job)
+        disconnect(m_job.data(), SIGNAL(progressSampled(AbstractJob*)), this, SLOT(onProgressSampled(AbstractJob*)));
+    m_job = job;
+    if (m_job)
+        connect(m_job.data(), SIGNAL(progressSampled(AbstractJob*)), this, SLOT(onProgressSampled(AbstractJob*)));
+    update();
+}
+
+QSize JobProgressGraph::sizeHint() const
+{
+    return QSize(200, fontMetrics().height() * 5);
+}
+
+void JobProgressGraph::onProgressSampled(AbstractJob* job)
+{
+    if (job == m_job)
+        update();
+}
+
+void JobProgressGraph::paintEvent(QPaintEvent*)
+{
+    QPainter p(this);
+    const QPalette& pal = palette();
+    p.fillRect(rect(), pal.base());
+    if (!m_job)
+        return;
+    const QVector<AbstractJob::ProgressSample> samples = m_job->progressSamples();
+    if (samples.isEmpty()) {
+        p.setPen(pal.color(QPalette::Disabled, QPalette::Text));
+        p.drawText(rect(), Qt::AlignCenter, tr("No progress data"));
+        return;
+    }
+
+    const AbstractJob::ProgressSample& last = samples.last();
+    double maxFps = 1.0;
+    int maxRemaining = 1;
+    foreach (const AbstractJob::ProgressSample& sample, samples) {
+        maxFps = qMax(maxFps, sample.fps);
+        maxRemaining = qMax(maxRemaining, sample.remaining);
+    }
+
+    // The text summary takes the top line and the graph the rest.
+    const int textHeight = fontMetrics().height();
+    const QRectF area(0, textHeight, width() - 1, height() - textHeight - 1);
+    const double timeScale = area.width() / qMax(1, last.elapsed);
+    QPolygonF fps;
+    QPolygonF remaining;
+    fps << QPointF(area.left(), area.bottom());
+    foreach (const AbstractJob::ProgressSample& sample, samples) {
+        const double x = area.left() + sample.elapsed * timeScale;
+        fps << QPointF(x, area.bottom() - sample.fps / maxFps * area.height());
+        if (sample.remaining >= 0)
+            remaining << QPointF(x, area.bottom() - double(sample.remaining) / maxRemaining * area.height());
+    }
+    fps << QPointF(fps.last().x(), area.bottom());
+
+    QColor fpsColor = pal.color(QPalette::Highlight);
+    fpsColor.setAlpha(128);
+    p.setPen(Qt::NoPen);
+    p.setBrush(fpsColor);
+    p.drawPolygon(fps);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.setPen(QPen(pal.color(QPalette::Text), 1.5));
+    p.setBrush(Qt::NoBrush);
+    p.drawPolyline(remaining);
+    p.setRenderHint(QPainter::Antialiasing, false);
+
+    QString text = tr("%1 fps (%2x)").arg(last.fps, 0, 'f', 1).arg(last.speed, 0, 'f', 2);
+    if (last.remaining >= 0)
+        text += "  " + tr("%1 left").arg(QTime(0, 0).addSecs(last.remaining).toString("hh:mm:ss"));
+    if (last.bytes > 0)
+        text += "  " + tr("%1 MiB").arg(last.bytes / 1024.0 / 1024.0, 0, 'f', 1);
+    p.setPen(pal.color(QPalette::Text));
+    p.drawText(QRect(2, 0, width() - 4, textHeight), Qt::AlignLeft | Qt::AlignVCenter, text);
+}
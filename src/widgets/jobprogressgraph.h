@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JOBPROGRESSGRAPH_H
+#define JOBPROGRESSGRAPH_H
+
+#include <QWidget>
+#include <QPointer>
+
+class AbstractJob;
+
+/*!
+  \class JobProgressGraph
+  \brief The JobProgressGraph plots the frames per second and the estimated
+  time remaining of a job over its run.
+
+  The graph follows the progress samples of the job as they are recorded.
+  Frames per second are drawn as a filled area and the time remaining as a
+  line, each scaled to its own maximum.
+*/
+
+class JobProgressGraph : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit JobProgressGraph(QWidget* parent = 0);
+
+    void setJob(AbstractJob* job);
+
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent(QPaintEvent*);
+
+private slots:
+    void onProgressSampled(AbstractJob* job);
+
+private:
+    QPointer<AbstractJob> m_job;
+};
+
+#endif // JOBPROGRESSGRAPH_H
@@ -14,10 +14,14 @@ PlaylistIconView::PlaylistIconView(QWidget *parent)
     , m_gridSize(170, 100)
     , m_draggingOverPos(QPoint())
     , m_itemsPerRow(3)
+    , m_selectionDirty(true)
 {
+    // The cost of a thumbnail is its size in KiB.
+    m_thumbnails.setMaxCost(64 * 1024);
     verticalScrollBar()->setSingleStep(100);
     verticalScrollBar()->setPageStep(400);
     setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(&Settings, SIGNAL(playlistThumbnailsChanged()), SLOT(clearCaches()));
     connect(&Settings, SIGNAL(playlistThumbnailsChanged()), SLOT(updateSizes()));
 }
 
@@ -32,6 +36,7 @@ QRect PlaylistIconView::visualRect(const QModelIndex &index) const
 void PlaylistIconView::rowsInserted(const QModelIndex &parent, int start, int end)
 {
     QAbstractItemView::rowsInserted(parent, start, end);
+    clearCaches();
     updateSizes();
     viewport()->update();
 }
@@ -39,6 +44,7 @@ void PlaylistIconView::rowsInserted(const QModelIndex &parent, int start, int en
 void PlaylistIconView::rowsAboutToBeRemoved(const QModelIndex &parent, int start, int end)
 {
     QAbstractItemView::rowsAboutToBeRemoved(parent, start, end);
+    clearCaches();
     updateSizes();
     viewport()->update();
 }
@@ -46,10 +52,70 @@ void PlaylistIconView::rowsAboutToBeRemoved(const QModelIndex &parent, int start
 void PlaylistIconView::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
 {
     QAbstractItemView::dataChanged(topLeft, bottomRight, roles);
+    if (roles.isEmpty() || roles.contains(Qt::DecorationRole)) {
+        for (int row = topLeft.row(); row <= bottomRight.row(); row++)
+            m_thumbnails.remove(row);
+    }
     updateSizes();
     viewport()->update();
 }
 
+void PlaylistIconView::selectionChanged(const QItemSelection &selected, const QItemSelection &deselected)
+{
+    QAbstractItemView::selectionChanged(selected, deselected);
+    if (!m_selectionDirty) {
+        setSelectionBits(deselected, false);
+        setSelectionBits(selected, true);
+    }
+    viewport()->update();
+}
+
+void PlaylistIconView::reset()
+{
+    clearCaches();
+    QAbstractItemView::reset();
+}
+
+void PlaylistIconView::clearCaches()
+{
+    m_thumbnails.clear();
+    m_selectionDirty = true;
+}
+
+void PlaylistIconView::setSelectionBits(const QItemSelection &selection, bool value)
+{
+    foreach (const QItemSelectionRange& range, selection) {
+        if (range.bottom() >= m_selected.size()) {
+            m_selectionDirty = true;
+            return;
+        }
+        m_selected.fill(value, range.top(), range.bottom() + 1);
+    }
+}
+
+void PlaylistIconView::updateSelectionBits()
+{
+    if (!m_selectionDirty)
+        return;
+    m_selected.fill(false, model()->rowCount());
+    m_selectionDirty = false;
+    if (selectionModel())
+        setSelectionBits(selectionModel()->selection(), true);
+}
+
+QPixmap PlaylistIconView::thumbnail(const QModelIndex &index)
+{
+    QPixmap* cached = m_thumbnails.object(index.row());
+    if (cached)
+        return *cached;
+    // The model composes a new image on every request, so keep the result
+    // ready to draw.
+    QPixmap pixmap = QPixmap::fromImage(index.data(Qt::DecorationRole).value<QImage>());
+    m_thumbnails.insert(index.row(), new QPixmap(pixmap),
+                        qMax(1, pixmap.width() * pixmap.height() * 4 / 1024));
+    return pixmap;
+}
+
 void PlaylistIconView::scrollTo(const QModelIndex &index, ScrollHint hint)
 {
     Q_UNUSED(index);
@@ -111,34 +177,36 @@ void PlaylistIconView::currentChanged(const QModelIndex &current, const QModelIn
     QAbstractItemView::currentChanged(current, previous);
 }
 
-void PlaylistIconView::paintEvent(QPaintEvent*)
+void PlaylistIconView::paintEvent(QPaintEvent* event)
 {
     QPainter painter(viewport());
     QPalette pal(palette());
-    painter.fillRect(rect(), pal.base());
+    painter.fillRect(event->rect(), pal.base());
 
     if (!model())
         return;
 
     QAbstractItemModel * m = model();
     QRect dragIndicator;
-
-    for (int row = 0; row <= m->rowCount() / m_itemsPerRow; row++) {
+    const int count = m->rowCount();
+    const int scroll = verticalScrollBar()->value();
+    // Only visit the rows of the grid that intersect the damaged area.
+    const int firstRow = qMax(0, (scroll + event->rect().top()) / m_gridSize.height());
+    const int lastRow = (scroll + event->rect().bottom()) / m_gridSize.height();
+    updateSelectionBits();
+
+    for (int row = firstRow; row <= lastRow; row++) {
         for (int col = 0; col < m_itemsPerRow; col++) {
             const int rowIdx = row * m_itemsPerRow + col;
-
-            QModelIndex idx = m->index(rowIdx, 0);
-            if (!idx.isValid())
+            if (rowIdx >= count)
                 break;
 
-            QRect itemRect(col * m_gridSize.width(), row * m_gridSize.height() - verticalScrollBar()->value(),
+            QModelIndex idx = m->index(rowIdx, 0);
+            QRect itemRect(col * m_gridSize.width(), row * m_gridSize.height() - scroll,
                     m_gridSize.width(), m_gridSize.height());
 
-            if (itemRect.bottom() < 0 || itemRect.top() > this->height())
-                continue;
-
-            const bool selected = selectedIndexes().contains(idx);
-            const QImage thumb = idx.data(Qt::DecorationRole).value<QImage>();
+            const bool selected = rowIdx < m_selected.size() && m_selected.testBit(rowIdx);
+            const QPixmap thumb = thumbnail(idx);
 
             QRect imageBoundingRect = itemRect;
             imageBoundingRect.setHeight(0.7 * imageBoundingRect.height());
@@ -167,7 +235,7 @@ void PlaylistIconView::paintEvent(QPaintEvent*)
                 painter.drawLine(buttonRect.bottomLeft(), buttonRect.bottomRight());
             }
 
-            painter.drawImage(imageRect, thumb);
+            painter.drawPixmap(imageRect, thumb);
             painter.setPen(pal.color(QPalette::WindowText));
             painter.drawText(textRect, Qt::AlignCenter,
                     painter.fontMetrics().elidedText(idx.data(Qt::DisplayRole).toString(), Qt::ElideMiddle, textRect.width()));
@@ -2,6 +2,9 @@
 #define SRC_WIDGETS_PLAYLISTICONVIEW_H
 
 #include <QAbstractItemView>
+#include <QBitArray>
+#include <QCache>
+#include <QPixmap>
 
 class PlaylistIconView : public QAbstractItemView
 {
@@ -31,17 +34,26 @@ public:
     void rowsInserted(const QModelIndex &parent, int start, int end) Q_DECL_OVERRIDE;
     void rowsAboutToBeRemoved(const QModelIndex &parent, int start, int end) Q_DECL_OVERRIDE;
     void dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles = QVector<int>()) Q_DECL_OVERRIDE;
+    void selectionChanged(const QItemSelection &selected, const QItemSelection &deselected) Q_DECL_OVERRIDE;
+    void reset() Q_DECL_OVERRIDE;
 
 private slots:
     void updateSizes();
+    void clearCaches();
 
 private:
     int rowWidth() const;
     QAbstractItemView::DropIndicatorPosition position(const QPoint &pos, const QRect &rect, const QModelIndex &index) const;
+    void setSelectionBits(const QItemSelection &selection, bool value);
+    void updateSelectionBits();
+    QPixmap thumbnail(const QModelIndex &index);
 
     QSize m_gridSize;
     QPoint m_draggingOverPos;
     int m_itemsPerRow;
+    QBitArray m_selected;
+    bool m_selectionDirty;
+    QCache<int, QPixmap> m_thumbnails;
 };
 
 #endif
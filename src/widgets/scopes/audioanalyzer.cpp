@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audioanalyzer.h"
+#include "mltcontroller.h"
+#include <Logger.h>
+#include <QMutexLocker>
+#include <MltFilter.h>
+#include <string.h>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCOPE_USE_SSE2
+#endif
+
+static const int kCacheSize = 4;
+static const int kWindowBits = 13;
+static const int kWindowSize = 1 << kWindowBits; // 5.9 Hz FFT bins at 48kHz
+static const int kBinCount = kWindowSize / 2 + 1;
+
+struct band
+{
+    float low;    // Low frequency
+    float center; // Center frequency
+    float high;   // High frequency
+    const char* label;
+};
+
+// Preferred frequencies from ISO R 266-1997 / ANSI S1.6-1984
+static const band BAND_TAB[] =
+{
+//     Low      Preferred  High                Band
+//     Freq      Center    Freq     Label       Num
+    {     1.12,     1.25,     1.41, "1.25"  }, //  1
+    {     1.41,     1.60,     1.78, "1.6"   }, //  2
+    {     1.78,     2.00,     2.24, "2.0"   }, //  3
+    {     2.24,     2.50,     2.82, "2.5"   }, //  4
+    {     2.82,     3.15,     3.55, "3.15"  }, //  5
+    {     3.55,     4.00,     4.44, "4.0"   }, //  6
+    {     4.44,     5.00,     6.00, "5.0"   }, //  7
+    {     6.00,     6.30,     7.00, "6.3"   }, //  8
+    {     7.00,     8.00,     9.00, "8.0"   }, //  9
+    {     9.00,    10.00,    11.00, "10"    }, // 10
+    {    11.00,    12.50,    14.00, "12.5"  }, // 11
+    {    14.00,    16.00,    18.00, "16"    }, // 12
+    {    18.00,    20.00,    22.00, "20"    }, // 13 - First in audible range
+    {    22.00,    25.00,    28.00, "25"    }, // 14
+    {    28.00,    31.50,    35.00, "31"    }, // 15
+    {    35.00,    40.00,    45.00, "40"    }, // 16
+    {    45.00,    50.00,    56.00, "50"    }, // 17
+    {    56.00,    63.00,    71.00, "63"    }, // 18
+    {    71.00,    80.00,    90.00, "80"    }, // 19
+    {    90.00,   100.00,   112.00, "100"   }, // 20
+    {   112.00,   125.00,   140.00, "125"   }, // 21
+    {   140.00,   160.00,   179.00, "160"   }, // 22
+    {   179.00,   200.00,   224.00, "200"   }, // 23
+    {   224.00,   250.00,   282.00, "250"   }, // 24
+    {   282.00,   315.00,   353.00, "315"   }, // 25
+    {   353.00,   400.00,   484.00, "400"   }, // 26
+    {   484.00,   500.00,   560.00, "500"   }, // 27
+    {   560.00,   630.00,   706.00, "630"   }, // 28
+    {   706.00,   800.00,   897.00, "800"   }, // 29
+    {   897.00,  1000.00,  1121.00, "1k"    }, // 30
+    {  1121.00,  1250.00,  1401.00, "1.3k"  }, // 31
+    {  1401.00,  1600.00,  1794.00, "1.6k"  }, // 32
+    {  1794.00,  2000.00,  2242.00, "2k"    }, // 33
+    {  2242.00,  2500.00,  2803.00, "2.5k"  }, // 34
+    {  2803.00,  3150.00,  3531.00, "3.2k"  }, // 35
+    {  3531.00,  4000.00,  4484.00, "4k"    }, // 36
+    {  4484.00,  5000.00,  5605.00, "5k"    }, // 37
+    {  5605.00,  6300.00,  7062.00, "6.3k"  }, // 38
+    {  7062.00,  8000.00,  8908.00, "8k"    }, // 39
+    {  8908.00, 10000.00, 11210.00, "10k"   }, // 40
+    { 11210.00, 12500.00, 14012.00, "13k"   }, // 41
+    { 14012.00, 16000.00, 17936.00, "16k"   }, // 42
+    { 17936.00, 20000.00, 22421.00, "20k"   }, // 43 - Last in audible range
+};
+
+static const int FIRST_AUDIBLE_BAND_INDEX = 12;
+static const int LAST_AUDIBLE_BAND_INDEX = 42;
+Q_STATIC_ASSERT(LAST_AUDIBLE_BAND_INDEX - FIRST_AUDIBLE_BAND_INDEX + 1 == AudioAnalysis::BandCount);
+
+AudioAnalyzer::AudioAnalyzer()
+  : m_mutex(QMutex::NonRecursive)
+  , m_entries(kCacheSize)
+  , m_next(0)
+  , m_frequency(0)
+  , m_history(kWindowSize, 0.0f)
+  , m_window(kWindowSize)
+  , m_re(kWindowSize)
+  , m_im(kWindowSize)
+  , m_twiddleRe(kWindowSize - 1)
+  , m_twiddleIm(kWindowSize - 1)
+  , m_bitReverse(kWindowSize)
+  , m_bandOfBin(kBinCount, -1)
+  , m_loudness(0)
+{
+    for (int i = 0; i < kWindowSize; i++) {
+        // Hann window
+        m_window[i] = 0.5 * (1.0 - cos(2.0 * M_PI * i / (kWindowSize - 1)));
+        int reversed = 0;
+        for (int bit = 0; bit < kWindowBits; bit++)
+            reversed |= ((i >> bit) & 1) << (kWindowBits - 1 - bit);
+        m_bitReverse[i] = reversed;
+    }
+    // The twiddle factors of each stage are stored contiguously, starting at
+    // half - 1, so that the butterfly loop reads them sequentially.
+    for (int half = 1; half < kWindowSize; half <<= 1) {
+        for (int j = 0; j < half; j++) {
+            m_twiddleRe[half - 1 + j] = cos(-M_PI * j / half);
+            m_twiddleIm[half - 1 + j] = sin(-M_PI * j / half);
+        }
+    }
+}
+
+AudioAnalyzer& AudioAnalyzer::singleton()
+{
+    static AudioAnalyzer* instance = new AudioAnalyzer;
+    return *instance;
+}
+
+AudioAnalysis AudioAnalyzer::analyze(const SharedFrame& frame, int features)
+{
+    QMutexLocker locker(&m_mutex);
+    Entry& entry = entryFor(frame);
+    if (features & AudioAnalysis::Loudness)
+        features |= AudioAnalysis::Levels;
+    int missing = features & ~entry.result.features;
+    if (entry.result.channels > 0) {
+        if (missing & AudioAnalysis::Levels)
+            computeLevels(entry);
+        if (missing & AudioAnalysis::Spectrum)
+            computeSpectrum(entry);
+        if (missing & AudioAnalysis::Loudness)
+            computeLoudness(entry);
+    }
+    entry.result.features |= features;
+    return entry.result;
+}
+
+const char* AudioAnalyzer::bandLabel(int band)
+{
+    return BAND_TAB[band + FIRST_AUDIBLE_BAND_INDEX].label;
+}
+
+void AudioAnalyzer::setLoudnessMeterEnabled(const char* meter, bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    loudnessFilter()->set(QByteArray("calc_").append(meter).constData(), enabled);
+}
+
+void AudioAnalyzer::resetLoudness()
+{
+    QMutexLocker locker(&m_mutex);
+    loudnessFilter()->set("reset", 1);
+}
+
+QString AudioAnalyzer::loudnessTime()
+{
+    QMutexLocker locker(&m_mutex);
+    return loudnessFilter()->get_time("frames_processed");
+}
+
+AudioAnalyzer::Entry& AudioAnalyzer::entryFor(const SharedFrame& frame)
+{
+    for (int i = 0; i < m_entries.size(); i++) {
+        if (m_entries[i].frame == frame)
+            return m_entries[i];
+    }
+
+    // Replace the oldest entry.
+    Entry& entry = m_entries[m_next];
+    m_next = (m_next + 1) % m_entries.size();
+    entry.frame = frame;
+    memset(&entry.result, 0, sizeof(entry.result));
+    entry.samples = 0;
+    entry.frequency = 0;
+
+    // Convert the interleaved s16 samples to planar float once for all
+    // features.
+    SharedFrameAudio audio = frame.get_audio_view();
+    if (audio.is_valid() && audio.frequency() > 0) {
+        const int channels = qMin(audio.channels(), int(AudioAnalysis::MaxChannels));
+        const int stride = audio.channels();
+        const int samples = audio.samples();
+        const float scale = 1.0f / 32768.0f;
+        entry.planar.resize(channels * samples);
+        for (int c = 0; c < channels; c++) {
+            const int16_t* src = audio.data() + c;
+            float* dst = entry.planar.data() + c * samples;
+            for (int i = 0; i < samples; i++)
+                dst[i] = src[i * stride] * scale;
+        }
+        entry.result.channels = channels;
+        entry.samples = samples;
+        entry.frequency = audio.frequency();
+    } else {
+        entry.planar.clear();
+    }
+    return entry;
+}
+
+void AudioAnalyzer::computeLevels(Entry& entry)
+{
+    const int n = entry.samples;
+    for (int c = 0; c < entry.result.channels; c++) {
+        const float* p = entry.planar.constData() + c * n;
+        float peak = 0.0f;
+        float sum = 0.0f;
+        int i = 0;
+#ifdef SCOPE_USE_SSE2
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 vpeak = _mm_setzero_ps();
+        __m128 vsum = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4) {
+            __m128 x = _mm_loadu_ps(p + i);
+            vpeak = _mm_max_ps(vpeak, _mm_and_ps(x, absMask));
+            vsum = _mm_add_ps(vsum, _mm_mul_ps(x, x));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, vpeak);
+        peak = qMax(qMax(lanes[0], lanes[1]), qMax(lanes[2], lanes[3]));
+        _mm_storeu_ps(lanes, vsum);
+        sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+        for (; i < n; i++) {
+            peak = qMax(peak, qAbs(p[i]));
+            sum += p[i] * p[i];
+        }
+        entry.result.peak[c] = peak;
+        entry.result.rms[c] = n > 0 ? sqrt(sum / n) : 0.0f;
+    }
+}
+
+void AudioAnalyzer::computeSpectrum(Entry& entry)
+{
+    setFrequency(entry.frequency);
+
+    // Slide the mono mix of the new samples into the analysis window.
+    const int channels = entry.result.channels;
+    const int count = qMin(entry.samples, kWindowSize);
+    const int skip = entry.samples - count;
+    float* history = m_history.data();
+    memmove(history, history + count, (kWindowSize - count) * sizeof(float));
+    float* mix = history + kWindowSize - count;
+    memcpy(mix, entry.planar.constData() + skip, count * sizeof(float));
+    for (int c = 1; c < channels; c++) {
+        const float* p = entry.planar.constData() + c * entry.samples + skip;
+        for (int i = 0; i < count; i++)
+            mix[i] += p[i];
+    }
+    const float gain = 1.0f / channels;
+    for (int i = 0; i < count; i++)
+        mix[i] *= gain;
+
+    float* re = m_re.data();
+    float* im = m_im.data();
+    const float* window = m_window.constData();
+    const int* reverse = m_bitReverse.constData();
+    for (int i = 0; i < kWindowSize; i++)
+        re[reverse[i]] = history[i] * window[i];
+    memset(im, 0, kWindowSize * sizeof(float));
+    fft();
+
+    // Scale so that a full scale sine reads 1.0 through the Hann window.
+    const float scale = 4.0f / kWindowSize;
+    for (int bin = 0; bin < kBinCount; bin++)
+        re[bin] = sqrt(re[bin] * re[bin] + im[bin] * im[bin]) * scale;
+
+    // Pick the highest bin level within each band to represent the band.
+    float* bands = entry.result.bands;
+    const int* bandOfBin = m_bandOfBin.constData();
+    for (int bin = 0; bin < kBinCount; bin++) {
+        int band = bandOfBin[bin];
+        if (band >= 0 && bands[band] < re[bin])
+            bands[band] = re[bin];
+    }
+}
+
+void AudioAnalyzer::computeLoudness(Entry& entry)
+{
+    // The R128 meters come from the loudness_meter filter, which keeps the
+    // gating history. Its sample peak is disabled in favor of the levels
+    // computed above.
+    Mlt::Filter* filter = loudnessFilter();
+    mlt_audio_format format = mlt_audio_f32le;
+    int channels = entry.frame.get_audio_channels();
+    int frequency = entry.frequency;
+    int samples = entry.samples;
+    Mlt::Frame mFrame = entry.frame.clone(true, false, false);
+    filter->process(mFrame);
+    mFrame.get_audio(format, frequency, channels, samples);
+    entry.result.integrated = filter->get_double("program");
+    entry.result.shortterm = filter->get_double("shortterm");
+    entry.result.momentary = filter->get_double("momentary");
+    entry.result.range = filter->get_double("range");
+    entry.result.truePeak = filter->get_double("true_peak");
+}
+
+void AudioAnalyzer::setFrequency(int frequency)
+{
+    if (frequency == m_frequency)
+        return;
+    m_frequency = frequency;
+    m_history.fill(0.0f);
+
+    // Align the bin frequencies with the band frequencies.
+    m_bandOfBin.fill(-1);
+    const double binWidth = double(frequency) / kWindowSize;
+    int band = 0;
+    bool firstBandFound = false;
+    for (int bin = 0; bin < kBinCount; bin++) {
+        double F = binWidth * bin;
+        if (!firstBandFound) {
+            // Skip bins that come before the first band.
+            if (BAND_TAB[band + FIRST_AUDIBLE_BAND_INDEX].low > F)
+                continue;
+            firstBandFound = true;
+        } else if (BAND_TAB[band + FIRST_AUDIBLE_BAND_INDEX].high < F) {
+            // This bin is outside of this band - move to the next band.
+            if (++band >= AudioAnalysis::BandCount)
+                break;
+        }
+        m_bandOfBin[bin] = band;
+    }
+}
+
+void AudioAnalyzer::fft()
+{
+    // Iterative radix-2 decimation in time over the bit reversed input. Real
+    // and imaginary parts are kept in separate arrays so that the butterfly
+    // loop runs over contiguous floats and can be vectorized by the compiler.
+    float* re = m_re.data();
+    float* im = m_im.data();
+    for (int half = 1; half < kWindowSize; half <<= 1) {
+        const float* wr = m_twiddleRe.constData() + half - 1;
+        const float* wi = m_twiddleIm.constData() + half - 1;
+        for (int k = 0; k < kWindowSize; k += 2 * half) {
+            float* ar = re + k;
+            float* ai = im + k;
+            float* br = ar + half;
+            float* bi = ai + half;
+            for (int j = 0; j < half; j++) {
+                float tr = br[j] * wr[j] - bi[j] * wi[j];
+                float ti = br[j] * wi[j] + bi[j] * wr[j];
+                br[j] = ar[j] - tr;
+                bi[j] = ai[j] - ti;
+                ar[j] += tr;
+                ai[j] += ti;
+            }
+        }
+    }
+}
+
+Mlt::Filter* AudioAnalyzer::loudnessFilter()
+{
+    if (!m_loudness) {
+        m_loudness = new Mlt::Filter(MLT.profile(), "loudness_meter");
+        m_loudness->set("calc_peak", 0);
+    }
+    return m_loudness;
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AUDIOANALYZER_H
+#define AUDIOANALYZER_H
+
+#include "sharedframe.h"
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+namespace Mlt {
+    class Filter;
+}
+
+/*!
+  \class AudioAnalysis
+  \brief The AudioAnalysis holds the results of analyzing the audio of one
+  frame.
+
+  Levels are linear with 1.0 at full scale. Loudness values are in LUFS, LU
+  and dBTP as reported by the loudness_meter filter. Only the members of the
+  features that were requested are valid.
+*/
+
+struct AudioAnalysis
+{
+    enum Feature {
+        Levels   = 0x1, //!< Sample peak and RMS of every channel
+        Spectrum = 0x2, //!< Peak magnitude of every audible third-octave band
+        Loudness = 0x4  //!< EBU R128 meters (implies Levels)
+    };
+
+    enum {
+        MaxChannels = 8,
+        BandCount = 31
+    };
+
+    int features;
+    int channels;
+    float peak[MaxChannels];
+    float rms[MaxChannels];
+    float bands[BandCount];
+    double momentary;
+    double shortterm;
+    double integrated;
+    double range;
+    double truePeak;
+};
+
+/*!
+  \class AudioAnalyzer
+  \brief The AudioAnalyzer is the audio analysis stage shared by the audio
+  scopes.
+
+  \threadsafe
+
+  Each scope still receives the displayed frames in its own queue and asks
+  analyze() for the features it shows. The samples of a frame are converted
+  to planar float once, and every feature is computed at most once per
+  frame, no matter how many scopes request it. The results of the last few
+  frames are kept so that scopes refreshing at different times still share
+  them.
+
+  The spectrum and loudness features are stateful: they advance their
+  analysis window once for every distinct frame they are computed for, so
+  they must be requested for frames in playback order. Each of them is only
+  shown by one scope, which requests them for every frame it receives.
+*/
+
+class AudioAnalyzer
+{
+    AudioAnalyzer();
+
+public:
+    static AudioAnalyzer& singleton();
+
+    /*!
+      Returns the analysis of the audio of \a frame containing at least the
+      \a features (a combination of AudioAnalysis::Feature). Returns an
+      analysis with no channels if the frame has no audio.
+    */
+    AudioAnalysis analyze(const SharedFrame& frame, int features);
+
+    //! Returns the center frequency label of spectrum band \a band.
+    static const char* bandLabel(int band);
+
+    //! Enables the "calc_" property \a meter of the loudness meter.
+    void setLoudnessMeterEnabled(const char* meter, bool enabled);
+
+    //! Restarts the loudness measurement.
+    void resetLoudness();
+
+    //! Returns the duration measured since the loudness was last reset.
+    QString loudnessTime();
+
+private:
+    Q_DISABLE_COPY(AudioAnalyzer)
+
+    struct Entry
+    {
+        SharedFrame frame;
+        QVector<float> planar;
+        int samples;
+        int frequency;
+        AudioAnalysis result;
+    };
+
+    Entry& entryFor(const SharedFrame& frame);
+    void computeLevels(Entry& entry);
+    void computeSpectrum(Entry& entry);
+    void computeLoudness(Entry& entry);
+    void setFrequency(int frequency);
+    void fft();
+    Mlt::Filter* loudnessFilter();
+
+    QMutex m_mutex;
+    QVector<Entry> m_entries;
+    int m_next;
+
+    // Spectrum state
+    int m_frequency;
+    QVector<float> m_history;
+    QVector<float> m_window;
+    QVector<float> m_re;
+    QVector<float> m_im;
+    QVector<float> m_twiddleRe;
+    QVector<float> m_twiddleIm;
+    QVector<int> m_bitReverse;
+    QVector<int> m_bandOfBin;
+
+    // Loudness state
+    Mlt::Filter* m_loudness;
+};
+
+#endif // AUDIOANALYZER_H
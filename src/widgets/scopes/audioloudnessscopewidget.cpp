@@ -17,6 +17,7 @@
  */
 
 #include "audioloudnessscopewidget.h"
+#include "audioanalyzer.h"
 #include <Logger.h>
 #include <QVBoxLayout>
 #include <QQmlEngine>
@@ -28,10 +29,8 @@
 #include <QMenu>
 #include <QLabel>
 #include <QTimer>
-#include <MltProfile.h>
 #include <math.h>
 #include "qmltypes/qmlutilities.h"
-#include "mltcontroller.h"
 #include "settings.h"
 
 static double onedec( double in )
@@ -41,7 +40,11 @@ static double onedec( double in )
 
 AudioLoudnessScopeWidget::AudioLoudnessScopeWidget()
   : ScopeWidget("AudioLoudnessMeter")
-  , m_loudnessFilter(0)
+  , m_mutex(QMutex::NonRecursive)
+  , m_integrated(-100)
+  , m_shortterm(-100)
+  , m_momentary(-100)
+  , m_range(0)
   , m_peak(-100)
   , m_true_peak(-100)
   , m_newData(false)
@@ -50,13 +53,12 @@ AudioLoudnessScopeWidget::AudioLoudnessScopeWidget()
   , m_timeLabel(new QLabel(this))
 {
     LOG_DEBUG() << "begin";
-    m_loudnessFilter = new Mlt::Filter(MLT.profile(), "loudness_meter");
-    m_loudnessFilter->set("calc_program", Settings.loudnessScopeShowMeter("integrated"));
-    m_loudnessFilter->set("calc_shortterm", Settings.loudnessScopeShowMeter("shortterm"));
-    m_loudnessFilter->set("calc_momentary", Settings.loudnessScopeShowMeter("momentary"));
-    m_loudnessFilter->set("calc_range", Settings.loudnessScopeShowMeter("range"));
-    m_loudnessFilter->set("calc_peak", Settings.loudnessScopeShowMeter("peak"));
-    m_loudnessFilter->set("calc_true_peak", Settings.loudnessScopeShowMeter("truepeak"));
+    AudioAnalyzer& analyzer = AudioAnalyzer::singleton();
+    analyzer.setLoudnessMeterEnabled("program", Settings.loudnessScopeShowMeter("integrated"));
+    analyzer.setLoudnessMeterEnabled("shortterm", Settings.loudnessScopeShowMeter("shortterm"));
+    analyzer.setLoudnessMeterEnabled("momentary", Settings.loudnessScopeShowMeter("momentary"));
+    analyzer.setLoudnessMeterEnabled("range", Settings.loudnessScopeShowMeter("range"));
+    analyzer.setLoudnessMeterEnabled("true_peak", Settings.loudnessScopeShowMeter("truepeak"));
 
     setAutoFillBackground(true);
 
@@ -131,36 +133,38 @@ AudioLoudnessScopeWidget::AudioLoudnessScopeWidget()
 AudioLoudnessScopeWidget::~AudioLoudnessScopeWidget()
 {
     m_timer->stop();
-    delete m_loudnessFilter;
 }
 
 void AudioLoudnessScopeWidget::refreshScope(const QSize& /*size*/, bool /*full*/)
 {
+    AudioAnalyzer& analyzer = AudioAnalyzer::singleton();
     SharedFrame sFrame;
-    while (m_queue.count() > 0) {
-        sFrame = m_queue.pop();
-        if (sFrame.is_valid() && sFrame.get_audio_samples() > 0) {
-            mlt_audio_format format = mlt_audio_f32le;
-            int channels = sFrame.get_audio_channels();
-            int frequency = sFrame.get_audio_frequency();
-            int samples = sFrame.get_audio_samples();
-            if (channels && frequency && samples) {
-                Mlt::Frame mFrame = sFrame.clone(true, false, false);
-                m_loudnessFilter->process(mFrame);
-                mFrame.get_audio(format, frequency, channels, samples);
-                if( m_peak < m_loudnessFilter->get_double("peak") ) {
-                    m_peak = m_loudnessFilter->get_double("peak");
-                }
-                if( m_true_peak < m_loudnessFilter->get_double("true_peak") ) {
-                    m_true_peak = m_loudnessFilter->get_double("true_peak");
-                }
-                m_newData = true;
+    while (m_queue.tryPop(sFrame)) {
+        AudioAnalysis analysis = analyzer.analyze(sFrame, AudioAnalysis::Loudness);
+        if (analysis.channels > 0) {
+            // The sample peak comes from the levels shared with the peak meter.
+            double peak = 0.0;
+            for (int i = 0; i < analysis.channels; i++)
+                peak = qMax(peak, double(analysis.peak[i]));
+            peak = peak > 0.0 ? 20 * log10(peak) : -100.0;
+
+            QMutexLocker locker(&m_mutex);
+            m_integrated = analysis.integrated;
+            m_shortterm = analysis.shortterm;
+            m_momentary = analysis.momentary;
+            m_range = analysis.range;
+            if( m_peak < peak ) {
+                m_peak = peak;
             }
+            if( m_true_peak < analysis.truePeak ) {
+                m_true_peak = analysis.truePeak;
+            }
+            m_newData = true;
         }
     }
 
     // Update the time with every frame.
-    m_timeLabel->setText( m_loudnessFilter->get_time( "frames_processed" ) );
+    QMetaObject::invokeMethod(m_timeLabel, "setText", Qt::QueuedConnection, Q_ARG(QString, analyzer.loudnessTime()));
 }
 
 QString AudioLoudnessScopeWidget::getTitle()
@@ -185,67 +189,67 @@ void AudioLoudnessScopeWidget::setOrientation(Qt::Orientation orientation)
 
 void AudioLoudnessScopeWidget::onResetButtonClicked()
 {
-    m_loudnessFilter->set("reset", 1);
+    AudioAnalyzer::singleton().resetLoudness();
     m_timeLabel->setText( "00:00:00:00" );
     resetQview();
 }
 
 void AudioLoudnessScopeWidget::onIntegratedToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_program", checked);
+    AudioAnalyzer::singleton().setLoudnessMeterEnabled("program", checked);
     Settings.setLoudnessScopeShowMeter("integrated", checked);
     resetQview();
 }
 
 void AudioLoudnessScopeWidget::onShorttermToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_shortterm", checked);
+    AudioAnalyzer::singleton().setLoudnessMeterEnabled("shortterm", checked);
     Settings.setLoudnessScopeShowMeter("shortterm", checked);
     resetQview();
 }
 
 void AudioLoudnessScopeWidget::onMomentaryToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_momentary", checked);
+    AudioAnalyzer::singleton().setLoudnessMeterEnabled("momentary", checked);
     Settings.setLoudnessScopeShowMeter("momentary", checked);
     resetQview();
 }
 
 void AudioLoudnessScopeWidget::onRangeToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_range", checked);
+    AudioAnalyzer::singleton().setLoudnessMeterEnabled("range", checked);
     Settings.setLoudnessScopeShowMeter("range", checked);
     resetQview();
 }
 
 void AudioLoudnessScopeWidget::onPeakToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_peak", checked);
     Settings.setLoudnessScopeShowMeter("peak", checked);
     resetQview();
 }
 
 void AudioLoudnessScopeWidget::onTruePeakToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_true_peak", checked);
+    AudioAnalyzer::singleton().setLoudnessMeterEnabled("true_peak", checked);
     Settings.setLoudnessScopeShowMeter("truepeak", checked);
     resetQview();
 }
 
 void AudioLoudnessScopeWidget::updateMeters(void)
 {
+    QMutexLocker locker(&m_mutex);
     if (!m_newData) return;
-    if (m_loudnessFilter->get_int("calc_program") )
-        m_qview->rootObject()->setProperty("integrated", onedec(m_loudnessFilter->get_double("program")));
-    if (m_loudnessFilter->get_int("calc_shortterm") )
-        m_qview->rootObject()->setProperty("shortterm", onedec(m_loudnessFilter->get_double("shortterm")));
-    if (m_loudnessFilter->get_int("calc_momentary") )
-        m_qview->rootObject()->setProperty("momentary", onedec(m_loudnessFilter->get_double("momentary")));
-    if (m_loudnessFilter->get_int("calc_range") )
-        m_qview->rootObject()->setProperty("range", onedec(m_loudnessFilter->get_double("range")));
-    if (m_loudnessFilter->get_int("calc_peak") )
+    if (Settings.loudnessScopeShowMeter("integrated"))
+        m_qview->rootObject()->setProperty("integrated", onedec(m_integrated));
+    if (Settings.loudnessScopeShowMeter("shortterm"))
+        m_qview->rootObject()->setProperty("shortterm", onedec(m_shortterm));
+    if (Settings.loudnessScopeShowMeter("momentary"))
+        m_qview->rootObject()->setProperty("momentary", onedec(m_momentary));
+    if (Settings.loudnessScopeShowMeter("range"))
+        m_qview->rootObject()->setProperty("range", onedec(m_range));
+    if (Settings.loudnessScopeShowMeter("peak"))
         m_qview->rootObject()->setProperty("peak", onedec(m_peak));
-    if (m_loudnessFilter->get_int("calc_true_peak") )
+    if (Settings.loudnessScopeShowMeter("truepeak"))
         m_qview->rootObject()->setProperty("truePeak", onedec(m_true_peak));
     m_peak = -100;
     m_true_peak = -100;
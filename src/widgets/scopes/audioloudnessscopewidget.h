@@ -23,7 +23,6 @@
 #include <QMutex>
 #include <QImage>
 #include <QVector>
-#include <MltFilter.h>
 
 class QQuickWidget;
 class QLabel;
@@ -57,8 +56,12 @@ private:
     // Functions run in scope thread.
     void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
 
-    // Members accessed by scope thread.
-    Mlt::Filter* m_loudnessFilter;
+    // Members accessed by scope thread and GUI thread (mutex protected).
+    QMutex m_mutex;
+    double m_integrated;
+    double m_shortterm;
+    double m_momentary;
+    double m_range;
     double m_peak;
     double m_true_peak;
     bool m_newData;
@@ -17,23 +17,19 @@
  */
 
 #include "audiopeakmeterscopewidget.h"
+#include "audioanalyzer.h"
 #include <Logger.h>
 #include <QVBoxLayout>
-#include <MltProfile.h>
 #include "widgets/audiometerwidget.h"
-#include "mltcontroller.h"
 #include <cmath> // log10()
 
 AudioPeakMeterScopeWidget::AudioPeakMeterScopeWidget()
   : ScopeWidget("AudioPeakMeter")
-  , m_filter(0)
   , m_audioMeter(0)
   , m_orientation((Qt::Orientation)-1)
   , m_channels( 0 )
 {
     LOG_DEBUG() << "begin";
-    m_filter = new Mlt::Filter(MLT.profile(), "audiolevel");
-    m_filter->set("iec_scale", 0);
     qRegisterMetaType< QVector<double> >("QVector<double>");
     setAutoFillBackground(true);
 
@@ -50,26 +46,20 @@ AudioPeakMeterScopeWidget::AudioPeakMeterScopeWidget()
 
 AudioPeakMeterScopeWidget::~AudioPeakMeterScopeWidget()
 {
-    delete m_filter;
 }
 
 void AudioPeakMeterScopeWidget::refreshScope(const QSize& /*size*/, bool /*full*/)
 {
     SharedFrame sFrame;
-    while (m_queue.count() > 0) {
-        sFrame = m_queue.pop();
-        if (sFrame.is_valid() && sFrame.get_audio_samples() > 0) {
-            mlt_audio_format format = mlt_audio_s16;
-            int channels = sFrame.get_audio_channels();
-            int frequency = sFrame.get_audio_frequency();
-            int samples = sFrame.get_audio_samples();
-            Mlt::Frame mFrame = sFrame.clone(true, false, false);
-            m_filter->process(mFrame);
-            mFrame.get_audio( format, frequency, channels, samples );
+    while (m_queue.tryPop(sFrame)) {
+        // The level is the channel peak, matching audiolevel with
+        // iec_scale=0. It is shared with the loudness scope.
+        AudioAnalysis analysis = AudioAnalyzer::singleton().analyze(sFrame, AudioAnalysis::Levels);
+        if (analysis.channels > 0) {
+            int channels = analysis.channels;
             QVector<double> levels;
             for (int i = 0; i < channels; i++) {
-                QString s = QString("meta.media.audio_level.%1").arg(i);
-                double audioLevel = mFrame.get_double(s.toLatin1().constData());
+                double audioLevel = analysis.peak[i];
                 if (audioLevel == 0.0) {
                     levels << -100.0;
                 } else {
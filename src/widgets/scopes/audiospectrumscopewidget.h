@@ -21,9 +21,9 @@
 
 
 #include "scopewidget.h"
-#include <MltFilter.h>
 
 class AudioMeterWidget;
+struct AudioAnalysis;
 
 class AudioSpectrumScopeWidget Q_DECL_FINAL : public ScopeWidget
 {
@@ -37,10 +37,7 @@ public:
 private:
     // Functions run in scope thread.
     void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
-    void processSpectrum();
-
-    // Members accessed by scope thread.
-    Mlt::Filter* m_filter;
+    void processSpectrum(const AudioAnalysis& analysis);
 
     // Members accessed only in the GUI thread
     AudioMeterWidget* m_audioMeter;
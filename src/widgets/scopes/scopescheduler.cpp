@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scopescheduler.h"
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+
+namespace {
+
+class Stripe
+{
+public:
+    Stripe() : kernel(0), index(0), begin(0), end(0) {}
+    Stripe(ScopeStripeKernel* k, int i, int b, int e) : kernel(k), index(i), begin(b), end(e) {}
+
+    void process()
+    {
+        kernel->processStripe(index, begin, end);
+    }
+
+    ScopeStripeKernel* kernel;
+    int index;
+    int begin;
+    int end;
+};
+
+}
+
+int ScopeScheduler::stripeCount(int length, int minLength)
+{
+    int threads = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+    return qBound(1, length / qMax(1, minLength), threads);
+}
+
+void ScopeScheduler::run(ScopeStripeKernel* kernel, int length, int stripes)
+{
+    if (length <= 0)
+        return;
+    stripes = qBound(1, stripes, length);
+    if (stripes == 1) {
+        kernel->processStripe(0, 0, length);
+        return;
+    }
+
+    QVector<Stripe> work;
+    work.reserve(stripes);
+    for (int i = 0; i < stripes; i++) {
+        int begin = length * i / stripes;
+        int end = length * (i + 1) / stripes;
+        work << Stripe(kernel, i, begin, end);
+    }
+    QtConcurrent::blockingMap(work, &Stripe::process);
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCOPESCHEDULER_H
+#define SCOPESCHEDULER_H
+
+#include <QVector>
+
+/*!
+  \class ScopeStripeKernel
+  \brief The ScopeStripeKernel is implemented by scopes whose per-frame work
+  can be split into independent stripes.
+
+  processStripe() is called concurrently for different stripes. An
+  implementation must only write to state that belongs to the given stripe
+  \a index (e.g. a partial histogram) or to memory that no other stripe
+  touches (e.g. its own range of waveform columns).
+*/
+
+class ScopeStripeKernel
+{
+public:
+    virtual ~ScopeStripeKernel() {}
+    virtual void processStripe(int index, int begin, int end) = 0;
+};
+
+/*!
+  \class ScopeScheduler
+  \brief The ScopeScheduler runs a ScopeStripeKernel over a frame in parallel.
+
+  The range [0, length) (lines or columns, as chosen by the scope) is split
+  into stripes that are processed on the global QThreadPool. The calling
+  thread, which is normally a scope refresh thread that already belongs to the
+  pool, processes stripes as well, so run() can not starve the pool.
+*/
+
+class ScopeScheduler
+{
+public:
+    /*!
+      Returns the number of stripes to use for \a length lines or columns so
+      that no stripe is shorter than \a minLength.
+    */
+    static int stripeCount(int length, int minLength = 64);
+
+    /*!
+      Splits [0, \a length) into \a stripes stripes and calls
+      \a kernel->processStripe() for each of them. Blocks until all stripes
+      have been processed.
+    */
+    static void run(ScopeStripeKernel* kernel, int length, int stripes);
+};
+
+#endif // SCOPESCHEDULER_H
@@ -22,7 +22,7 @@
 
 ScopeWidget::ScopeWidget(const QString& name)
   : QWidget()
-  , m_queue(3, DataQueue<SharedFrame>::OverflowModeDiscardOldest)
+  , m_queue(3, DataRingBuffer<SharedFrame>::OverflowModeDiscardOldest)
   , m_future()
   , m_refreshPending(false)
   , m_mutex(QMutex::NonRecursive)
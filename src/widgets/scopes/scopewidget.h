@@ -26,7 +26,7 @@
 #include <QFuture>
 #include <QMutex>
 #include "sharedframe.h"
-#include "dataqueue.h"
+#include "dataringbuffer.h"
 
 /*!
   \class ScopeWidget
@@ -38,8 +38,10 @@
   is the ability to trigger the "heavy lifting" to be done in a worker thread.
 
   Frames are received by the onNewFrame() slot. The ScopeWidget automatically
-  places new frames in the DataQueue (m_queue). Subclasses shall implement the
-  refreshScope() function and can check for new frames in m_queue.
+  places new frames in the DataRingBuffer (m_queue). Subclasses shall implement
+  the refreshScope() function and can check for new frames in m_queue with
+  tryPop() or drainLatest(). The GUI thread is the only producer and the
+  refresh thread is the only consumer, so no lock is taken on this path.
 
   refreshScope() is run from a separate thread. Therefore, any members that are
   accessed by both the worker thread (refreshScope) and the GUI thread
@@ -109,7 +111,7 @@ protected:
       Subclasses should check this queue for new frames in the refreshScope()
       implementation.
     */
-    DataQueue<SharedFrame> m_queue;
+    DataRingBuffer<SharedFrame> m_queue;
 
     void resizeEvent(QResizeEvent*) Q_DECL_OVERRIDE;
     void changeEvent(QEvent*) Q_DECL_OVERRIDE;
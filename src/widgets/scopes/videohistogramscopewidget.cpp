@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "videohistogramscopewidget.h"
+#include <Logger.h>
+#include <QPainter>
+
+VideoHistogramScopeWidget::VideoHistogramScopeWidget()
+  : ScopeWidget("VideoHistogram")
+  , m_frame()
+  , m_luma()
+  , m_rgb()
+  , m_yHistogram()
+  , m_rHistogram()
+  , m_gHistogram()
+  , m_bHistogram()
+  , m_stripes()
+  , m_partials(0)
+  , m_renderImg()
+  , m_mutex(QMutex::NonRecursive)
+  , m_displayImg()
+{
+    LOG_DEBUG() << "begin";
+    setMinimumSize(100, 100);
+    LOG_DEBUG() << "end";
+}
+
+void VideoHistogramScopeWidget::refreshScope(const QSize& size, bool full)
+{
+    if (!m_queue.drainLatest(m_frame) && !full) {
+        return;
+    }
+
+    m_rgb = RgbLineConverter(m_frame);
+    m_luma = m_frame.get_plane(SharedFramePlane::PlaneY);
+    if (!m_rgb.is_valid()) {
+        return;
+    }
+
+    // Count horizontal stripes in parallel and merge the partial histograms.
+    int stripes = ScopeScheduler::stripeCount(m_rgb.height());
+    m_stripes.resize(stripes * 4);
+    m_partials = m_stripes.data();
+    ScopeScheduler::run(this, m_rgb.height(), stripes);
+    m_yHistogram.reset();
+    m_rHistogram.reset();
+    m_gHistogram.reset();
+    m_bHistogram.reset();
+    for (int i = 0; i < stripes; i++) {
+        m_yHistogram.merge(m_stripes[i * 4 + 0]);
+        m_rHistogram.merge(m_stripes[i * 4 + 1]);
+        m_gHistogram.merge(m_stripes[i * 4 + 2]);
+        m_bHistogram.merge(m_stripes[i * 4 + 3]);
+    }
+
+    if (m_renderImg.size() != size) {
+        m_renderImg = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    }
+    m_renderImg.fill(Qt::transparent);
+
+    QPainter p(&m_renderImg);
+    int bandHeight = size.height() / 4;
+    QRect band(0, 0, size.width(), bandHeight);
+    drawHistogram(p, m_yHistogram, band, Qt::white, tr("Luma"));
+    drawHistogram(p, m_rHistogram, band.translated(0, bandHeight), Qt::red, tr("Red"));
+    drawHistogram(p, m_gHistogram, band.translated(0, bandHeight * 2), Qt::green, tr("Green"));
+    drawHistogram(p, m_bHistogram, band.translated(0, bandHeight * 3), Qt::blue, tr("Blue"));
+    p.end();
+
+    m_mutex.lock();
+    m_displayImg.swap(m_renderImg);
+    m_mutex.unlock();
+}
+
+void VideoHistogramScopeWidget::processStripe(int index, int begin, int end)
+{
+    HistogramAccumulator* partial = m_partials + index * 4;
+    for (int i = 0; i < 4; i++)
+        partial[i].reset();
+    partial[0].addPlane(m_luma, begin, end);
+    RgbLineConverter rgb(m_rgb);
+    for (int y = begin; y < end; y++) {
+        rgb.convert(y);
+        partial[1].addLine(rgb.red(), 1, rgb.width());
+        partial[2].addLine(rgb.green(), 1, rgb.width());
+        partial[3].addLine(rgb.blue(), 1, rgb.width());
+    }
+}
+
+void VideoHistogramScopeWidget::drawHistogram(QPainter& p, const HistogramAccumulator& histogram,
+                                              const QRect& rect, const QColor& color, const QString& label)
+{
+    qreal peak = qMax<quint32>(1, histogram.peak());
+    qreal binWidth = qreal(rect.width()) / 256.0;
+    int bottom = rect.bottom();
+
+    QPainterPath path;
+    path.moveTo(rect.left(), bottom);
+    for (int i = 0; i < 256; i++) {
+        qreal y = bottom - histogram.bin(i) * (rect.height() - 1) / peak;
+        path.lineTo(rect.left() + i * binWidth, y);
+        path.lineTo(rect.left() + (i + 1) * binWidth, y);
+    }
+    path.lineTo(rect.right(), bottom);
+    path.closeSubpath();
+
+    QColor fill(color);
+    fill.setAlpha(180);
+    p.fillPath(path, fill);
+    p.setPen(palette().text().color());
+    p.drawText(rect.adjusted(4, 2, 0, 0), Qt::AlignLeft | Qt::AlignTop, label);
+}
+
+void VideoHistogramScopeWidget::paintEvent(QPaintEvent*)
+{
+    if (!isVisible())
+        return;
+
+    QPainter p(this);
+    p.fillRect(0, 0, width(), height(), QBrush(Qt::black, Qt::SolidPattern));
+    m_mutex.lock();
+    if (!m_displayImg.isNull()) {
+        p.drawImage(rect(), m_displayImg, m_displayImg.rect());
+    }
+    m_mutex.unlock();
+    p.end();
+}
+
+QString VideoHistogramScopeWidget::getTitle()
+{
+   return tr("Video Histogram");
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VIDEOHISTOGRAMSCOPEWIDGET_H
+#define VIDEOHISTOGRAMSCOPEWIDGET_H
+
+#include "scopewidget.h"
+#include "videoscopekernel.h"
+#include "scopescheduler.h"
+#include <QVector>
+#include <QMutex>
+#include <QImage>
+
+class VideoHistogramScopeWidget Q_DECL_FINAL : public ScopeWidget, private ScopeStripeKernel
+{
+    Q_OBJECT
+
+public:
+    explicit VideoHistogramScopeWidget();
+    QString getTitle() Q_DECL_OVERRIDE;
+
+private:
+    // Functions run in scope thread.
+    void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
+    void processStripe(int index, int begin, int end) Q_DECL_OVERRIDE;
+    void drawHistogram(QPainter& p, const HistogramAccumulator& histogram,
+                       const QRect& rect, const QColor& color, const QString& label);
+
+    // Functions run in GUI thread.
+    void paintEvent(QPaintEvent*) Q_DECL_OVERRIDE;
+
+    // Members accessed only in scope thread (no thread protection).
+    SharedFrame m_frame;
+    SharedFramePlane m_luma;
+    RgbLineConverter m_rgb;
+    HistogramAccumulator m_yHistogram;
+    HistogramAccumulator m_rHistogram;
+    HistogramAccumulator m_gHistogram;
+    HistogramAccumulator m_bHistogram;
+    // Partial histograms per stripe (Y, R, G, B for each stripe).
+    QVector<HistogramAccumulator> m_stripes;
+    HistogramAccumulator* m_partials;
+    QImage m_renderImg;
+
+    // Members accessed in multiple threads (mutex protected).
+    QMutex m_mutex;
+    QImage m_displayImg;
+};
+
+#endif // VIDEOHISTOGRAMSCOPEWIDGET_H
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "videorgbparadescopewidget.h"
+#include <Logger.h>
+#include <QPainter>
+
+VideoRgbParadeScopeWidget::VideoRgbParadeScopeWidget()
+  : ScopeWidget("RgbParade")
+  , m_frame()
+  , m_rgb()
+  , m_accumulator()
+  , m_renderImg()
+  , m_renderBits(0)
+  , m_mutex(QMutex::NonRecursive)
+  , m_displayImg()
+{
+    LOG_DEBUG() << "begin";
+    setMinimumSize(100, 100);
+    LOG_DEBUG() << "end";
+}
+
+void VideoRgbParadeScopeWidget::refreshScope(const QSize& size, bool full)
+{
+    Q_UNUSED(size)
+    if (!m_queue.drainLatest(m_frame) && !full) {
+        return;
+    }
+
+    m_rgb = RgbLineConverter(m_frame);
+    if (m_rgb.is_valid()) {
+        int columns = m_rgb.width();
+        m_accumulator.reset(columns * 3);
+        if (m_renderImg.width() != columns * 3) {
+            m_renderImg = QImage(columns * 3, 256, QImage::Format_ARGB32_Premultiplied);
+        }
+        // Each stripe converts and counts its own range of source columns, which
+        // maps to three disjoint ranges of parade columns.
+        m_renderBits = m_renderImg.bits();
+        ScopeScheduler::run(this, columns, ScopeScheduler::stripeCount(columns));
+
+        m_mutex.lock();
+        m_displayImg.swap(m_renderImg);
+        m_mutex.unlock();
+    }
+}
+
+void VideoRgbParadeScopeWidget::processStripe(int /*index*/, int begin, int end)
+{
+    RgbLineConverter rgb(m_rgb);
+    int columns = rgb.width();
+    int width = end - begin;
+    for (int y = 0; y < rgb.height(); y++) {
+        rgb.convert(y, begin, end);
+        m_accumulator.addLine(rgb.red() + begin, 1, width, begin);
+        m_accumulator.addLine(rgb.green() + begin, 1, width, columns + begin);
+        m_accumulator.addLine(rgb.blue() + begin, 1, width, columns * 2 + begin);
+    }
+    int bytesPerLine = m_renderImg.bytesPerLine();
+    m_accumulator.render(m_renderBits, bytesPerLine, qRgb(255, 0, 0), begin, end);
+    m_accumulator.render(m_renderBits, bytesPerLine, qRgb(0, 255, 0), columns + begin, columns + end);
+    m_accumulator.render(m_renderBits, bytesPerLine, qRgb(0, 0, 255), columns * 2 + begin, columns * 2 + end);
+}
+
+void VideoRgbParadeScopeWidget::paintEvent(QPaintEvent*)
+{
+    if (!isVisible())
+        return;
+
+    QPainter p(this);
+    p.fillRect(0, 0, width(), height(), QBrush(Qt::black, Qt::SolidPattern));
+    m_mutex.lock();
+    if (!m_displayImg.isNull()) {
+        p.drawImage(rect(), m_displayImg, m_displayImg.rect());
+    }
+    m_mutex.unlock();
+    p.end();
+}
+
+QString VideoRgbParadeScopeWidget::getTitle()
+{
+   return tr("RGB Parade");
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VIDEORGBPARADESCOPEWIDGET_H
+#define VIDEORGBPARADESCOPEWIDGET_H
+
+#include "scopewidget.h"
+#include "videoscopekernel.h"
+#include "scopescheduler.h"
+#include <QMutex>
+#include <QImage>
+
+class VideoRgbParadeScopeWidget Q_DECL_FINAL : public ScopeWidget, private ScopeStripeKernel
+{
+    Q_OBJECT
+
+public:
+    explicit VideoRgbParadeScopeWidget();
+    QString getTitle() Q_DECL_OVERRIDE;
+
+private:
+    // Functions run in scope thread.
+    void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
+    void processStripe(int index, int begin, int end) Q_DECL_OVERRIDE;
+
+    // Functions run in GUI thread.
+    void paintEvent(QPaintEvent*) Q_DECL_OVERRIDE;
+
+    // Members accessed only in scope thread (no thread protection).
+    SharedFrame m_frame;
+    RgbLineConverter m_rgb;
+    WaveformAccumulator m_accumulator;
+    QImage m_renderImg;
+    uchar* m_renderBits;
+
+    // Members accessed in multiple threads (mutex protected).
+    QMutex m_mutex;
+    QImage m_displayImg;
+};
+
+#endif // VIDEORGBPARADESCOPEWIDGET_H
@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "videoscopekernel.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCOPE_USE_SSE2
+#endif
+
+static inline uint8_t clampByte(int value)
+{
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+WaveformAccumulator::WaveformAccumulator()
+  : m_bins()
+  , m_width(0)
+{
+}
+
+void WaveformAccumulator::reset(int width)
+{
+    if (m_width != width) {
+        m_width = width;
+        m_bins.resize(256 * width);
+    }
+    m_bins.fill(0);
+}
+
+void WaveformAccumulator::addLine(const uint8_t* line, int step, int width, int xOffset)
+{
+    quint16* bins = m_bins.data() + xOffset;
+    const int stride = m_width;
+
+    if (step != 1) {
+        // Gather the samples into a contiguous chunk first so that the
+        // counting loop is the same for planar and packed formats. The chunk
+        // is on the stack so that several threads may fill disjoint columns.
+        uint8_t packed[256];
+        for (int chunk = 0; chunk < width; chunk += 256) {
+            const uint8_t* src = line + chunk * step;
+            int n = qMin(256, width - chunk);
+            int x = 0;
+#ifdef SCOPE_USE_SSE2
+            if (step == 2) {
+                const __m128i mask = _mm_set1_epi16(0x00ff);
+                for (; x + 16 <= n; x += 16) {
+                    __m128i a = _mm_loadu_si128((const __m128i*) (src + x * 2));
+                    __m128i b = _mm_loadu_si128((const __m128i*) (src + x * 2 + 16));
+                    a = _mm_and_si128(a, mask);
+                    b = _mm_and_si128(b, mask);
+                    _mm_storeu_si128((__m128i*) (packed + x), _mm_packus_epi16(a, b));
+                }
+            }
+#endif
+            for (; x < n; x++)
+                packed[x] = src[x * step];
+            addLine(packed, 1, n, xOffset + chunk);
+        }
+        return;
+    }
+
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        bins[line[x + 0] * stride + x + 0]++;
+        bins[line[x + 1] * stride + x + 1]++;
+        bins[line[x + 2] * stride + x + 2]++;
+        bins[line[x + 3] * stride + x + 3]++;
+    }
+    for (; x < width; x++)
+        bins[line[x] * stride + x]++;
+}
+
+void WaveformAccumulator::addPlane(const SharedFramePlane& plane, int firstLine, int lastLine, int xOffset)
+{
+    addColumns(plane, firstLine, lastLine, 0, plane.width(), xOffset);
+}
+
+void WaveformAccumulator::addColumns(const SharedFramePlane& plane, int firstLine, int lastLine,
+                                     int firstColumn, int lastColumn, int xOffset)
+{
+    if (!plane.is_valid())
+        return;
+    lastColumn = qMin(lastColumn, qMin(plane.width(), m_width - xOffset));
+    lastLine = qMin(lastLine, plane.height());
+    const int step = plane.step();
+    for (int y = firstLine; y < lastLine; y++)
+        addLine(plane.line(y) + firstColumn * step, step, lastColumn - firstColumn, xOffset + firstColumn);
+}
+
+void WaveformAccumulator::merge(const WaveformAccumulator& other)
+{
+    if (other.m_width != m_width)
+        return;
+    quint16* dst = m_bins.data();
+    const quint16* src = other.m_bins.constData();
+    int n = m_bins.size();
+    int i = 0;
+#ifdef SCOPE_USE_SSE2
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*) (dst + i));
+        __m128i b = _mm_loadu_si128((const __m128i*) (src + i));
+        _mm_storeu_si128((__m128i*) (dst + i), _mm_adds_epu16(a, b));
+    }
+#endif
+    for (; i < n; i++)
+        dst[i] = quint16(qMin(0xffff, int(dst[i]) + int(src[i])));
+}
+
+void WaveformAccumulator::render(QImage& image, QRgb color, int xBegin, int xEnd, int saturation) const
+{
+    render(image.bits(), image.bytesPerLine(), color, xBegin, xEnd, saturation);
+}
+
+void WaveformAccumulator::render(uchar* bits, int bytesPerLine, QRgb color, int xBegin, int xEnd, int saturation) const
+{
+    // Premultiplied color for each intensity.
+    QRgb lut[256];
+    for (int i = 0; i < 256; i++) {
+        lut[i] = qRgba(qRed(color) * i / 255, qGreen(color) * i / 255, qBlue(color) * i / 255, i);
+    }
+    saturation = qMax(1, saturation);
+    const int gain = 255 / saturation;
+    uint8_t intensity[16];
+
+    for (int level = 0; level < 256; level++) {
+        const quint16* bins = m_bins.constData() + level * m_width;
+        QRgb* out = (QRgb*) (bits + (255 - level) * bytesPerLine);
+        int x = xBegin;
+#ifdef SCOPE_USE_SSE2
+        const __m128i sat = _mm_set1_epi16(saturation);
+        const __m128i mul = _mm_set1_epi16(gain);
+        for (; x + 16 <= xEnd; x += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i*) (bins + x));
+            __m128i b = _mm_loadu_si128((const __m128i*) (bins + x + 8));
+            // min(count, saturation) without SSE4.1
+            a = _mm_sub_epi16(a, _mm_subs_epu16(a, sat));
+            b = _mm_sub_epi16(b, _mm_subs_epu16(b, sat));
+            a = _mm_mullo_epi16(a, mul);
+            b = _mm_mullo_epi16(b, mul);
+            _mm_storeu_si128((__m128i*) intensity, _mm_packus_epi16(a, b));
+            for (int i = 0; i < 16; i++)
+                out[x + i] = lut[intensity[i]];
+        }
+#endif
+        for (; x < xEnd; x++)
+            out[x] = lut[qMin(int(bins[x]), saturation) * gain];
+    }
+}
+
+HistogramAccumulator::HistogramAccumulator()
+{
+    reset();
+}
+
+void HistogramAccumulator::reset()
+{
+    memset(m_bins, 0, sizeof(m_bins));
+}
+
+void HistogramAccumulator::addLine(const uint8_t* line, int step, int width)
+{
+    // Four sets of counters avoid stalls when neighboring samples are equal.
+    quint32 bins[4][256];
+    memset(bins, 0, sizeof(bins));
+    int x = 0;
+    if (step == 1) {
+        for (; x + 4 <= width; x += 4) {
+            bins[0][line[x + 0]]++;
+            bins[1][line[x + 1]]++;
+            bins[2][line[x + 2]]++;
+            bins[3][line[x + 3]]++;
+        }
+    }
+    for (; x < width; x++)
+        bins[0][line[x * step]]++;
+    for (int i = 0; i < 256; i++)
+        m_bins[i] += bins[0][i] + bins[1][i] + bins[2][i] + bins[3][i];
+}
+
+void HistogramAccumulator::addPlane(const SharedFramePlane& plane, int firstLine, int lastLine)
+{
+    if (!plane.is_valid())
+        return;
+    lastLine = qMin(lastLine, plane.height());
+    for (int y = firstLine; y < lastLine; y++)
+        addLine(plane.line(y), plane.step(), plane.width());
+}
+
+void HistogramAccumulator::merge(const HistogramAccumulator& other)
+{
+    for (int i = 0; i < 256; i++)
+        m_bins[i] += other.m_bins[i];
+}
+
+quint32 HistogramAccumulator::peak() const
+{
+    quint32 result = 0;
+    for (int i = 0; i < 256; i++)
+        result = qMax(result, m_bins[i]);
+    return result;
+}
+
+RgbLineConverter::RgbLineConverter()
+  : m_y()
+  , m_u()
+  , m_v()
+  , m_r()
+  , m_g()
+  , m_b()
+  , m_crToR(409)
+  , m_cbToG(100)
+  , m_crToG(208)
+  , m_cbToB(516)
+{
+}
+
+RgbLineConverter::RgbLineConverter(const SharedFrame& frame)
+  : m_y(frame.get_plane(SharedFramePlane::PlaneY))
+  , m_u(frame.get_plane(SharedFramePlane::PlaneU))
+  , m_v(frame.get_plane(SharedFramePlane::PlaneV))
+  , m_r(m_y.width())
+  , m_g(m_y.width())
+  , m_b(m_y.width())
+{
+    // 8.8 fixed point coefficients for limited range Y'CbCr.
+    if (frame.get_int("colorspace") == 709) {
+        m_crToR = 459;
+        m_cbToG = 55;
+        m_crToG = 136;
+        m_cbToB = 541;
+    } else {
+        m_crToR = 409;
+        m_cbToG = 100;
+        m_crToG = 208;
+        m_cbToB = 516;
+    }
+}
+
+void RgbLineConverter::convert(int y)
+{
+    convert(y, 0, m_y.width());
+}
+
+void RgbLineConverter::convert(int y, int xBegin, int xEnd)
+{
+    const uint8_t* yLine = m_y.line(y);
+    int chromaLine = y * m_u.height() / m_y.height();
+    const uint8_t* uLine = m_u.line(chromaLine);
+    const uint8_t* vLine = m_v.line(chromaLine);
+    const int yStep = m_y.step();
+    const int cStep = m_u.step();
+    uint8_t* r = m_r.data();
+    uint8_t* g = m_g.data();
+    uint8_t* b = m_b.data();
+
+    for (int x = xBegin; x < xEnd; x++) {
+        int c = 298 * (yLine[x * yStep] - 16) + 128;
+        int d = uLine[(x >> 1) * cStep] - 128;
+        int e = vLine[(x >> 1) * cStep] - 128;
+        r[x] = clampByte((c + m_crToR * e) >> 8);
+        g[x] = clampByte((c - m_cbToG * d - m_crToG * e) >> 8);
+        b[x] = clampByte((c + m_cbToB * d) >> 8);
+    }
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VIDEOSCOPEKERNEL_H
+#define VIDEOSCOPEKERNEL_H
+
+#include "sharedframe.h"
+#include <QVector>
+#include <QImage>
+#include <stdint.h>
+
+/*!
+  \class WaveformAccumulator
+  \brief The WaveformAccumulator counts how often each 8-bit level occurs in
+  each column of an image.
+
+  The counts are stored as a 256 x width array of uint16, one row per level.
+  Lines are added in memory order (row-major) and the result is tone mapped
+  into a display image in a single pass by render(). The SSE2 code paths are
+  used when the compiler targets SSE2 and there is a scalar fallback for the
+  other architectures.
+
+  Columns can be offset when adding lines so that several components can be
+  laid out side by side (e.g. for a parade).
+*/
+
+class WaveformAccumulator
+{
+public:
+    WaveformAccumulator();
+
+    //! Resizes the accumulator to \a width columns and clears all counts.
+    void reset(int width);
+    int width() const { return m_width; }
+
+    //! Adds one line of \a width samples spaced \a step bytes apart.
+    void addLine(const uint8_t* line, int step, int width, int xOffset = 0);
+
+    //! Adds lines [\a firstLine, \a lastLine) of \a plane.
+    void addPlane(const SharedFramePlane& plane, int firstLine, int lastLine, int xOffset = 0);
+
+    /*!
+      Adds columns [\a firstColumn, \a lastColumn) of lines [\a firstLine,
+      \a lastLine) of \a plane. Calls that cover disjoint column ranges only
+      touch disjoint counts and may run concurrently.
+    */
+    void addColumns(const SharedFramePlane& plane, int firstLine, int lastLine,
+                    int firstColumn, int lastColumn, int xOffset = 0);
+
+    //! Adds the counts of \a other (which must have the same width).
+    void merge(const WaveformAccumulator& other);
+
+    /*!
+      Tone maps columns [\a xBegin, \a xEnd) into \a image, which must be
+      width() x 256 and Format_ARGB32_Premultiplied. Level 255 is drawn at the
+      top. A bin reaches full intensity in \a color after \a saturation hits.
+    */
+    void render(QImage& image, QRgb color, int xBegin, int xEnd, int saturation = 17) const;
+
+    /*!
+      Same as above but writes to the pixels at \a bits directly. Use this
+      overload when several threads render disjoint column ranges of the same
+      image since QImage::scanLine() is not safe to call concurrently.
+    */
+    void render(uchar* bits, int bytesPerLine, QRgb color, int xBegin, int xEnd, int saturation = 17) const;
+
+private:
+    QVector<quint16> m_bins;
+    int m_width;
+};
+
+/*!
+  \class HistogramAccumulator
+  \brief The HistogramAccumulator counts how often each 8-bit level occurs.
+*/
+
+class HistogramAccumulator
+{
+public:
+    HistogramAccumulator();
+
+    void reset();
+    void addLine(const uint8_t* line, int step, int width);
+    void addPlane(const SharedFramePlane& plane, int firstLine, int lastLine);
+    void merge(const HistogramAccumulator& other);
+
+    quint32 bin(int level) const { return m_bins[level]; }
+    quint32 peak() const;
+
+private:
+    quint32 m_bins[256];
+};
+
+/*!
+  \class RgbLineConverter
+  \brief The RgbLineConverter converts lines of a yuv420p or yuv422 frame
+  into separate 8-bit R, G and B lines.
+
+  Chroma is taken from the nearest sample (no interpolation) which is
+  sufficient for scopes.
+
+  A converter only reads the frame when it is constructed. Copies of it can
+  therefore be used from several threads, each converting its own lines or
+  columns into its own line buffers.
+*/
+
+class RgbLineConverter
+{
+public:
+    RgbLineConverter();
+    explicit RgbLineConverter(const SharedFrame& frame);
+
+    bool is_valid() const { return m_y.is_valid() && m_u.is_valid() && m_v.is_valid(); }
+    int width() const { return m_y.width(); }
+    int height() const { return m_y.height(); }
+
+    //! Converts line \a y; the returned pointers are valid until the next call.
+    void convert(int y);
+
+    //! Converts only columns [\a xBegin, \a xEnd) of line \a y.
+    void convert(int y, int xBegin, int xEnd);
+    const uint8_t* red() const { return m_r.constData(); }
+    const uint8_t* green() const { return m_g.constData(); }
+    const uint8_t* blue() const { return m_b.constData(); }
+
+private:
+    SharedFramePlane m_y;
+    SharedFramePlane m_u;
+    SharedFramePlane m_v;
+    QVector<uint8_t> m_r;
+    QVector<uint8_t> m_g;
+    QVector<uint8_t> m_b;
+    int m_crToR;
+    int m_cbToG;
+    int m_crToG;
+    int m_cbToB;
+};
+
+#endif // VIDEOSCOPEKERNEL_H
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2016 Meltytech, LLC
+ * Copyright (c) 2015-2017 Meltytech, LLC
  * Author: Brian Matherly <code@brianmatherly.com>
  *
  * This program is free software: you can redistribute it and/or modify
@@ -23,13 +23,14 @@
 VideoWaveformScopeWidget::VideoWaveformScopeWidget()
   : ScopeWidget("VideoZoom")
   , m_frame()
+  , m_accumulator()
+  , m_luma()
   , m_renderImg()
-  , m_refreshTime()
+  , m_renderBits(0)
   , m_mutex(QMutex::NonRecursive)
   , m_displayImg()
 {
     LOG_DEBUG() << "begin";
-    m_refreshTime.start();
     LOG_DEBUG() << "end";
 }
 
@@ -37,44 +38,33 @@ VideoWaveformScopeWidget::VideoWaveformScopeWidget()
 void VideoWaveformScopeWidget::refreshScope(const QSize& size, bool full)
 {
     Q_UNUSED(size)
-    while (m_queue.count() > 0) {
-        m_frame = m_queue.pop();
-    }
-
-    if (!full && m_refreshTime.elapsed() < 90) {
-        // Limit refreshes to 90ms unless there is a good reason.
+    if (!m_queue.drainLatest(m_frame) && !full) {
         return;
     }
 
-    if (m_frame.is_valid() && m_frame.get_image_width() && m_frame.get_image_height()) {
-        int columns = m_frame.get_image_width();
+    m_luma = m_frame.get_plane(SharedFramePlane::PlaneY);
+    if (m_luma.is_valid()) {
+        int columns = m_luma.width();
+        m_accumulator.reset(columns);
         if (m_renderImg.width() != columns) {
             m_renderImg = QImage(columns, 256, QImage::Format_ARGB32_Premultiplied);
         }
-        QColor bgColor( 0, 0, 0 ,0 );
-        m_renderImg.fill(bgColor);
-
-        const uint8_t* yData = m_frame.get_image();
+        // Each stripe owns a range of columns, so the stripes neither share
+        // counts nor pixels and nothing needs to be merged.
+        m_renderBits = m_renderImg.bits();
+        ScopeScheduler::run(this, columns, ScopeScheduler::stripeCount(columns));
+        m_luma = SharedFramePlane();
 
-        for (int x = 0; x < columns; x++) {
-            int pixels = m_frame.get_image_height();
-            for (int j = 0; j < pixels; j++) {
-                int y = 255 - (yData[j * columns + x]);
-                QRgb currentVal = m_renderImg.pixel(x,y);
-                if (currentVal < 0xffffffff) {
-                    currentVal += 0x0f0f0f0f;
-                    m_renderImg.setPixel(x, y, currentVal);
-                }
-
-            }
-        }
+        m_mutex.lock();
+        m_displayImg.swap(m_renderImg);
+        m_mutex.unlock();
     }
+}
 
-    m_mutex.lock();
-    m_displayImg.swap(m_renderImg);
-    m_mutex.unlock();
-
-    m_refreshTime.restart();
+void VideoWaveformScopeWidget::processStripe(int /*index*/, int begin, int end)
+{
+    m_accumulator.addColumns(m_luma, 0, m_luma.height(), begin, end);
+    m_accumulator.render(m_renderBits, m_renderImg.bytesPerLine(), qRgb(255, 255, 255), begin, end);
 }
 
 void VideoWaveformScopeWidget::paintEvent(QPaintEvent*)
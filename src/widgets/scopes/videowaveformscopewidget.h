@@ -20,11 +20,12 @@
 #define VIDEOWAVEFORMSCOPEWIDGET_H
 
 #include "scopewidget.h"
+#include "videoscopekernel.h"
+#include "scopescheduler.h"
 #include <QMutex>
 #include <QImage>
-#include <QTime>
 
-class VideoWaveformScopeWidget Q_DECL_FINAL : public ScopeWidget
+class VideoWaveformScopeWidget Q_DECL_FINAL : public ScopeWidget, private ScopeStripeKernel
 {
     Q_OBJECT
     
@@ -34,12 +35,14 @@ public:
 
 private:
     void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
+    void processStripe(int index, int begin, int end) Q_DECL_OVERRIDE;
     void paintEvent(QPaintEvent*) Q_DECL_OVERRIDE;
 
     SharedFrame m_frame;
-    QSize m_prevSize;
+    WaveformAccumulator m_accumulator;
+    SharedFramePlane m_luma;
     QImage m_renderImg;
-    QTime m_refreshTime;
+    uchar* m_renderBits;
 
     // Variables accessed from multiple threads (mutex protected)
     QMutex m_mutex;
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fakemeltedserver.h"
+#include <QHostAddress>
+
+FakeMeltedServer::FakeMeltedServer(QObject *parent)
+    : QTcpServer(parent)
+    , m_chunkSize(0)
+{
+    m_timer.setInterval(1);
+    connect(this, SIGNAL(newConnection()), this, SLOT(onNewConnection()));
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+bool FakeMeltedServer::start()
+{
+    return listen(QHostAddress::LocalHost, 0);
+}
+
+void FakeMeltedServer::setReply(const QByteArray& command, const QByteArray& reply)
+{
+    m_replies[command] = reply;
+}
+
+void FakeMeltedServer::pushStatus(const QByteArray& line)
+{
+    foreach (QTcpSocket* socket, m_statusSockets)
+        write(socket, line + "\r\n");
+}
+
+void FakeMeltedServer::onNewConnection()
+{
+    while (QTcpSocket* socket = nextPendingConnection()) {
+        connect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+        connect(socket, SIGNAL(disconnected()), this, SLOT(onDisconnected()));
+        write(socket, "100 VTR Ready\r\n");
+    }
+}
+
+void FakeMeltedServer::onReadyRead()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    QByteArray& input = m_input[socket];
+    input.append(socket->readAll());
+    int end;
+    while ((end = input.indexOf('\n')) >= 0) {
+        QByteArray command = input.left(end).trimmed();
+        input.remove(0, end + 1);
+        if (command.isEmpty())
+            continue;
+        m_commands.append(command);
+        if (command == "STATUS") {
+            m_statusSockets.append(socket);
+            emit statusSubscribed();
+        } else if (m_replies.contains(command)) {
+            write(socket, m_replies.value(command));
+        } else {
+            write(socket, "400 Unknown command\r\n");
+        }
+    }
+}
+
+void FakeMeltedServer::onDisconnected()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    m_input.remove(socket);
+    m_output.remove(socket);
+    m_statusSockets.removeAll(socket);
+    socket->deleteLater();
+}
+
+void FakeMeltedServer::write(QTcpSocket* socket, const QByteArray& data)
+{
+    if (m_chunkSize > 0) {
+        m_output[socket].append(data);
+        if (!m_timer.isActive())
+            m_timer.start();
+    } else {
+        socket->write(data);
+    }
+}
+
+void FakeMeltedServer::flush()
+{
+    bool more = false;
+    QHash<QTcpSocket*, QByteArray>::iterator i;
+    for (i = m_output.begin(); i != m_output.end(); ++i) {
+        if (i.value().isEmpty())
+            continue;
+        i.key()->write(i.value().left(m_chunkSize));
+        i.key()->flush();
+        i.value().remove(0, m_chunkSize);
+        more = more || !i.value().isEmpty();
+    }
+    if (!more)
+        m_timer.stop();
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKEMELTEDSERVER_H
+#define FAKEMELTEDSERVER_H
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHash>
+#include <QList>
+#include <QTimer>
+
+/*!
+  \class FakeMeltedServer
+  \brief The FakeMeltedServer answers MVCP commands with scripted replies.
+
+  It listens on a free port of the loopback interface and greets every
+  connection like melted does. Each command line is answered in order with
+  the reply set for it, or a 400 if there is none. A connection that sends
+  STATUS becomes a status stream that receives pushStatus() lines.
+
+  With a chunk size set, outgoing data is written that many bytes at a time
+  from a timer so that the client sees responses split across reads.
+*/
+
+class FakeMeltedServer : public QTcpServer
+{
+    Q_OBJECT
+public:
+    explicit FakeMeltedServer(QObject *parent = 0);
+
+    bool start();
+    void setReply(const QByteArray& command, const QByteArray& reply);
+    void setChunkSize(int size) { m_chunkSize = size; }
+    void pushStatus(const QByteArray& line);
+
+    //! Returns the commands received so far, in order, without terminators.
+    QList<QByteArray> commands() const { return m_commands; }
+    int statusCount() const { return m_statusSockets.size(); }
+
+signals:
+    void statusSubscribed();
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onDisconnected();
+    void flush();
+
+private:
+    void write(QTcpSocket* socket, const QByteArray& data);
+
+    QHash<QByteArray, QByteArray> m_replies;
+    QHash<QTcpSocket*, QByteArray> m_input;
+    QHash<QTcpSocket*, QByteArray> m_output;
+    QList<QTcpSocket*> m_statusSockets;
+    QList<QByteArray> m_commands;
+    int m_chunkSize;
+    QTimer m_timer;
+};
+
+#endif // FAKEMELTEDSERVER_H
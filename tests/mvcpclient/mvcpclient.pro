@@ -0,0 +1,31 @@
+CONFIG   += link_prl
+CONFIG   += testcase console
+CONFIG   -= app_bundle
+
+QT       += network testlib
+QT       -= gui
+
+TARGET = tst_mvcpclient
+TEMPLATE = app
+
+SOURCES += \
+    tst_mvcpclient.cpp \
+    fakemeltedserver.cpp \
+    ../../src/mvcp/mvcpclient.cpp
+
+HEADERS += \
+    fakemeltedserver.h \
+    ../../src/mvcp/mvcpclient.h
+
+INCLUDEPATH = ../../src/mvcp ../../CuteLogger/include ../../mvcp
+
+debug_and_release {
+    build_pass:CONFIG(debug, debug|release) {
+        LIBS += -L../../CuteLogger/debug -L../../mvcp/debug
+    } else {
+        LIBS += -L../../CuteLogger/release -L../../mvcp/release
+    }
+} else {
+    LIBS += -L../../CuteLogger -L../../mvcp
+}
+LIBS += -lCuteLogger -lmvcp -lpthread
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2017 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include "mvcpclient.h"
+#include "fakemeltedserver.h"
+
+class ResponseRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    QList<MvcpResponse> responses;
+
+public slots:
+    void onResponse(const MvcpResponse& response)
+    {
+        responses.append(response);
+    }
+};
+
+class TestMvcpClient : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void connectsWithGreeting();
+    void pipelinedResponsesKeepOrder();
+    void responseTermination_data();
+    void responseTermination();
+    void partialReads();
+    void statusStream_data();
+    void statusStream();
+
+private:
+    void connectClient();
+
+    FakeMeltedServer* m_server;
+    MvcpClient* m_client;
+};
+
+void TestMvcpClient::init()
+{
+    m_server = new FakeMeltedServer;
+    QVERIFY(m_server->start());
+    m_server->setReply("PING", "200 OK\r\n");
+    m_client = new MvcpClient;
+}
+
+void TestMvcpClient::cleanup()
+{
+    delete m_client;
+    delete m_server;
+}
+
+void TestMvcpClient::connectClient()
+{
+    m_client->connectToServer("127.0.0.1", m_server->serverPort());
+    QTRY_VERIFY(m_client->isConnected());
+}
+
+void TestMvcpClient::connectsWithGreeting()
+{
+    QSignalSpy spy(m_client, SIGNAL(connected(QString)));
+    connectClient();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toString(), QString("100 VTR Ready"));
+    QCOMPARE(m_client->pendingCount(), 0);
+}
+
+void TestMvcpClient::pipelinedResponsesKeepOrder()
+{
+    m_server->setReply("CLS \"/\"", "201 OK\r\n\"a/\"\r\n\"b.mp4\" 1024\r\n\r\n");
+    m_server->setReply("USTA U0", "202 OK\r\n0 stopped \"b.mp4\" 0 1000 25.00 0 999 1000 0 0 0 0\r\n");
+    ResponseRecorder recorder;
+
+    // Everything is written before the greeting arrives.
+    m_client->connectToServer("127.0.0.1", m_server->serverPort());
+    m_client->send("CLS \"/\"", &recorder, "onResponse", 1);
+    m_client->send("BOGUS", &recorder, "onResponse", 2);
+    m_client->send("USTA U0", &recorder, "onResponse", 3);
+    m_client->send("PING", &recorder, "onResponse", 4);
+    QCOMPARE(m_client->pendingCount(), 4);
+
+    QTRY_COMPARE(recorder.responses.size(), 4);
+    QCOMPARE(m_client->pendingCount(), 0);
+    QCOMPARE(m_server->commands(), QList<QByteArray>()
+             << "CLS \"/\"" << "BOGUS" << "USTA U0" << "PING");
+    QCOMPARE(recorder.responses[0].tag(), 1);
+    QCOMPARE(recorder.responses[0].code(), 201);
+    QCOMPARE(recorder.responses[0].line(2), QByteArray("\"b.mp4\" 1024"));
+    QCOMPARE(recorder.responses[1].tag(), 2);
+    QCOMPARE(recorder.responses[1].code(), 400);
+    QVERIFY(!recorder.responses[1].isSuccess());
+    QCOMPARE(recorder.responses[2].tag(), 3);
+    QCOMPARE(recorder.responses[2].code(), 202);
+    QCOMPARE(recorder.responses[3].tag(), 4);
+    QCOMPARE(recorder.responses[3].code(), 200);
+}
+
+void TestMvcpClient::responseTermination_data()
+{
+    QTest::addColumn<QByteArray>("reply");
+    QTest::addColumn<int>("code");
+    QTest::addColumn<int>("count");
+    QTest::addColumn<QByteArray>("lastLine");
+
+    QTest::newRow("200 single line")
+        << QByteArray("200 OK\r\n") << 200 << 1 << QByteArray("200 OK");
+    QTest::newRow("201 ends at empty line")
+        << QByteArray("201 OK\r\nU0 00 \"a\"\r\nU1 00 \"b\"\r\n\r\n") << 201 << 4 << QByteArray();
+    QTest::newRow("201 without body")
+        << QByteArray("201 OK\r\n\r\n") << 201 << 2 << QByteArray();
+    QTest::newRow("201 with bare newlines")
+        << QByteArray("201 OK\nU0 00 \"a\"\n\n") << 201 << 3 << QByteArray();
+    QTest::newRow("202 ends at second line")
+        << QByteArray("202 OK\r\n0 playing \"a.mp4\"\r\n") << 202 << 2 << QByteArray("0 playing \"a.mp4\"");
+    QTest::newRow("500 ends at empty line")
+        << QByteArray("500 Server Error\r\nout of memory\r\n\r\n") << 500 << 3 << QByteArray();
+    QTest::newRow("403 single line")
+        << QByteArray("403 Unit not found\r\n") << 403 << 1 << QByteArray("403 Unit not found");
+}
+
+void TestMvcpClient::responseTermination()
+{
+    QFETCH(QByteArray, reply);
+    QFETCH(int, code);
+    QFETCH(int, count);
+    QFETCH(QByteArray, lastLine);
+    m_server->setReply("TEST", reply);
+    ResponseRecorder recorder;
+    connectClient();
+
+    // The following PING proves the response ended where it should.
+    m_client->send("TEST", &recorder, "onResponse", 1);
+    m_client->send("PING", &recorder, "onResponse", 2);
+    QTRY_COMPARE(recorder.responses.size(), 2);
+    QCOMPARE(recorder.responses[0].code(), code);
+    QCOMPARE(recorder.responses[0].count(), count);
+    QCOMPARE(recorder.responses[0].line(count - 1), lastLine);
+    QCOMPARE(recorder.responses[1].tag(), 2);
+    QCOMPARE(recorder.responses[1].code(), 200);
+    QCOMPARE(recorder.responses[1].count(), 1);
+}
+
+void TestMvcpClient::partialReads()
+{
+    m_server->setChunkSize(1);
+    m_server->setReply("ULS", "201 OK\r\nU0 00 \"a\" 1\r\nU1 00 \"b\" 1\r\n\r\n");
+    m_server->setReply("USTA U1", "202 OK\r\n1 paused \"b.mp4\"\r\n");
+    m_server->setReply("LOAD", "500 Server Error\r\nno such file\r\n\r\n");
+    QSignalSpy greeting(m_client, SIGNAL(connected(QString)));
+    ResponseRecorder recorder;
+
+    m_client->connectToServer("127.0.0.1", m_server->serverPort());
+    m_client->send("ULS", &recorder, "onResponse", 1);
+    m_client->send("USTA U1", &recorder, "onResponse", 2);
+    m_client->send("LOAD", &recorder, "onResponse", 3);
+    m_client->send("PING", &recorder, "onResponse", 4);
+
+    QTRY_COMPARE(recorder.responses.size(), 4);
+    QCOMPARE(greeting.count(), 1);
+    QCOMPARE(greeting.at(0).at(0).toString(), QString("100 VTR Ready"));
+    QCOMPARE(recorder.responses[0].code(), 201);
+    QCOMPARE(recorder.responses[0].count(), 4);
+    QCOMPARE(recorder.responses[0].line(1), QByteArray("U0 00 \"a\" 1"));
+    QCOMPARE(recorder.responses[0].line(2), QByteArray("U1 00 \"b\" 1"));
+    QCOMPARE(recorder.responses[1].code(), 202);
+    QCOMPARE(recorder.responses[1].line(1), QByteArray("1 paused \"b.mp4\""));
+    QCOMPARE(recorder.responses[2].code(), 500);
+    QCOMPARE(recorder.responses[2].line(1), QByteArray("no such file"));
+    QCOMPARE(recorder.responses[3].code(), 200);
+    QCOMPARE(m_client->pendingCount(), 0);
+}
+
+void TestMvcpClient::statusStream_data()
+{
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("whole lines") << 0;
+    QTest::newRow("split lines") << 3;
+}
+
+void TestMvcpClient::statusStream()
+{
+    QFETCH(int, chunkSize);
+    m_server->setChunkSize(chunkSize);
+    QSignalSpy spy(m_client, SIGNAL(statusReceived(QByteArray)));
+    ResponseRecorder recorder;
+    connectClient();
+
+    m_client->subscribeStatus();
+    QTRY_COMPARE(m_server->statusCount(), 1);
+    m_server->pushStatus("0 playing \"a.mp4\" 10 1000 25.00 0 999 1000 0 0 1 0");
+    m_server->pushStatus("1 stopped \"b.mp4\" 0 1000 25.00 0 999 1000 0 0 2 0");
+    QTRY_COMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(0).at(0).toByteArray(),
+             QByteArray("0 playing \"a.mp4\" 10 1000 25.00 0 999 1000 0 0 1 0"));
+    QCOMPARE(spy.at(1).at(0).toByteArray(),
+             QByteArray("1 stopped \"b.mp4\" 0 1000 25.00 0 999 1000 0 0 2 0"));
+
+    // Commands keep working on the other connection.
+    m_client->send("PING", &recorder, "onResponse", 1);
+    QTRY_COMPARE(recorder.responses.size(), 1);
+    QCOMPARE(recorder.responses[0].code(), 200);
+    QCOMPARE(spy.count(), 2);
+}
+
+QTEST_MAIN(TestMvcpClient)
+
+#include "tst_mvcpclient.moc"